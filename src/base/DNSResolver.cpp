@@ -0,0 +1,201 @@
+#include <condition_variable>
+#include "FPLog.h"
+#include "TimeUtil.h"
+#include "DNSResolver.h"
+
+using namespace fpnn;
+
+static std::mutex gc_DNSResolverCreateMutex;
+static std::atomic<bool> _created(false);
+static DNSResolverPtr _dnsResolver;
+
+DNSResolverPtr DNSResolver::instance()
+{
+	if (!_created)
+	{
+		std::unique_lock<std::mutex> lck(gc_DNSResolverCreateMutex);
+		if (!_created)
+		{
+			_dnsResolver.reset(new DNSResolver);
+			_created = true;
+		}
+	}
+	return _dnsResolver;
+}
+
+DNSResolver::DNSResolver(): _ttlSeconds(60), _failedTTLSeconds(5)
+{
+	//-- No resident thread. Lookups are rare, and most of them are cache hit.
+	_threadPool.init(0, 1, 2, 8);
+}
+
+DNSResolver::~DNSResolver()
+{
+	_threadPool.release();
+}
+
+void DNSResolver::setResolveFunction(ResolveFunction function)
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+	_resolveFunction = std::move(function);
+	_cache.clear();
+}
+
+void DNSResolver::clearCache()
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+	_cache.clear();
+}
+
+bool DNSResolver::lookupCache(const std::string& hostname, std::string& IPAddress, EndPointType& eType, bool& resolved)
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+	auto it = _cache.find(hostname);
+	if (it == _cache.end())
+		return false;
+
+	if (it->second.expiredMsec <= TimeUtil::steady_msec())
+	{
+		_cache.erase(it);
+		return false;
+	}
+
+	resolved = it->second.resolved;
+	if (resolved)
+	{
+		IPAddress = it->second.IPAddress;
+		eType = it->second.eType;
+	}
+	return true;
+}
+
+bool DNSResolver::resolve(const std::string& hostname, ResolvedCallback callback)
+{
+	std::string IPAddress;
+	EndPointType eType = ENDPOINT_TYPE_IP4;
+	bool resolved = false;
+
+	if (lookupCache(hostname, IPAddress, eType, resolved))
+	{
+		callback(resolved, IPAddress, eType);
+		return true;
+	}
+
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		auto it = _pendingCallbacks.find(hostname);
+		if (it != _pendingCallbacks.end())
+		{
+			it->second.push_back(std::move(callback));
+			return true;
+		}
+
+		_pendingCallbacks[hostname].push_back(std::move(callback));
+	}
+
+	if (_threadPool.wakeUp([this, hostname](){ resolveHost(hostname); }))
+		return true;
+
+	LOG_ERROR("Launch resolving task for %s failed.", hostname.c_str());
+
+	std::list<ResolvedCallback> callbacks;
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		auto it = _pendingCallbacks.find(hostname);
+		if (it != _pendingCallbacks.end())
+		{
+			callbacks.swap(it->second);
+			_pendingCallbacks.erase(it);
+		}
+	}
+
+	//-- The first one is the caller's, which won't be called as documented. Requests merged in the gap are failed.
+	if (callbacks.size())
+		callbacks.pop_front();
+
+	for (auto& cb: callbacks)
+		cb(false, IPAddress, eType);
+
+	return false;
+}
+
+void DNSResolver::resolveHost(const std::string& hostname)
+{
+	ResolveFunction function;
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		function = _resolveFunction;
+	}
+
+	CacheEntry entry;
+	entry.eType = ENDPOINT_TYPE_IP4;
+
+	if (function)
+		entry.resolved = function(hostname, entry.IPAddress, entry.eType);
+	else
+		entry.resolved = getIPAddress(hostname, entry.IPAddress, entry.eType);
+
+	if (!entry.resolved)
+		LOG_ERROR("Resolve host %s failed.", hostname.c_str());
+
+	entry.expiredMsec = TimeUtil::steady_msec() + (entry.resolved ? _ttlSeconds : _failedTTLSeconds) * 1000;
+
+	std::list<ResolvedCallback> callbacks;
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		_cache[hostname] = entry;
+
+		auto it = _pendingCallbacks.find(hostname);
+		if (it != _pendingCallbacks.end())
+		{
+			callbacks.swap(it->second);
+			_pendingCallbacks.erase(it);
+		}
+	}
+
+	for (auto& callback: callbacks)
+		callback(entry.resolved, entry.IPAddress, entry.eType);
+}
+
+bool DNSResolver::resolveSync(const std::string& hostname, std::string& IPAddress, EndPointType& eType)
+{
+	bool resolved = false;
+	if (lookupCache(hostname, IPAddress, eType, resolved))
+		return resolved;
+
+	struct SyncState
+	{
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool done;
+		bool resolved;
+		EndPointType eType;
+		std::string IPAddress;
+
+		SyncState(): done(false), resolved(false), eType(ENDPOINT_TYPE_IP4) {}
+	};
+	std::shared_ptr<SyncState> state = std::make_shared<SyncState>();
+
+	bool launched = resolve(hostname, [state](bool resolved, const std::string& IPAddress, EndPointType eType){
+		std::unique_lock<std::mutex> lck(state->mutex);
+		state->resolved = resolved;
+		state->IPAddress = IPAddress;
+		state->eType = eType;
+		state->done = true;
+		state->condition.notify_all();
+	});
+
+	if (!launched)
+		return false;
+
+	std::unique_lock<std::mutex> lck(state->mutex);
+	while (!state->done)
+		state->condition.wait(lck);
+
+	if (state->resolved)
+	{
+		IPAddress = state->IPAddress;
+		eType = state->eType;
+	}
+	return state->resolved;
+}
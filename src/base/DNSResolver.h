@@ -0,0 +1,87 @@
+#ifndef FPNN_DNS_Resolver_H
+#define FPNN_DNS_Resolver_H
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include "TaskThreadPool.h"
+#include "NetworkUtility.h"
+
+namespace fpnn
+{
+	class DNSResolver;
+	typedef std::shared_ptr<DNSResolver> DNSResolverPtr;
+
+	/*
+		Asynchronous host name resolver with a TTL cache.
+
+		*. Lookups are processed in the resolver's own thread pool, callers are never blocked.
+		*. Concurrent lookups for the same host name are merged into one.
+		*. Both successful and failed results are cached. getaddrinfo() doesn't report the record TTL,
+			so the TTLs are configured: 60 seconds for success, and 5 seconds for failure by default.
+		*. The resolve function is replaceable, for stub resolvers in tests, or custom resolvers.
+	*/
+	class DNSResolver
+	{
+	public:
+		//-- If resolved is false, IPAddress & eType are meaningless.
+		typedef std::function<void (bool resolved, const std::string& IPAddress, EndPointType eType)> ResolvedCallback;
+		typedef std::function<bool (const std::string& hostname, std::string& IPAddress, EndPointType& eType)> ResolveFunction;
+
+	private:
+		struct CacheEntry
+		{
+			bool resolved;
+			EndPointType eType;
+			std::string IPAddress;
+			int64_t expiredMsec;
+		};
+
+		std::mutex _mutex;
+		std::unordered_map<std::string, CacheEntry> _cache;
+		std::unordered_map<std::string, std::list<ResolvedCallback>> _pendingCallbacks;
+		ResolveFunction _resolveFunction;
+		TaskThreadPool _threadPool;
+		std::atomic<int> _ttlSeconds;
+		std::atomic<int> _failedTTLSeconds;
+
+		DNSResolver();
+		void resolveHost(const std::string& hostname);
+
+	public:
+		~DNSResolver();
+
+		static DNSResolverPtr instance();
+
+		void setTTL(int seconds) { _ttlSeconds = seconds; }
+		int getTTL() { return _ttlSeconds; }
+		void setFailedTTL(int seconds) { _failedTTLSeconds = seconds; }
+		int getFailedTTL() { return _failedTTLSeconds; }
+
+		//-- nullptr to restore the default resolve function: getIPAddress().
+		void setResolveFunction(ResolveFunction function);
+		void clearCache();
+
+		/*
+			Returns false if the host name isn't cached or the cache expired.
+			Else, resolved indicates the cached result is success or failed.
+		*/
+		bool lookupCache(const std::string& hostname, std::string& IPAddress, EndPointType& eType, bool& resolved);
+
+		/*
+			If the host name is cached, callback is called in current thread before returning.
+			Else, callback is called in the resolver thread when resolved.
+			Returns false only if the resolving task can't be launched, and callback won't be called.
+		*/
+		bool resolve(const std::string& hostname, ResolvedCallback callback);
+
+		//-- Cached, or waits for the result of resolver thread.
+		bool resolveSync(const std::string& hostname, std::string& IPAddress, EndPointType& eType);
+	};
+}
+
+#endif
@@ -12,6 +12,7 @@
 #include <functional>
 #include <condition_variable>
 #include "ITaskThreadPool.h"
+#include "ThreadCachedPool.h"
 #include "PoolInfo.h"
 
 namespace fpnn {
@@ -27,9 +28,12 @@ class TaskThreadPool: public ITaskThreadPool
 				std::function<void ()> _function;
 
 			public:
-				explicit FunctionTask(std::function<void ()> function): _function(function) {}
+				explicit FunctionTask(std::function<void ()> function): _function(std::move(function)) {}
 				virtual ~FunctionTask() {}
 
+				static void* operator new(size_t size) { return ThreadCachedPool::allocate(size); }
+				static void operator delete(void* p, size_t size) { ThreadCachedPool::deallocate(p, size); }
+
 				virtual void run()
 				{
 					_function();
@@ -0,0 +1,177 @@
+#include <new>
+#include <mutex>
+#include <vector>
+#include "ThreadCachedPool.h"
+
+using namespace fpnn;
+
+namespace
+{
+	enum
+	{
+		ClassShift = 6,
+		ClassCount = 4,
+		MaxPooledSize = ClassCount << ClassShift,
+		BatchSize = 64,
+		MaxThreadCached = BatchSize * 2,
+		MaxCentralBatches = 256,
+	};
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	struct Batch
+	{
+		FreeBlock* head;
+		int count;
+	};
+
+	struct CentralCache
+	{
+		std::mutex mutex[ClassCount];
+		std::vector<Batch> batches[ClassCount];
+	};
+
+	//-- Never destroyed: blocks may be released by threads exiting after static destruction.
+	CentralCache* centralCache()
+	{
+		static CentralCache* cache = new CentralCache();
+		return cache;
+	}
+
+	inline size_t classBlockSize(int index)
+	{
+		return (size_t)(index + 1) << ClassShift;
+	}
+
+	void freeBlocks(FreeBlock* head)
+	{
+		while (head)
+		{
+			FreeBlock* next = head->next;
+			::operator delete(head);
+			head = next;
+		}
+	}
+
+	void pushCentral(int index, FreeBlock* head, int count)
+	{
+		CentralCache* central = centralCache();
+		{
+			std::unique_lock<std::mutex> lck(central->mutex[index]);
+			if (central->batches[index].size() < MaxCentralBatches)
+			{
+				central->batches[index].push_back(Batch{head, count});
+				return;
+			}
+		}
+
+		freeBlocks(head);
+	}
+
+	bool popCentral(int index, Batch& batch)
+	{
+		CentralCache* central = centralCache();
+		std::unique_lock<std::mutex> lck(central->mutex[index]);
+		if (central->batches[index].empty())
+			return false;
+
+		batch = central->batches[index].back();
+		central->batches[index].pop_back();
+		return true;
+	}
+
+	struct ThreadCache
+	{
+		FreeBlock* lists[ClassCount];
+		int counts[ClassCount];
+
+		ThreadCache();
+		~ThreadCache();
+	};
+
+	thread_local bool gThreadCacheDestroyed = false;
+	thread_local ThreadCache gThreadCache;
+
+	ThreadCache::ThreadCache()
+	{
+		for (int i = 0; i < ClassCount; i++)
+		{
+			lists[i] = NULL;
+			counts[i] = 0;
+		}
+	}
+
+	ThreadCache::~ThreadCache()
+	{
+		gThreadCacheDestroyed = true;
+		for (int i = 0; i < ClassCount; i++)
+		{
+			if (lists[i])
+				pushCentral(i, lists[i], counts[i]);
+
+			lists[i] = NULL;
+			counts[i] = 0;
+		}
+	}
+}
+
+void* ThreadCachedPool::allocate(size_t size)
+{
+	if (size == 0 || size > MaxPooledSize || gThreadCacheDestroyed)
+		return ::operator new(size > MaxPooledSize ? size : MaxPooledSize);
+
+	int index = (int)((size - 1) >> ClassShift);
+	ThreadCache& cache = gThreadCache;
+
+	if (cache.lists[index] == NULL)
+	{
+		Batch batch;
+		if (popCentral(index, batch) == false)
+			return ::operator new(classBlockSize(index));
+
+		cache.lists[index] = batch.head;
+		cache.counts[index] = batch.count;
+	}
+
+	FreeBlock* block = cache.lists[index];
+	cache.lists[index] = block->next;
+	cache.counts[index] -= 1;
+	return block;
+}
+
+void ThreadCachedPool::deallocate(void* p, size_t size)
+{
+	if (p == NULL)
+		return;
+
+	if (size == 0 || size > MaxPooledSize || gThreadCacheDestroyed)
+	{
+		::operator delete(p);
+		return;
+	}
+
+	int index = (int)((size - 1) >> ClassShift);
+	ThreadCache& cache = gThreadCache;
+
+	FreeBlock* block = (FreeBlock*)p;
+	block->next = cache.lists[index];
+	cache.lists[index] = block;
+	cache.counts[index] += 1;
+
+	if (cache.counts[index] < MaxThreadCached)
+		return;
+
+	//-- Move the first BatchSize blocks into the central cache.
+	FreeBlock* tail = block;
+	for (int i = 1; i < BatchSize; i++)
+		tail = tail->next;
+
+	cache.lists[index] = tail->next;
+	cache.counts[index] -= BatchSize;
+
+	tail->next = NULL;
+	pushCentral(index, block, BatchSize);
+}
@@ -0,0 +1,34 @@
+#ifndef FPNN_Thread_Cached_Pool_H
+#define FPNN_Thread_Cached_Pool_H
+
+#include <stddef.h>
+
+namespace fpnn
+{
+	/*
+		Pooled storage for small objects which are allocated in one thread and released in another thread,
+		e.g. tasks & answer callbacks.
+
+		Objects are grouped into 64 bytes size classes, 256 bytes at most. Larger objects go to ::operator new.
+		Each thread caches free blocks for each size class. When a thread cache is too long, a batch of blocks
+		is moved into the central cache; when a thread cache is empty, a batch is taken from the central cache.
+		So the central lock is taken once for a batch, not for each object.
+
+		Usage: class-specific operator new & delete.
+
+			static void* operator new(size_t size) { return ThreadCachedPool::allocate(size); }
+			static void operator delete(void* p, size_t size) { ThreadCachedPool::deallocate(p, size); }
+
+		!!! IMPORTANT !!!
+		deallocate() MUST be called with the same size as allocate(). With the class-specific sized operator delete,
+		the class MUST have virtual destructor if it is deleted by the pointer of base class.
+	*/
+	class ThreadCachedPool
+	{
+	public:
+		static void* allocate(size_t size);
+		static void deallocate(void* p, size_t size);
+	};
+}
+
+#endif
@@ -23,6 +23,22 @@ int64_t TimeUtil::curr_msec()
     return (now.tv_sec * 1000 + now.tv_usec / 1000);
 }
 
+int64_t TimeUtil::curr_usec()
+{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+
+	return ((int64_t)now.tv_sec * 1000000 + now.tv_usec);
+}
+
+int64_t TimeUtil::steady_msec()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
 std::string TimeUtil::getDateStr(int64_t t, char sep){
 	char buff[32] = {0};
 	struct tm timeInfo;
@@ -33,6 +33,10 @@ namespace TimeUtil{
 
 	int64_t curr_sec();
 	int64_t curr_msec();
+	int64_t curr_usec();
+
+	//-- Monotonic clock, not affected by system time changing. Only for intervals & deadlines.
+	int64_t steady_msec();
 }
 }
 #endif
@@ -0,0 +1,506 @@
+#include "time.h"
+#include "WorkStealingThreadPool.h"
+using namespace fpnn;
+
+//-- The pool and the deque index of current thread. Index is -1 for temporary threads and non-pool threads.
+static thread_local const WorkStealingThreadPool* gCurrentPool = NULL;
+static thread_local int gCurrentWorkerIndex = -1;
+
+/*===============================================================================
+FUNCTION DEFINITIONS: Injection Queue
+=============================================================================== */
+WorkStealingThreadPool::InjectionQueue::InjectionQueue(): _enqueuePos(0), _dequeuePos(0)
+{
+	_cells = new Cell[Capacity];
+	for (size_t i = 0; i < Capacity; i++)
+		_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+WorkStealingThreadPool::InjectionQueue::~InjectionQueue()
+{
+	delete [] _cells;
+}
+
+bool WorkStealingThreadPool::InjectionQueue::push(TaskItem& task)
+{
+	size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+	while (true)
+	{
+		Cell* cell = &_cells[pos & Mask];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+		if (diff == 0)
+		{
+			if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				cell->task = std::move(task);
+				cell->sequence.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (diff < 0)
+			return false;		//-- Full.
+		else
+			pos = _enqueuePos.load(std::memory_order_relaxed);
+	}
+}
+
+bool WorkStealingThreadPool::InjectionQueue::pop(TaskItem& task)
+{
+	size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+	while (true)
+	{
+		Cell* cell = &_cells[pos & Mask];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+		if (diff == 0)
+		{
+			if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				task = std::move(cell->task);
+				cell->sequence.store(pos + Mask + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (diff < 0)
+			return false;		//-- Empty.
+		else
+			pos = _dequeuePos.load(std::memory_order_relaxed);
+	}
+}
+
+/*===============================================================================
+FUNCTION DEFINITIONS: Work Stealing Thread Pool
+=============================================================================== */
+void WorkStealingThreadPool::ReviseDataRelation()
+{
+	if (_maxCount > 0)
+	{
+		if(_maxCount < _initCount)
+			_maxCount = _initCount;
+
+		if (_perfectCount > _maxCount)
+			_perfectCount = _maxCount;
+	}
+
+	if (_perfectCount < _initCount)
+		_perfectCount = _initCount;
+}
+
+bool WorkStealingThreadPool::init(int32_t initCount, int32_t perAppendCount, int32_t perfectCount, int32_t maxCount, size_t maxQueueLength, size_t tempThreadLatencySeconds)
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+
+	if (_inited)
+		return true;
+
+	_initCount = initCount;
+	_maxCount = maxCount;
+	_appendCount = perAppendCount;
+	_perfectCount = perfectCount;
+
+	_maxQueueLength = maxQueueLength;
+	_tempThreadLatencySeconds = tempThreadLatencySeconds;
+
+	_tempThreadCount = 0;
+	_idleThreadCount = 0;
+	_normalThreadCount = 0;
+
+	_willExit = false;
+
+	ReviseDataRelation();
+
+	_workers.clear();
+	for (int32_t i = 0; i < _perfectCount; i++)
+		_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+	for (int32_t i = 0; i < _initCount; i++)
+	{
+		_threadList.push_back(std::thread(&WorkStealingThreadPool::process, this, (int)_normalThreadCount));
+		_normalThreadCount += 1;
+	}
+
+	_inited = true;
+
+	return true;
+}
+
+/*
+	Tasks from normal threads of this pool go into the deque of the submitting thread,
+	others go into the injection queue, or the overflow queue if the injection queue is full.
+	Once the overflow queue is used, tasks keep going into it until it is drained, for keeping FIFO order roughly.
+*/
+void WorkStealingThreadPool::pushTask(TaskItem& task)
+{
+	if (gCurrentPool == this && gCurrentWorkerIndex >= 0)
+	{
+		Worker* worker = _workers[gCurrentWorkerIndex].get();
+		std::unique_lock<std::mutex> lck(worker->mutex);
+		worker->tasks.push_back(std::move(task));
+		return;
+	}
+
+	if (_overflowCount == 0 && _injectionQueue.push(task))
+		return;
+
+	std::unique_lock<std::mutex> lck(_overflowMutex);
+	_overflowQueue.push(std::move(task));
+	_overflowCount++;
+}
+
+/*
+	If return false, task is kept.
+	_submittingCount is increased before checking _willExit, and release() sets _willExit before waiting _submittingCount
+	to be zero. So either the task is rejected, or release() waits until it is queued, and runs it if the threads are gone.
+*/
+bool WorkStealingThreadPool::submit(TaskItem& task)
+{
+	_submittingCount++;
+	if (!_inited || _willExit)
+	{
+		_submittingCount--;
+		return false;
+	}
+
+	int32_t pendingCount = _pendingTaskCount.fetch_add(1) + 1;
+	if (_maxQueueLength && (size_t)pendingCount > _maxQueueLength)
+	{
+		_pendingTaskCount--;
+		_submittingCount--;
+		return false;
+	}
+
+	pushTask(task);
+	_submittingCount--;
+
+	//-- Same as TaskThreadPool: append threads when busy threads + queued tasks > all threads.
+	if (pendingCount > _idleThreadCount && _appendCount
+		&& (_normalThreadCount < _perfectCount || _maxCount == 0 || _normalThreadCount + _tempThreadCount < _maxCount))
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		append();
+	}
+
+	unpark();
+	return true;
+}
+
+bool WorkStealingThreadPool::wakeUp(ITaskPtr task)
+{
+	if (!task)
+		return (_inited && !_willExit);
+
+	TaskItem item(std::move(task));
+	return submit(item);
+}
+
+bool WorkStealingThreadPool::wakeUp(ITask* task)
+{
+	if (task == NULL)
+		return (_inited && !_willExit);
+
+	TaskItem item(task);
+	if (submit(item))
+		return true;
+
+	item.detachOwnedTask();
+	return false;
+}
+
+bool WorkStealingThreadPool::wakeUp(std::function<void ()> task)
+{
+	FunctionTask* t = new FunctionTask(std::move(task));
+	if (wakeUp(t))
+		return true;
+
+	delete t;
+	return false;
+}
+
+//-- MUST be called under _mutex.
+bool WorkStealingThreadPool::append()
+{
+	if (_appendCount == 0 || _willExit)
+		return false;
+
+	if (_normalThreadCount >= _perfectCount)
+	{
+		if (_maxCount > 0)
+		{
+			if (_tempThreadCount + _normalThreadCount >= _maxCount)
+				return false;
+		}
+
+		_tempThreadCount += 1;
+		std::thread(&WorkStealingThreadPool::temporaryProcess, this).detach();
+
+		return true;
+	}
+	else
+	{
+		int32_t diff = _perfectCount - _normalThreadCount;
+		int32_t appendCount = (diff >= _appendCount) ? _appendCount : diff;
+
+		for (int32_t i = 0; i < appendCount; i++)
+		{
+			_threadList.push_back(std::thread(&WorkStealingThreadPool::process, this, (int)_normalThreadCount));
+			_normalThreadCount += 1;
+		}
+	}
+
+	return true;
+}
+
+/*
+	Fetching order: own deque (FIFO), injection queue, overflow queue, then steal from the tail of other deques.
+*/
+bool WorkStealingThreadPool::fetchTask(int workerIndex, TaskItem& task)
+{
+	if (workerIndex >= 0)
+	{
+		Worker* worker = _workers[workerIndex].get();
+		std::unique_lock<std::mutex> lck(worker->mutex);
+		if (!worker->tasks.empty())
+		{
+			task = std::move(worker->tasks.front());
+			worker->tasks.pop_front();
+		}
+	}
+
+	if (task.empty() && !_injectionQueue.pop(task) && _overflowCount > 0)
+	{
+		std::unique_lock<std::mutex> lck(_overflowMutex);
+		if (!_overflowQueue.empty())
+		{
+			task = std::move(_overflowQueue.front());
+			_overflowQueue.pop();
+			_overflowCount--;
+		}
+	}
+
+	if (task.empty())
+	{
+		size_t count = _workers.size();
+		size_t start = (size_t)(workerIndex + 1);
+		for (size_t i = 0; i < count && task.empty(); i++)
+		{
+			size_t victim = (start + i) % count;
+			if ((int)victim == workerIndex)
+				continue;
+
+			Worker* worker = _workers[victim].get();
+			std::unique_lock<std::mutex> lck(worker->mutex);
+			if (!worker->tasks.empty())
+			{
+				task = std::move(worker->tasks.back());
+				worker->tasks.pop_back();
+			}
+		}
+	}
+
+	if (task.empty())
+		return false;
+
+	_pendingTaskCount--;
+	return true;
+}
+
+/*
+	Parking & unparking:
+		Parker increases _idleThreadCount then checks _pendingTaskCount; submitter increases _pendingTaskCount then
+		checks _idleThreadCount. So either parker finds the task, or submitter finds the parker and notifies it
+		under _parkMutex. Exiting threads re-check _pendingTaskCount after decreasing _idleThreadCount, for the same reason.
+
+	Return false means the thread should exit.
+*/
+bool WorkStealingThreadPool::park(bool temporary, int64_t& restLatencySeconds)
+{
+	bool waited = false;
+	std::unique_lock<std::mutex> lck(_parkMutex);
+	_idleThreadCount++;
+
+	while (_pendingTaskCount <= 0)
+	{
+		if (_willExit || (temporary && restLatencySeconds <= 0))
+		{
+			_idleThreadCount--;
+			return (_pendingTaskCount > 0);
+		}
+
+		waited = true;
+		if (temporary)
+		{
+			int64_t latencyStartTime = time(NULL);
+			_parkCondition.wait_for(lck, std::chrono::seconds(restLatencySeconds));
+			restLatencySeconds -= time(NULL) - latencyStartTime;
+		}
+		else
+			_parkCondition.wait(lck);
+	}
+
+	_idleThreadCount--;
+	lck.unlock();
+
+	//-- Task is counted but not yet pushed, or is being taken by another thread.
+	if (!waited)
+		std::this_thread::yield();
+
+	return true;
+}
+
+void WorkStealingThreadPool::unpark()
+{
+	if (_idleThreadCount > 0)
+	{
+		std::unique_lock<std::mutex> lck(_parkMutex);
+		_parkCondition.notify_one();
+	}
+}
+
+void WorkStealingThreadPool::process(int workerIndex)
+{
+	gCurrentPool = this;
+	gCurrentWorkerIndex = workerIndex;
+
+	int64_t unused = 0;
+	while (true)
+	{
+		TaskItem task;
+		if (fetchTask(workerIndex, task) == false)
+		{
+			if (park(false, unused))
+				continue;
+
+			std::unique_lock<std::mutex> lck(_mutex);
+			_normalThreadCount -= 1;
+			break;
+		}
+
+		//---------- Running the task. -----------------------
+		task.run();
+	}
+
+	gCurrentPool = NULL;
+	gCurrentWorkerIndex = -1;
+}
+
+void WorkStealingThreadPool::temporaryProcess()
+{
+	gCurrentPool = this;
+	gCurrentWorkerIndex = -1;
+
+	int64_t restLatencySeconds = _tempThreadLatencySeconds;
+
+	while (true)
+	{
+		TaskItem task;
+		if (fetchTask(-1, task) == false)
+		{
+			if (park(true, restLatencySeconds))
+				continue;
+
+			gCurrentPool = NULL;
+
+			std::unique_lock<std::mutex> lck(_mutex);
+			_tempThreadCount -= 1;
+			_detachCondition.notify_one();
+			return;
+		}
+
+		restLatencySeconds = _tempThreadLatencySeconds;
+
+		//---------- Running the task. -----------------------
+		task.run();
+	}
+}
+
+void WorkStealingThreadPool::status(int32_t &normalThreadCount, int32_t &temporaryThreadCount, int32_t &busyThreadCount, int32_t &taskQueueSize, int32_t& min, int32_t& max, int32_t& maxQueue)
+{
+	if (_inited)
+	{
+		normalThreadCount = _normalThreadCount;
+		temporaryThreadCount = _tempThreadCount;
+		busyThreadCount = normalThreadCount + temporaryThreadCount - _idleThreadCount;
+		if (busyThreadCount < 0)
+			busyThreadCount = 0;
+
+		taskQueueSize = _pendingTaskCount;
+		if (taskQueueSize < 0)
+			taskQueueSize = 0;
+
+		min = _initCount;
+		max = _maxCount;
+		maxQueue = (int)_maxQueueLength;
+	}
+	else
+	{
+		normalThreadCount = 0;
+		temporaryThreadCount = 0;
+		busyThreadCount = 0;
+		taskQueueSize = 0;
+		min = 0;
+		max = 0;
+		maxQueue = 0;
+	}
+}
+
+std::string WorkStealingThreadPool::infos()
+{
+	int32_t min = 0, max = 0;
+	int32_t normalThreadCount = 0;
+	int32_t temporaryThreadCount = 0;
+	int32_t busyThreadCount = 0;
+	int32_t taskQueueSize = 0;
+	int32_t maxQueueLength = 0;
+
+	status(normalThreadCount, temporaryThreadCount, busyThreadCount, taskQueueSize, min, max, maxQueueLength);
+
+	return PoolInfo::threadPoolInfo(min, max, normalThreadCount, temporaryThreadCount, busyThreadCount, taskQueueSize,maxQueueLength);
+}
+
+/*
+	Same as TaskThreadPool: queued tasks are drained before threads exit.
+	Tasks accepted while the threads were exiting are run in the releasing thread after all threads exited.
+*/
+void WorkStealingThreadPool::release()
+{
+	if (!_inited)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		_willExit = true;
+	}
+
+	while (_submittingCount > 0)
+		std::this_thread::yield();
+
+	{
+		std::unique_lock<std::mutex> lck(_parkMutex);
+		_parkCondition.notify_all();
+	}
+
+	for (auto& th: _threadList)
+		th.join();
+
+	_threadList.clear();
+
+	{
+		std::unique_lock<std::mutex> lck (_mutex);
+		while (_tempThreadCount)
+			 _detachCondition.wait(lck);
+	}
+
+	while (true)
+	{
+		TaskItem task;
+		if (fetchTask(-1, task) == false)
+			break;
+
+		task.run();
+	}
+
+	_inited = false;
+}
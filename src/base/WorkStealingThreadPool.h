@@ -0,0 +1,214 @@
+#ifndef FPNN_Work_Stealing_Thread_Pool_H
+#define FPNN_Work_Stealing_Thread_Pool_H
+
+/*===============================================================================
+  INCLUDES AND VARIABLE DEFINITIONS
+=============================================================================== */
+#include <mutex>
+#include <queue>
+#include <deque>
+#include <list>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include "ITaskThreadPool.h"
+#include "TaskThreadPool.h"
+#include "PoolInfo.h"
+
+namespace fpnn {
+/*===============================================================================
+  CLASS & STRUCTURE DEFINITIONS
+=============================================================================== */
+/*
+	Work-stealing thread pool. Same interface, init() semantics and temporary threads as TaskThreadPool.
+
+	*. Each normal thread owns a task deque. Tasks submitted by the pool threads are pushed into the deque
+		of the submitting normal thread, and stolen by the other threads when they are idle.
+	*. Tasks submitted by the other threads are pushed into a lock-free bounded injection queue.
+		If the injection queue is full, tasks are pushed into an overflow queue guarded by a mutex.
+	*. Idle threads are parked. Submitters only take the parking mutex when some threads are parked.
+	*. Busy threads count is the count of non-parked threads. No shared lock is taken for running a task.
+	*. Owned tasks (wakeUp(ITask*)) are queued without shared_ptr, and FunctionTask uses ThreadCachedPool,
+		so submitting them does no heap allocation in common cases.
+*/
+class WorkStealingThreadPool: public ITaskThreadPool
+{
+	public:
+		typedef TaskThreadPool::FunctionTask FunctionTask;
+
+		/*
+			Queued task. Holds a shared task, or an owned task which is deleted after running.
+			Owned tasks are queued without any allocation.
+		*/
+		class TaskItem
+		{
+			ITaskPtr _sharedTask;
+			ITask* _ownedTask;
+
+		public:
+			TaskItem(): _ownedTask(NULL) {}
+			explicit TaskItem(ITaskPtr task): _sharedTask(std::move(task)), _ownedTask(NULL) {}
+			explicit TaskItem(ITask* task): _ownedTask(task) {}
+			TaskItem(TaskItem&& other): _sharedTask(std::move(other._sharedTask)), _ownedTask(other._ownedTask)
+			{
+				other._ownedTask = NULL;
+			}
+			TaskItem& operator = (TaskItem&& other)
+			{
+				if (this != &other)
+				{
+					reset();
+					_sharedTask = std::move(other._sharedTask);
+					_ownedTask = other._ownedTask;
+					other._ownedTask = NULL;
+				}
+				return *this;
+			}
+			TaskItem(const TaskItem&) = delete;
+			TaskItem& operator = (const TaskItem&) = delete;
+			~TaskItem() { reset(); }
+
+			inline bool empty() const { return _ownedTask == NULL && !_sharedTask; }
+			inline ITask* detachOwnedTask()
+			{
+				ITask* task = _ownedTask;
+				_ownedTask = NULL;
+				return task;
+			}
+			inline void reset()
+			{
+				_sharedTask.reset();
+				if (_ownedTask)
+				{
+					delete _ownedTask;
+					_ownedTask = NULL;
+				}
+			}
+			//-- Run & release the task. All exceptions are caught.
+			inline void run()
+			{
+				try{
+					if (_ownedTask)
+						_ownedTask->run();
+					else
+						_sharedTask->run();
+				} catch (...) {}
+
+				reset();
+			}
+		};
+
+	private:
+		//-- Vyukov's bounded MPMC queue.
+		class InjectionQueue
+		{
+			struct Cell
+			{
+				std::atomic<size_t>		sequence;
+				TaskItem				task;
+			};
+
+			enum
+			{
+				Capacity = 4096,
+				Mask = Capacity - 1,
+			};
+
+			Cell*					_cells;
+			std::atomic<size_t>		_enqueuePos;
+			std::atomic<size_t>		_dequeuePos;
+
+		public:
+			InjectionQueue();
+			~InjectionQueue();
+
+			bool push(TaskItem& task);		//-- If return true, task is moved into queue.
+			bool pop(TaskItem& task);
+		};
+
+		struct Worker
+		{
+			std::mutex				mutex;
+			std::deque<TaskItem>	tasks;
+		};
+
+		std::mutex _mutex;
+		std::condition_variable _detachCondition;
+
+		std::mutex _parkMutex;
+		std::condition_variable _parkCondition;
+
+		int32_t					_initCount;
+		int32_t					_appendCount;
+		int32_t					_perfectCount;
+		int32_t					_maxCount;
+		size_t					_maxQueueLength;
+		size_t					_tempThreadLatencySeconds;
+
+		std::atomic<int32_t>	_normalThreadCount;		//-- The number of normal work threads in pool.
+		std::atomic<int32_t>	_tempThreadCount;		//-- The number of temporary/overdraft work threads.
+		std::atomic<int32_t>	_idleThreadCount;		//-- The number of parked work threads.
+		std::atomic<int32_t>	_pendingTaskCount;		//-- Increased before task queued, decreased after task taken.
+
+		InjectionQueue			_injectionQueue;
+		std::mutex				_overflowMutex;
+		std::queue<TaskItem>	_overflowQueue;
+		std::atomic<int32_t>	_overflowCount;
+
+		std::vector<std::unique_ptr<Worker>>	_workers;	//-- One for each normal thread. Created in init().
+		std::list<std::thread>	_threadList;
+
+		std::atomic<bool>		_inited;
+		std::atomic<bool>		_willExit;
+		std::atomic<int32_t>	_submittingCount;		//-- Submitters between checking _willExit and task queued.
+
+		void					ReviseDataRelation();
+		bool					append();
+		bool					submit(TaskItem& task);
+		void					pushTask(TaskItem& task);
+		bool					fetchTask(int workerIndex, TaskItem& task);
+		bool					park(bool temporary, int64_t& restLatencySeconds);
+		void					unpark();
+		void					process(int workerIndex);
+		void					temporaryProcess();
+
+	public:
+		virtual bool			init(int32_t initCount, int32_t perAppendCount, int32_t perfectCount, int32_t maxCount, size_t maxQueueLength = 0, size_t tempThreadLatencySeconds = 60);
+		virtual bool			wakeUp(ITaskPtr task);
+		virtual bool			wakeUp(std::function<void ()> task);
+		/*
+			Submit an owned task without shared_ptr. The task will be deleted after running.
+			If return false, the caller keeps the ownership.
+		*/
+		bool					wakeUp(ITask* task);
+		virtual void			release();
+		virtual void			status(int32_t &normalThreadCount, int32_t &temporaryThreadCount, int32_t &busyThreadCount, int32_t &taskQueueSize, int32_t& min, int32_t& max, int32_t& maxQueue);
+		virtual std::string		infos();
+
+		virtual bool inited()
+		{
+			return _inited;
+		}
+
+		virtual bool exiting()
+		{
+			return _willExit;
+		}
+
+		WorkStealingThreadPool(): _initCount(0), _appendCount(0), _perfectCount(0), _maxCount(0), _maxQueueLength(0),
+			_tempThreadLatencySeconds(0), _normalThreadCount(0), _tempThreadCount(0), _idleThreadCount(0),
+			_pendingTaskCount(0), _overflowCount(0), _inited(false), _willExit(false), _submittingCount(0)
+		{
+		}
+
+		virtual ~WorkStealingThreadPool()
+		{
+			release();
+		}
+};
+typedef std::shared_ptr<WorkStealingThreadPool> WorkStealingThreadPoolPtr;
+}
+#endif
@@ -1168,7 +1168,7 @@ void rijndael_ofb_encrypt(const rijndael_context *ctx, const uint8_t *in, uint8_
 	*p_num = n;
 }
 
-void rijndael_cfb_encrypt(const rijndael_context *ctx, bool encrypt,
+static void portable_cfb_encrypt(const rijndael_context *ctx, bool encrypt,
 		const uint8_t *in, uint8_t *out, size_t len, uint8_t ivec[16], size_t *p_num)
 {
 	size_t n = *p_num;
@@ -1200,6 +1200,205 @@ void rijndael_cfb_encrypt(const rijndael_context *ctx, bool encrypt,
 	*p_num = n;
 }
 
+/*
+   AES-NI implementation of CFB-128, selected at runtime by CPUID.
+   The key schedule of rijndael_setup_encrypt() is the standard AES key schedule
+   stored in big-endian words, so it is used after byte-swapping each word.
+   CFB encryption is serial (each block depends on the previous cipher block),
+   CFB decryption processes 4 blocks in parallel to hide the AESENC latency.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+
+#include <cpuid.h>
+#include <wmmintrin.h>
+#include <tmmintrin.h>
+
+#define AESNI_TARGET	__attribute__((target("aes,ssse3")))
+
+static int gc_aesniAvailable = -1;
+static int gc_aesniEnabled = 1;
+
+static bool aesni_available(void)
+{
+	if (gc_aesniAvailable < 0)
+	{
+		unsigned int eax, ebx, ecx, edx;
+		int available = 0;
+
+		if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+			available = ((ecx & bit_AES) && (ecx & bit_SSSE3)) ? 1 : 0;
+
+		gc_aesniAvailable = available;
+	}
+	return gc_aesniAvailable == 1;
+}
+
+AESNI_TARGET static void aesni_load_keys(const rijndael_context *ctx, __m128i rk[15])
+{
+	const __m128i bswap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	int i;
+
+	for (i = 0; i <= ctx->nrounds; ++i)
+		rk[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(ctx->rk + 4 * i)), bswap);
+}
+
+AESNI_TARGET static inline __m128i aesni_encrypt_block(const __m128i rk[15], int nrounds, __m128i block)
+{
+	int i;
+
+	block = _mm_xor_si128(block, rk[0]);
+	for (i = 1; i < nrounds; ++i)
+		block = _mm_aesenc_si128(block, rk[i]);
+
+	return _mm_aesenclast_si128(block, rk[nrounds]);
+}
+
+AESNI_TARGET static void aesni_encrypt_4blocks(const __m128i rk[15], int nrounds,
+		__m128i *b0, __m128i *b1, __m128i *b2, __m128i *b3)
+{
+	__m128i s0 = _mm_xor_si128(*b0, rk[0]);
+	__m128i s1 = _mm_xor_si128(*b1, rk[0]);
+	__m128i s2 = _mm_xor_si128(*b2, rk[0]);
+	__m128i s3 = _mm_xor_si128(*b3, rk[0]);
+	int i;
+
+	for (i = 1; i < nrounds; ++i)
+	{
+		s0 = _mm_aesenc_si128(s0, rk[i]);
+		s1 = _mm_aesenc_si128(s1, rk[i]);
+		s2 = _mm_aesenc_si128(s2, rk[i]);
+		s3 = _mm_aesenc_si128(s3, rk[i]);
+	}
+
+	*b0 = _mm_aesenclast_si128(s0, rk[nrounds]);
+	*b1 = _mm_aesenclast_si128(s1, rk[nrounds]);
+	*b2 = _mm_aesenclast_si128(s2, rk[nrounds]);
+	*b3 = _mm_aesenclast_si128(s3, rk[nrounds]);
+}
+
+AESNI_TARGET static void aesni_cfb_encrypt(const rijndael_context *ctx, bool encrypt,
+		const uint8_t *in, uint8_t *out, size_t len, uint8_t ivec[16], size_t *p_num)
+{
+	__m128i rk[15];
+	__m128i iv;
+	size_t n = *p_num;
+	int nrounds = ctx->nrounds;
+
+	/* Finish the partial block left by the previous call. */
+	if (n)
+	{
+		while (n && len)
+		{
+			uint8_t c = *in++;
+			uint8_t p = c ^ ivec[n];
+			*out++ = p;
+			ivec[n] = encrypt ? p : c;
+			n = (n + 1) % 16;
+			len--;
+		}
+
+		if (len == 0)
+		{
+			*p_num = n;
+			return;
+		}
+	}
+
+	aesni_load_keys(ctx, rk);
+	iv = _mm_loadu_si128((const __m128i *)ivec);
+
+	if (encrypt)
+	{
+		for (; len >= 16; len -= 16, in += 16, out += 16)
+		{
+			iv = _mm_xor_si128(aesni_encrypt_block(rk, nrounds, iv), _mm_loadu_si128((const __m128i *)in));
+			_mm_storeu_si128((__m128i *)out, iv);
+		}
+	}
+	else
+	{
+		for (; len >= 64; len -= 64, in += 64, out += 64)
+		{
+			__m128i c0 = _mm_loadu_si128((const __m128i *)in);
+			__m128i c1 = _mm_loadu_si128((const __m128i *)(in + 16));
+			__m128i c2 = _mm_loadu_si128((const __m128i *)(in + 32));
+			__m128i c3 = _mm_loadu_si128((const __m128i *)(in + 48));
+			__m128i k0 = iv, k1 = c0, k2 = c1, k3 = c2;
+
+			aesni_encrypt_4blocks(rk, nrounds, &k0, &k1, &k2, &k3);
+
+			_mm_storeu_si128((__m128i *)out, _mm_xor_si128(k0, c0));
+			_mm_storeu_si128((__m128i *)(out + 16), _mm_xor_si128(k1, c1));
+			_mm_storeu_si128((__m128i *)(out + 32), _mm_xor_si128(k2, c2));
+			_mm_storeu_si128((__m128i *)(out + 48), _mm_xor_si128(k3, c3));
+			iv = c3;
+		}
+
+		for (; len >= 16; len -= 16, in += 16, out += 16)
+		{
+			__m128i c = _mm_loadu_si128((const __m128i *)in);
+			_mm_storeu_si128((__m128i *)out, _mm_xor_si128(aesni_encrypt_block(rk, nrounds, iv), c));
+			iv = c;
+		}
+	}
+
+	/* Keystream of the tail is kept in ivec, as the portable implementation does. */
+	if (len)
+		iv = aesni_encrypt_block(rk, nrounds, iv);
+
+	_mm_storeu_si128((__m128i *)ivec, iv);
+
+	while (len--)
+	{
+		uint8_t c = *in++;
+		uint8_t p = c ^ ivec[n];
+		*out++ = p;
+		ivec[n] = encrypt ? p : c;
+		n++;
+	}
+
+	*p_num = n;
+}
+
+bool rijndael_hardware_accelerated(void)
+{
+	return gc_aesniEnabled && aesni_available();
+}
+
+void rijndael_enable_hardware_acceleration(bool enable)
+{
+	gc_aesniEnabled = enable ? 1 : 0;
+}
+
+void rijndael_cfb_encrypt(const rijndael_context *ctx, bool encrypt,
+		const uint8_t *in, uint8_t *out, size_t len, uint8_t ivec[16], size_t *p_num)
+{
+	if (gc_aesniEnabled && aesni_available())
+		aesni_cfb_encrypt(ctx, encrypt, in, out, len, ivec, p_num);
+	else
+		portable_cfb_encrypt(ctx, encrypt, in, out, len, ivec, p_num);
+}
+
+#else
+
+bool rijndael_hardware_accelerated(void)
+{
+	return false;
+}
+
+void rijndael_enable_hardware_acceleration(bool enable)
+{
+	(void)enable;
+}
+
+void rijndael_cfb_encrypt(const rijndael_context *ctx, bool encrypt,
+		const uint8_t *in, uint8_t *out, size_t len, uint8_t ivec[16], size_t *p_num)
+{
+	portable_cfb_encrypt(ctx, encrypt, in, out, len, ivec, p_num);
+}
+
+#endif
+
 
 
 #ifdef TEST_RIJNDAEL
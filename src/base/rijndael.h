@@ -53,6 +53,16 @@ void rijndael_cbc_decrypt(const rijndael_context *ctx, const uint8_t *cipher, ui
 void rijndael_cfb_encrypt(const rijndael_context *ctx, bool encrypt, const uint8_t *in, uint8_t *out, size_t len, uint8_t ivec[16], size_t *p_num);
 
 
+/*
+   rijndael_cfb_encrypt() uses AES-NI when the CPU supports it, else the portable
+   table-based implementation. The results are identical.
+   rijndael_enable_hardware_acceleration(false) forces the portable implementation,
+   for benchmarks and tests. It is enabled by default.
+ */
+bool rijndael_hardware_accelerated(void);
+void rijndael_enable_hardware_acceleration(bool enable);
+
+
 /*
    The first argument 'ctx' should be set by rijndael_setup_encrypt().
    Encryption and decryption both use this function.
@@ -55,7 +55,7 @@ namespace fpnn
 					_concurrentSender->sendTCPData(_connectionInfo->socket, _connectionInfo->token, raw);
 				else
 				{
-					int64_t expiredMS = ClientEngine::instance()->getQuestTimeout() * 1000 + slack_real_msec();
+					int64_t expiredMS = ClientEngine::getQuestTimeoutMsec() + slack_real_msec();
 					_concurrentSender->sendUDPData(_connectionInfo->socket, _connectionInfo->token, raw, expiredMS, false);
 				}
 				_sent = true;
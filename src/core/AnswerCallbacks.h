@@ -7,12 +7,14 @@
 #include <unordered_map>
 #include <condition_variable>
 #include "ITaskThreadPool.h"
+#include "ThreadCachedPool.h"
 #include "FPMessage.h"
 #include "FPWriter.h"
 #include "FPReader.h"
 
 namespace fpnn
 {
+	class BasicConnection;
 	class BasicAnswerCallback;
 	typedef std::shared_ptr<BasicAnswerCallback> BasicAnswerCallbackPtr;
 
@@ -21,9 +23,22 @@ namespace fpnn
 	//=================================================================//
 	class BasicAnswerCallback: public ITaskThreadPool::ITask
 	{
+		friend class QuestTimeoutWheel;
+
 		int64_t _expiredTime;
 
+		//-- Hooks for QuestTimeoutWheel. Only accessed under the lock of ConnectionMap.
+		BasicAnswerCallback* _wheelPrev;
+		BasicAnswerCallback* _wheelNext;
+		BasicAnswerCallback** _wheelSlot;
+		BasicConnection* _wheelConnection;
+		uint32_t _wheelSeqNum;
+
+		bool _inlineCallback;
+
 	public:
+		BasicAnswerCallback(): _expiredTime(0), _wheelPrev(NULL), _wheelNext(NULL), _wheelSlot(NULL),
+			_wheelConnection(NULL), _wheelSeqNum(0), _inlineCallback(false) {}
 		virtual ~BasicAnswerCallback() {}
 		/** If error set, answer will be NULL. This is mean a fatal error occurred, connection will be colsed. */
 		virtual void fillResult(FPAnswerPtr answer, int errorCode) = 0;
@@ -31,21 +46,34 @@ namespace fpnn
 		
 		void updateExpiredTime(int64_t expiredTime) { _expiredTime = expiredTime; }
 		int64_t expiredTime() { return _expiredTime; }
+
+		/*
+			Inline callback: when the answer received, the callback will be run in the IO thread directly,
+			without the thread pool hop. Only for lightweight callbacks which never block.
+			Timeout & connection closed errors are still processed in the thread pool.
+		*/
+		void setInlineCallback(bool inlineCallback) { _inlineCallback = inlineCallback; }
+		bool inlineCallback() { return _inlineCallback; }
 	};
 
 	//=================================================================//
 	//- Synced Answer Callback:
 	//=================================================================//
+	/*
+		Each sync call waits on its own mutex & condition variable, so concurrent sync calls on the same
+		client or connection don't contend on any shared lock.
+	*/
 	class SyncedAnswerCallback: public BasicAnswerCallback
 	{
 		FPQuestPtr _quest;
-		std::mutex* _mutex;
+		std::mutex _mutex;
 		std::condition_variable _condition;
+		bool _ready;
 		FPAnswerPtr _answer;
 
 	public:
-		SyncedAnswerCallback(std::mutex* mutex, FPQuestPtr quest):
-			_quest(quest), _mutex(mutex), _answer(nullptr) {}
+		explicit SyncedAnswerCallback(FPQuestPtr quest):
+			_quest(quest), _ready(false), _answer(nullptr) {}
 
 		virtual ~SyncedAnswerCallback() {}
 		virtual void run() final {}
@@ -54,19 +82,20 @@ namespace fpnn
 			if (!answer)
 				answer = FPAWriter::errorAnswer(_quest, errorCode, "no msg, please refer to log.:)");
 
-			std::unique_lock<std::mutex> lck(*_mutex);
+			std::unique_lock<std::mutex> lck(_mutex);
 			_answer = answer;
+			_ready = true;
 			_condition.notify_one();
 		}
 		virtual bool syncedCallback() { return true; }
 
 		FPAnswerPtr takeAnswer()
 		{
-			std::unique_lock<std::mutex> lck(*_mutex);
-  			while (!_answer)
-  				_condition.wait(lck);
-  			
-  			return _answer;
+			std::unique_lock<std::mutex> lck(_mutex);
+			while (!_ready)
+				_condition.wait(lck);
+
+			return _answer;
 		}
 	};
 
@@ -119,11 +148,14 @@ namespace fpnn
 
 	public:
 		explicit FunctionAnswerCallback(std::function<void (FPAnswerPtr answer, int errorCode)> function):
-			_errorCode(FPNN_EC_OK), _answer(0), _function(function) {}
+			_errorCode(FPNN_EC_OK), _answer(0), _function(std::move(function)) {}
 		virtual ~FunctionAnswerCallback()
 		{
 		}
 
+		static void* operator new(size_t size) { return ThreadCachedPool::allocate(size); }
+		static void operator delete(void* p, size_t size) { ThreadCachedPool::deallocate(p, size); }
+
   		virtual void run() final
   		{
   			_function(_answer, _errorCode);
@@ -0,0 +1,140 @@
+#ifndef FPNN_Client_Coroutine_H
+#define FPNN_Client_Coroutine_H
+
+/*
+	Optional C++20 coroutine interfaces for Client. Only available when compiled with C++20 coroutines support.
+	Nothing in the SDK includes this file, C++11 users are unaffected.
+
+	Usage:
+		QuestResult result = co_await asyncSendQuest(client, quest, timeout);
+		if (result.errorCode == FPNN_EC_OK) { ... result.answer ... }
+
+	Any coroutine type can co_await it. The coroutine will be resumed:
+		*. CoroutineResumeMode::CallbackPool: in the ClientEngine task thread pool. (Default)
+		*. CoroutineResumeMode::IOThread: in the IO thread when the answer received, as inline answer callbacks.
+			Timeout & connection closed errors are still resumed in the task thread pool.
+		*. CoroutineScheduler: the handle is passed to the scheduler, and the scheduler resumes it.
+			The scheduler is called in the thread which the CallbackPool mode uses.
+*/
+
+#if !(defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L)
+	#error "ClientCoroutine.h requires C++20 coroutines."
+#endif
+
+#include <coroutine>
+#include <functional>
+#include "ClientInterface.h"
+
+namespace fpnn
+{
+	struct QuestResult
+	{
+		FPAnswerPtr answer;			//-- May be nullptr when errorCode isn't FPNN_EC_OK.
+		int errorCode;
+
+		QuestResult(): answer(nullptr), errorCode(FPNN_EC_OK) {}
+	};
+
+	enum class CoroutineResumeMode
+	{
+		CallbackPool,
+		IOThread,
+	};
+
+	typedef std::function<void (std::coroutine_handle<> handle)> CoroutineScheduler;
+
+	class QuestAwaitable
+	{
+		class ResumeCallback: public AnswerCallback
+		{
+			QuestAwaitable* _awaitable;
+
+		public:
+			explicit ResumeCallback(QuestAwaitable* awaitable): _awaitable(awaitable) {}
+			virtual ~ResumeCallback() {}
+
+			virtual void onAnswer(FPAnswerPtr answer) { _awaitable->resume(answer, FPNN_EC_OK); }
+			virtual void onException(FPAnswerPtr answer, int errorCode) { _awaitable->resume(answer, errorCode); }
+		};
+
+		ClientPtr _client;
+		FPQuestPtr _quest;
+		int _timeout;
+		CoroutineResumeMode _mode;
+		CoroutineScheduler _scheduler;
+		std::coroutine_handle<> _handle;
+		QuestResult _result;
+
+		void resume(FPAnswerPtr answer, int errorCode)
+		{
+			_result.answer = answer;
+			_result.errorCode = errorCode;
+
+			//-- The awaitable will be destroyed after the coroutine resumed, so using locals.
+			std::coroutine_handle<> handle = _handle;
+			if (_scheduler)
+			{
+				CoroutineScheduler scheduler = std::move(_scheduler);
+				scheduler(handle);
+			}
+			else
+				handle.resume();
+		}
+
+	public:
+		QuestAwaitable(ClientPtr client, FPQuestPtr quest, int timeout, CoroutineResumeMode mode):
+			_client(std::move(client)), _quest(std::move(quest)), _timeout(timeout), _mode(mode) {}
+		QuestAwaitable(ClientPtr client, FPQuestPtr quest, int timeout, CoroutineScheduler scheduler):
+			_client(std::move(client)), _quest(std::move(quest)), _timeout(timeout),
+			_mode(CoroutineResumeMode::CallbackPool), _scheduler(std::move(scheduler)) {}
+
+		bool await_ready() const noexcept { return false; }
+
+		bool await_suspend(std::coroutine_handle<> handle)
+		{
+			ClientPtr client = _client;
+			if (!client || !_quest)
+			{
+				_result.errorCode = FPNN_EC_CORE_SEND_ERROR;
+				return false;
+			}
+
+			if (_quest->isOneWay())
+			{
+				if (client->sendQuest(_quest, (AnswerCallback*)NULL, _timeout) == false)
+					_result.errorCode = FPNN_EC_CORE_SEND_ERROR;
+
+				return false;
+			}
+
+			_handle = handle;
+			ResumeCallback* callback = new ResumeCallback(this);
+			if (_mode == CoroutineResumeMode::IOThread)
+				callback->setInlineCallback(true);
+
+			//-- If sent, the coroutine may be resumed before sendQuest() returned. Don't touch members after that.
+			if (client->sendQuest(_quest, callback, _timeout))
+				return true;
+
+			delete callback;
+			_result.errorCode = FPNN_EC_CORE_SEND_ERROR;
+			return false;
+		}
+
+		QuestResult await_resume() { return std::move(_result); }
+	};
+
+	//-- timeout in seconds. 0 means using the client quest timeout.
+	inline QuestAwaitable asyncSendQuest(ClientPtr client, FPQuestPtr quest, int timeout = 0,
+		CoroutineResumeMode mode = CoroutineResumeMode::CallbackPool)
+	{
+		return QuestAwaitable(std::move(client), std::move(quest), timeout, mode);
+	}
+
+	inline QuestAwaitable asyncSendQuest(ClientPtr client, FPQuestPtr quest, int timeout, CoroutineScheduler scheduler)
+	{
+		return QuestAwaitable(std::move(client), std::move(quest), timeout, std::move(scheduler));
+	}
+}
+
+#endif
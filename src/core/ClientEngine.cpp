@@ -1,4 +1,3 @@
-#include <sys/select.h>
 //#include <sys/sysinfo.h>
 //#include <sys/types.h>
 //#include <sys/stat.h>
@@ -6,6 +5,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <atomic>
+#include <algorithm>
 #include <list>
 #include "Config.h"
 #include "FPLog.h"
@@ -27,6 +27,12 @@ static std::mutex gc_mutex;
 static std::atomic<bool> _created(false);
 static ClientEnginePtr _engine;
 
+static inline void notifyLoop(ClientIOLoop* loop)
+{
+	int count = (int)write(loop->notifyFds[1], loop, 4);
+	(void)count;
+}
+
 ClientEnginePtr ClientEngine::create(const ClientEngineInitParams *params)
 {
 	if (!_created)
@@ -41,8 +47,7 @@ ClientEnginePtr ClientEngine::create(const ClientEngineInitParams *params)
 	return _engine;
 }
 
-ClientEngine::ClientEngine(const ClientEngineInitParams *params): _running(true),
-	_newSocketSetChanged(false), _waitWriteSetChanged(false), _quitSocketSetChanged(false), _loopTicket(0)
+ClientEngine::ClientEngine(const ClientEngineInitParams *params): _running(true)
 {
 	ClientEngineInitParams defaultParams;
 	if (!params)
@@ -56,15 +61,26 @@ ClientEngine::ClientEngine(const ClientEngineInitParams *params): _running(true)
 	_connectTimeout = params->globalConnectTimeoutSeconds * 1000;
 	_questTimeout = params->globalQuestTimeoutSeconds * 1000;
 
-	if (pipe(_notifyFds) != 0)	//-- Will failed when current processor using to many fds, or the system limitation reached.
-		LOG_FATAL("ClientEngine create pipe for notification failed.");
+	int ioThreads = params->ioThreads > 0 ? params->ioThreads : 1;
+	for (int i = 0; i < ioThreads; i++)
+	{
+		ClientIOLoop* loop = new ClientIOLoop();
 
-	nonblockedFd(_notifyFds[0]);
-	nonblockedFd(_notifyFds[1]);
+		if (pipe(loop->notifyFds) != 0)	//-- Will failed when current processor using to many fds, or the system limitation reached.
+			LOG_FATAL("ClientEngine create pipe for notification failed.");
+
+		nonblockedFd(loop->notifyFds[0]);
+		nonblockedFd(loop->notifyFds[1]);
+
+		loop->poller = EventPoller::create(loop->notifyFds[0], params->useSelect);
+		_ioLoops.push_back(loop);
+	}
 
 	_callbackPool.init(0, 1, params->residentTaskThread, params->maxTaskThreads);
 
-	_loopThread = std::thread(&ClientEngine::loopThread, this);
+	for (ClientIOLoop* loop: _ioLoops)
+		loop->thread = std::thread(&ClientEngine::loopThread, this, loop);
+
 	_timeoutChecker = std::thread(&ClientEngine::timeoutCheckThread, this);
 }
 
@@ -72,61 +88,75 @@ ClientEngine::~ClientEngine()
 {
 	_running = false;
 
-	int count = (int)write(_notifyFds[1], this, 4);
-	(void)count;
+	for (ClientIOLoop* loop: _ioLoops)
+		notifyLoop(loop);
+
+	_connectionMap.wakeUpTimeoutChecker();
 
 	_timeoutChecker.join();
-	_loopThread.join();
+	for (ClientIOLoop* loop: _ioLoops)
+		loop->thread.join();
+
+	clean();
 
-	close(_notifyFds[1]);
-	close(_notifyFds[0]);
+	for (ClientIOLoop* loop: _ioLoops)
+	{
+		delete loop->poller;
+
+		close(loop->notifyFds[1]);
+		close(loop->notifyFds[0]);
+
+		delete loop;
+	}
 }
 
 bool ClientEngine::join(const BasicConnection* connection, bool waitForSending)
 {
 	int socket = connection->socket();
-	if (socket >= FD_SETSIZE)
+	ClientIOLoop* loop = ioLoop(socket);
+
+	if (!loop->poller->acceptable(socket))
 	{
-		LOG_ERROR("New connection socket %d is large than FD_SETSIZE %d, new connection is refused. %s",
-			socket, FD_SETSIZE, connection->_connectionInfo->str().c_str());
+		LOG_ERROR("New connection socket %d is unacceptable for %s poller, new connection is refused. %s",
+			socket, loop->poller->name(), connection->_connectionInfo->str().c_str());
 		return false;
 	}
 
 	_connectionMap.insert(socket, (BasicConnection*)connection);
 
 	{
-		std::unique_lock<std::mutex> lck(_mutex);
+		std::unique_lock<std::mutex> lck(loop->mutex);
 
-		_quitSocketSet.erase(socket);
-		_newSocketSet.insert(socket);
-		_newSocketSetChanged = true;
+		loop->quitSocketSet.erase(socket);
+		loop->newSocketSet.insert(socket);
+		loop->newSocketSetChanged = true;
 
 		if (waitForSending)
 		{
-			_waitWriteSet.insert(socket);
-			_waitWriteSetChanged = true;
+			loop->waitWriteSet.insert(socket);
+			loop->waitWriteSetChanged = true;
 		}
 	}
 
-	int count = (int)write(_notifyFds[1], this, 4);
-	(void)count;
-	
+	notifyLoop(loop);
 	return true;
 }
 
 bool ClientEngine::waitSendEvent(const BasicConnection* connection)
 {
+	int socket = connection->socket();
+	ClientIOLoop* loop = ioLoop(socket);
+
 	{
-		std::unique_lock<std::mutex> lck(_mutex);
-		if (_quitSocketSet.find(connection->socket()) != _quitSocketSet.end())
+		std::unique_lock<std::mutex> lck(loop->mutex);
+		if (loop->quitSocketSet.find(socket) != loop->quitSocketSet.end())
 			return false;
 		
-		_waitWriteSet.insert(connection->socket());
-		_waitWriteSetChanged = true;
+		loop->waitWriteSet.insert(socket);
+		loop->waitWriteSetChanged = true;
 	}
 
-	int count = (int)write(_notifyFds[1], this, 4);
-	(void)count;
+	notifyLoop(loop);
 	return true;
 }
 
@@ -135,18 +165,19 @@ void ClientEngine::quit(BasicConnection* connection)
 	int socket = connection->socket();
 	_connectionMap.remove(socket);
 
+	ClientIOLoop* loop = ioLoop(socket);
 	{
-		std::unique_lock<std::mutex> lck(_mutex);
-		_waitWriteSet.erase(socket);
-		_newSocketSet.erase(socket);
-		_quitSocketSet.insert(socket);
-		_quitSocketSetChanged = true;
+		std::unique_lock<std::mutex> lck(loop->mutex);
+		loop->waitWriteSet.erase(socket);
+		loop->newSocketSet.erase(socket);
+		loop->quitSocketSet.insert(socket);
+		loop->quitSocketSetChanged = true;
 	}
 
-	connection->_quitEngineLoopTicket = _loopTicket;
+	connection->_engineLoopTicket = &(loop->loopTicket);
+	connection->_quitEngineLoopTicket = loop->loopTicket;
 
-	int count = (int)write(_notifyFds[1], this, 4);
-	(void)count;
+	notifyLoop(loop);
 }
 
 void ClientEngine::sendTCPData(int socket, uint64_t token, std::string* data)
@@ -181,8 +212,8 @@ void ClientEngine::clearConnectionQuestCallbacks(BasicConnection* connection, in
 		{
 			callback->fillResult(NULL, errorCode);
 
-			BasicAnswerCallbackPtr task(callback);
-			_callbackPool.wakeUp(task);
+			if (_callbackPool.wakeUp(callback) == false)
+				delete callback;
 		}
 	}
 	// connection->_callbackMap.clear(); //-- If necessary.
@@ -246,7 +277,8 @@ void ClientEngine::clearConnection(int socket, int errorCode)
 
 void ClientEngine::clean()
 {
-	_loopTicket += 5;	//-- Plus any number larger than 2 for all connections can be closed.
+	for (ClientIOLoop* loop: _ioLoops)
+		loop->loopTicket += 5;	//-- Plus any number larger than 2 for all connections can be closed.
 
 	std::set<int> fdSet;
 	_connectionMap.getAllSocket(fdSet);
@@ -269,124 +301,78 @@ void ClientEngine::processConnectionIO(int fd, bool canRead, bool canWrite)
 		UDPClientIOProcessor::processConnectionIO((UDPClientConnection*)conn, canRead, canWrite);
 }
 
-void ClientEngine::loopThread()
+void ClientEngine::loopThread(ClientIOLoop* loop)
 {
-	fd_set rfds;
-	fd_set wfds;
-	fd_set efds;
-
-	std::set<int> allSocket; //-- except _notifyFds[0].
-	std::set<int> wantWriteSocket;
-
-	struct ConnStatInfo {
-		bool canRead;
-		bool canWrite;
-
-		ConnStatInfo(): canRead(false), canWrite(false) {}
-	};
+	std::vector<PolledEvent> events;
 
 	while (_running)
 	{
-		FD_ZERO(&rfds);
-		FD_ZERO(&wfds);
-		FD_ZERO(&efds);
-
-		int maxfd = _notifyFds[0];
-
-		FD_SET(_notifyFds[0], &rfds);
-		for (int socket: allSocket)
-		{
-			FD_SET(socket, &rfds);
-			FD_SET(socket, &efds);
+		bool notified = false;
+		events.clear();
 
-			if (socket > maxfd)
-				maxfd = socket;
-		}
-
-		for (int socket: wantWriteSocket)
-			FD_SET(socket, &wfds);
-
-		
-		int activeCount = select(maxfd + 1, &rfds, &wfds, &efds, NULL);
+		int activeCount = loop->poller->wait(events, notified);
 		if (activeCount > 0)
 		{
-			_loopTicket++;
+			loop->loopTicket++;
 
-			if (FD_ISSET(_notifyFds[0], &rfds))		//-- MUST do this before check _running flag.
-				consumeNotifyData();
+			if (notified)		//-- MUST do this before check _running flag.
+				consumeNotifyData(loop);
 
 			if (_running == false)
 				break;
 
-			std::map<int, ConnStatInfo> connStatus;
-			//-- error & read set
+			//-- error set
+			for (auto& event: events)
 			{
-				std::set<int> dropped;
-				for (int socket: allSocket)
+				if (event.error)
 				{
-					if (FD_ISSET(socket, &efds))
-					{
-						FD_CLR(socket, &wfds);
-
-						dropped.insert(socket);
-					}
-					else if (FD_ISSET(socket, &rfds))
-						connStatus[socket].canRead = true;
-				}
-
-				for (int socket: dropped)
-				{
-					allSocket.erase(socket);
-					wantWriteSocket.erase(socket);
-					clearConnection(socket, FPNN_EC_CORE_UNKNOWN_ERROR);
+					loop->poller->remove(event.fd);
+					clearConnection(event.fd, FPNN_EC_CORE_UNKNOWN_ERROR);
 				}
 			}
 
-			//-- write set
+			//-- read & write set
+			for (auto& event: events)
 			{
-				for (int socket: wantWriteSocket)
-					if (FD_ISSET(socket, &wfds))
-						connStatus[socket].canWrite = true;
-			}
+				if (event.error)
+					continue;
 
-			for (auto& csp: connStatus)
-			{
-				processConnectionIO(csp.first, csp.second.canRead, csp.second.canWrite);
-				wantWriteSocket.erase(csp.first);
+				if (event.canWrite)
+					loop->poller->cancelWrite(event.fd);
+
+				processConnectionIO(event.fd, event.canRead, event.canWrite);
 			}
 
 			//-- check event flags
 			{
-				_loopTicket++;
+				loop->loopTicket++;
 
-				std::unique_lock<std::mutex> lck(_mutex);
-				if (_quitSocketSetChanged)
+				std::unique_lock<std::mutex> lck(loop->mutex);
+				if (loop->quitSocketSetChanged)
 				{
-					for (int socket: _quitSocketSet)
-					{
-						allSocket.erase(socket);
-						wantWriteSocket.erase(socket);
-					}
-					_quitSocketSet.clear();
-					_quitSocketSetChanged = false;
+					for (int socket: loop->quitSocketSet)
+						loop->poller->remove(socket);
+
+					loop->quitSocketSet.clear();
+					loop->quitSocketSetChanged = false;
 				}
 
-				if (_newSocketSetChanged)
+				if (loop->newSocketSetChanged)
 				{
-					for (int socket: _newSocketSet)
-						allSocket.insert(socket);
+					for (int socket: loop->newSocketSet)
+						loop->poller->add(socket);
 					
-					_newSocketSet.clear();
-					_newSocketSetChanged = false;
+					loop->newSocketSet.clear();
+					loop->newSocketSetChanged = false;
 				}
 
-				if (_waitWriteSetChanged)
+				if (loop->waitWriteSetChanged)
 				{
-					for (int socket: _waitWriteSet)
-						wantWriteSocket.insert(socket);
+					for (int socket: loop->waitWriteSet)
+						loop->poller->waitWrite(socket);
 					
-					_waitWriteSet.clear();
-					_waitWriteSetChanged = false;
+					loop->waitWriteSet.clear();
+					loop->waitWriteSetChanged = false;
 				}
 			}
 		}
@@ -397,23 +383,21 @@ void ClientEngine::loopThread()
 
 			if (errno == EBADF)
 			{
-				LOG_ERROR("EBADF when select()! Please tell swxlion@hotmail.com to rewrite all _loopTicket logic and releaseable logic.");
+				LOG_ERROR("EBADF when %s()! Please tell swxlion@hotmail.com to rewrite all _loopTicket logic and releaseable logic.", loop->poller->name());
 				break;
 			}
 			
-			LOG_ERROR("Unknown Error when select() errno: %d", errno);
+			LOG_ERROR("Unknown Error when %s() errno: %d", loop->poller->name(), errno);
 			break;
 		}
 	}
-
-	clean();
 }
 
-void ClientEngine::consumeNotifyData()
+void ClientEngine::consumeNotifyData(ClientIOLoop* loop)
 {
 	const int buf_len = 4;
 
-	int fd = _notifyFds[0];
+	int fd = loop->notifyFds[0];
 	char buf[buf_len];
 
 	while (true)
@@ -432,13 +416,12 @@ void ClientEngine::consumeNotifyData()
 void ClientEngine::reclaimConnections()
 {
 	std::set<IReleaseablePtr> deleted;
-	uint64_t currentLoopTicket = _loopTicket;
 
 	{
 		std::unique_lock<std::mutex> lck(_mutex);
 		for (IReleaseablePtr object: _reclaimedConnections)
 		{
-			if (object->releaseable(currentLoopTicket))
+			if (object->releaseable())
 				deleted.insert(object);
 		}
 		for (IReleaseablePtr object: deleted)
@@ -449,57 +432,64 @@ void ClientEngine::reclaimConnections()
 
 void ClientEngine::clearTimeoutQuest()
 {
-	int64_t current = TimeUtil::curr_msec();
-	std::list<std::map<uint32_t, BasicAnswerCallback*> > timeouted;
+	int64_t current = TimeUtil::steady_msec();
+	std::list<BasicAnswerCallback*> timeouted;
 
 	_connectionMap.extractTimeoutedCallback(current, timeouted);
-	for (auto bacMap: timeouted)
+	for (BasicAnswerCallback* callback: timeouted)
 	{
-		for (auto bacPair: bacMap)
+		if (callback->syncedCallback())		//-- check first, then fill result.
+			callback->fillResult(NULL, FPNN_EC_CORE_TIMEOUT);
+		else
 		{
-			if (bacPair.second)
-			{
-				BasicAnswerCallback* callback = bacPair.second;
-				if (callback->syncedCallback())		//-- check first, then fill result.
-					callback->fillResult(NULL, FPNN_EC_CORE_TIMEOUT);
-				else
-				{
-					callback->fillResult(NULL, FPNN_EC_CORE_TIMEOUT);
+			callback->fillResult(NULL, FPNN_EC_CORE_TIMEOUT);
 
-					BasicAnswerCallbackPtr task(callback);
-					_callbackPool.wakeUp(task);
-				}
-			}
+			if (_callbackPool.wakeUp(callback) == false)
+				delete callback;
 		}
 	}
 }
 
 void ClientEngine::timeoutCheckThread()
 {
+	const int64_t udpSendingCheckInterval = 50;
+	const int64_t keepAliveCheckInterval = 1000;
+
+	int64_t now = TimeUtil::steady_msec();
+	int64_t nextUDPSendingCheck = now + udpSendingCheckInterval;
+	int64_t nextKeepAliveCheck = now + keepAliveCheckInterval;
+
 	while (_running)
 	{
-		//-- Step 1: UDP period sending check
+		_connectionMap.waitTimeoutChecking(std::min(nextUDPSendingCheck, nextKeepAliveCheck));
+		if (!_running)
+			break;
+
+		//-- Step 1: clean timeouted callbacks
+
+		clearTimeoutQuest();
+
+		now = TimeUtil::steady_msec();
 
-		int cyc = 100;
-		int udpSendingCheckSyc = 5;
-		while (_running && cyc--)
+		//-- Step 2: UDP period sending check
+
+		if (now >= nextUDPSendingCheck)
 		{
-			udpSendingCheckSyc -= 1;
-			if (udpSendingCheckSyc == 0)
-			{
-				udpSendingCheckSyc = 5;
-				std::unordered_set<UDPClientConnection*> invalidOrExpiredConnections;
-				_connectionMap.periodUDPSendingCheck(invalidOrExpiredConnections);
+			nextUDPSendingCheck = now + udpSendingCheckInterval;
 
-				for (UDPClientConnection* conn: invalidOrExpiredConnections)
-					closeUDPConnection(conn);
-			}
+			std::unordered_set<UDPClientConnection*> invalidOrExpiredConnections;
+			_connectionMap.periodUDPSendingCheck(invalidOrExpiredConnections);
 
-			usleep(10000);
+			for (UDPClientConnection* conn: invalidOrExpiredConnections)
+				closeUDPConnection(conn);
 		}
 
+		if (now < nextKeepAliveCheck)
+			continue;
+
+		nextKeepAliveCheck = now + keepAliveCheckInterval;
 
-		//-- Step 2: TCP client keep alive
+		//-- Step 3: TCP client keep alive
 
 		std::list<TCPClientConnection*> invalidConnections;
 		std::list<TCPClientConnection*> connectExpiredConnections;
@@ -542,9 +532,6 @@ void ClientEngine::timeoutCheckThread()
 			}
 		}
 
-		//-- Step 3: clean timeouted callbacks
-
-		clearTimeoutQuest();
 		reclaimConnections();
 	}
 }
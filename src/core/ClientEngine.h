@@ -6,9 +6,11 @@
 #include <memory>
 #include <thread>
 #include <set>
+#include <vector>
 #include "FPLog.h"
 #include "IOWorker.h"
-#include "TaskThreadPool.h"
+#include "EventPoller.h"
+#include "WorkStealingThreadPool.h"
 #include "TCPClientIOWorker.h"
 #include "IQuestProcessor.h"
 #include "ConnectionMap.h"
@@ -25,10 +27,35 @@ namespace fpnn
 		int globalQuestTimeoutSeconds;
 		int residentTaskThread;
 		int maxTaskThreads;
+		int ioThreads;
 
 		bool ignoreSignals;
+		bool useSelect;			//-- Only for Linux. Other platforms always use select().
 
-		ClientEngineInitParams(): globalConnectTimeoutSeconds(5), globalQuestTimeoutSeconds(5), residentTaskThread(4), maxTaskThreads(64), ignoreSignals(true) {}
+		ClientEngineInitParams(): globalConnectTimeoutSeconds(5), globalQuestTimeoutSeconds(5), residentTaskThread(4), maxTaskThreads(64),
+			ioThreads(1), ignoreSignals(true), useSelect(false) {}
+	};
+
+	//-- Each IO loop owns the sockets which (socket % ioThreads) equal to its index.
+	struct ClientIOLoop
+	{
+		std::mutex mutex;
+		int notifyFds[2];
+		EventPoller* poller;
+
+		std::set<int> newSocketSet;
+		std::set<int> waitWriteSet;
+		std::set<int> quitSocketSet;
+
+		bool newSocketSetChanged;
+		bool waitWriteSetChanged;
+		bool quitSocketSetChanged;
+
+		std::atomic<uint64_t> loopTicket;
+		std::thread thread;
+
+		ClientIOLoop(): poller(NULL), newSocketSetChanged(false), waitWriteSetChanged(false),
+			quitSocketSetChanged(false), loopTicket(0) {}
 	};
 
 	class ClientEngine: virtual public IConcurrentSender
@@ -37,37 +64,32 @@ namespace fpnn
 		std::mutex _mutex;
 		FPLogPtr _logHolder;
 
-		int _notifyFds[2];
 		int _connectTimeout;
 		int _questTimeout;
 		std::atomic<bool> _running;
-		std::set<int> _newSocketSet;
-		std::set<int> _waitWriteSet;
-		std::set<int> _quitSocketSet;
-
-		bool _newSocketSetChanged;
-		bool _waitWriteSetChanged;
-		bool _quitSocketSetChanged;
 
 		ConnectionMap _connectionMap;
-		TaskThreadPool _callbackPool;
+		WorkStealingThreadPool _callbackPool;
 
 		std::set<IReleaseablePtr> _reclaimedConnections;
 
 		std::thread _timeoutChecker;
-		std::thread _loopThread;
-
-		std::atomic<uint64_t> _loopTicket;
+		std::vector<ClientIOLoop*> _ioLoops;
 
 		ClientEngine(const ClientEngineInitParams *params = NULL);
 
+		inline ClientIOLoop* ioLoop(int socket)
+		{
+			return _ioLoops[socket % _ioLoops.size()];
+		}
+
 		void closeUDPConnection(UDPClientConnection* connection);
 		void clearConnection(int socket, int errorCode);
 		void reclaimConnections();
 		void clearTimeoutQuest();
 		void clean();
-		void loopThread();
-		void consumeNotifyData();
+		void loopThread(ClientIOLoop* loop);
+		void consumeNotifyData(ClientIOLoop* loop);
 		void timeoutCheckThread();
 		void processConnectionIO(int fd, bool canRead, bool canWrite);
 
@@ -83,6 +105,13 @@ namespace fpnn
 		inline static int getQuestTimeout(){
 			return instance()->_questTimeout / 1000;
 		}
+		inline static void setQuestTimeoutMsec(int msec)
+		{
+			instance()->_questTimeout = msec;
+		}
+		inline static int getQuestTimeoutMsec(){
+			return instance()->_questTimeout;
+		}
 		inline static void setConnectTimeout(int seconds)
 		{
 			instance()->_connectTimeout = seconds * 1000;
@@ -101,6 +130,12 @@ namespace fpnn
 			return instance()->_callbackPool.wakeUp(std::move(task));
 		}
 
+		//-- The task will be deleted after running. If return false, the caller keeps the ownership.
+		inline static bool runTask(ITaskThreadPool::ITask* task)
+		{
+			return instance()->_callbackPool.wakeUp(task);
+		}
+
 		void clearConnectionQuestCallbacks(BasicConnection*, int errorCode);
 
 		inline BasicConnection* takeConnection(const ConnectionInfo* ci)  //-- !!! Using for other case. e.g. TCPCLient.
@@ -145,10 +180,12 @@ namespace fpnn
 				If return false, caller must free quest & callback.
 				If return true, don't free quest & callback.
 		*/
+		//-- Deprecated: mutex is unused, sync calls wait on their own wait primitives. Kept for interface compatibility, pass NULL.
 		virtual FPAnswerPtr sendQuest(int socket, uint64_t token, std::mutex* mutex, FPQuestPtr quest, int timeout = 0)
 		{
+			(void)mutex;
 			if (timeout == 0) timeout = _questTimeout;
-			return _connectionMap.sendQuest(socket, token, mutex, quest, timeout, quest->isOneWay());
+			return _connectionMap.sendQuest(socket, token, quest, timeout, quest->isOneWay());
 		}
 		virtual bool sendQuest(int socket, uint64_t token, FPQuestPtr quest, AnswerCallback* callback, int timeout = 0)
 		{
@@ -166,11 +203,25 @@ namespace fpnn
 			return _connectionMap.sendQuest(socket, token, quest, std::move(task), timeout, quest->isOneWay());
 		}
 
-		//-- For UDP Client
+		//-- Returns the count of the outstanding quests of the connection. If connection is invalid, returns -1.
+		inline int outstandingQuestCount(int socket, uint64_t token)
+		{
+			return _connectionMap.callbackCount(socket, token);
+		}
+
+		//-- For TCP Client. If return false, caller must free callbacks.
+		inline bool sendQuests(int socket, uint64_t token, const std::vector<FPQuestPtr>& quests, const std::vector<BasicAnswerCallback*>& callbacks, int timeout = 0)
+		{
+			if (timeout == 0) timeout = _questTimeout;
+			return _connectionMap.sendQuests(socket, token, quests, callbacks, timeout);
+		}
+
+		//-- For UDP Client. Deprecated: mutex is unused, pass NULL.
 		virtual FPAnswerPtr sendQuest(int socket, uint64_t token, std::mutex* mutex, FPQuestPtr quest, int timeout, bool discardableUDPQuest)
 		{
+			(void)mutex;
 			if (timeout == 0) timeout = _questTimeout;
-			return _connectionMap.sendQuest(socket, token, mutex, quest, timeout, discardableUDPQuest);
+			return _connectionMap.sendQuest(socket, token, quest, timeout, discardableUDPQuest);
 		}
 		virtual bool sendQuest(int socket, uint64_t token, FPQuestPtr quest, AnswerCallback* callback, int timeout, bool discardableUDPQuest)
 		{
@@ -212,7 +263,7 @@ namespace fpnn
 			delete _connection;
 		}
 
-		virtual bool releaseable(uint64_t currentLoopTicket) { return _connection->releaseable(currentLoopTicket); }
+		virtual bool releaseable() { return _connection->releaseable(); }
 		virtual void run();
 	};
 }
@@ -1,5 +1,6 @@
 #include "Config.h"
 #include "NetworkUtility.h"
+#include "DNSResolver.h"
 #include "ClientInterface.h"
 
 using namespace fpnn;
@@ -7,8 +8,8 @@ using namespace fpnn;
 const char* Client::SDKVersion = FPNN_SDK_VERSION;
 
 Client::Client(const std::string& host, int port, bool autoReconnect): _connected(false),
-	_connStatus(ConnStatus::NoConnected), _timeoutQuest(0), _autoReconnect(autoReconnect),
-	_requireCacheSendData(false), _embedRecvNotifyDeleagte(NULL)
+	_connStatus(ConnStatus::NoConnected), _timeoutQuest(0), _autoReconnect(autoReconnect), _inlineAnswerCallback(false),
+	_orderedCallbacks(false), _strand(TaskStrand::create()), _requireCacheSendData(false), _embedRecvNotifyDeleagte(NULL)
 {
 	_engine = ClientEngine::instance();
 	if (host.find(':') == std::string::npos)
@@ -21,31 +22,25 @@ Client::Client(const std::string& host, int port, bool autoReconnect): _connecte
 		}
 		else
 		{
+			/*
+				Domain is resolved asynchronously when connecting, and re-resolved when reconnecting if the cache expired.
+				Before resolved, we treat it as IPv4 address, for other logic can report error in right way.
+			*/
+			_hostname = host;
+			_endpoint = std::string(host + ":").append(std::to_string(port));
+
 			std::string IPAddress;
-			EndPointType eType;
-			if (getIPAddress(host, IPAddress, eType))
+			EndPointType eType = ENDPOINT_TYPE_IP4;
+			bool resolved = false;
+			if (DNSResolver::instance()->lookupCache(host, IPAddress, eType, resolved) && resolved)
 			{
-				if (eType == ENDPOINT_TYPE_IP4)
-				{
-					_isIPv4 = true;
-					_connectionInfo.reset(new ConnectionInfo(0, port, IPAddress, true));
-					_endpoint = std::string(IPAddress + ":").append(std::to_string(port));
-				}
-				else
-				{
-					_isIPv4 = false;
-					_connectionInfo.reset(new ConnectionInfo(0, port, IPAddress, false));
-					_endpoint = std::string("[").append(IPAddress).append("]:").append(std::to_string(port));
-				}
+				_isIPv4 = (eType == ENDPOINT_TYPE_IP4);
+				_connectionInfo.reset(new ConnectionInfo(0, port, IPAddress, _isIPv4));
 			}
 			else
 			{
-				LOG_ERROR("Get IP address for %s failed. Current client is invalid.", host.c_str());
-
-				//-- for other logic can report error in right way, we still treat the invalid host as IPv4 address.
 				_isIPv4 = true;
 				_connectionInfo.reset(new ConnectionInfo(0, port, host, true));
-				_endpoint = std::string(host + ":").append(std::to_string(port));
 			}
 		}
 	}
@@ -63,6 +58,13 @@ Client::~Client()
 		close();
 }
 
+ConnectionInfoPtr Client::updateResolvedAddress(const std::string& IPAddress, EndPointType eType)
+{
+	_isIPv4 = (eType == ENDPOINT_TYPE_IP4);
+	_connectionInfo.reset(new ConnectionInfo(0, _connectionInfo->port, IPAddress, _isIPv4));
+	return _connectionInfo;
+}
+
 void Client::close()
 {
 	LOG_FATAL("Please implement the close() function for client inherited from fpnn::Client class.");
@@ -83,10 +85,12 @@ void Client::failedCachedSendingData(ConnectionInfoPtr connectionInfo,
 			}
 			
 			unit->callback->fillResult(NULL, FPNN_EC_CORE_INVALID_CONNECTION);
-			BasicAnswerCallbackPtr task(unit->callback);
 
-			if (ClientEngine::runTask(task) == false)
+			if (runCallbackTask(unit->callback) == false)
+			{
 				LOG_ERROR("[Fatal] wake up thread pool to process cached quest in async mode failed. Callback havn't called. %s", connectionInfo->str().c_str());
+				delete unit->callback;
+			}
 		}
 
 		delete unit;
@@ -126,7 +130,7 @@ void Client::reclaim(BasicConnection* connection, bool error)
 	std::shared_ptr<ClientCloseTask> task(new ClientCloseTask(_questProcessor, connection, error));
 	if (_questProcessor)
 	{
-		bool wakeup = ClientEngine::runTask(task);
+		bool wakeup = runCallbackTask(task);
 		if (!wakeup)
 			LOG_ERROR("wake up thread pool to process connection close event failed. Close callback will be called by Connection Reclaimer. %s", connection->_connectionInfo->str().c_str());
 	}
@@ -169,10 +173,31 @@ void Client::dealAnswer(FPAnswerPtr answer, ConnectionInfoPtr connectionInfo)
 	}
 	
 	callback->fillResult(answer, FPNN_EC_OK);
-	BasicAnswerCallbackPtr task(callback);
 
-	if (ClientEngine::runTask(task) == false)
+	if (_inlineAnswerCallback.load(std::memory_order_relaxed) || callback->inlineCallback())
+	{
+		try
+		{
+			callback->run();
+		}
+		catch (const std::exception& ex)
+		{
+			LOG_ERROR("Inline answer callback exception: %s. %s", ex.what(), connectionInfo->str().c_str());
+		}
+		catch (...)
+		{
+			LOG_ERROR("Inline answer callback unknown exception. %s", connectionInfo->str().c_str());
+		}
+
+		delete callback;
+		return;
+	}
+
+	if (runCallbackTask(callback) == false)
+	{
 		LOG_ERROR("[Fatal] wake up thread pool to process answer failed. Close callback havn't called. %s", connectionInfo->str().c_str());
+		delete callback;
+	}
 }
 
 void Client::processQuest(FPQuestPtr quest, ConnectionInfoPtr connectionInfo)
@@ -182,7 +207,7 @@ void Client::processQuest(FPQuestPtr quest, ConnectionInfoPtr connectionInfo)
 
 	try
 	{
-		FPReaderPtr args(new FPReader(quest->payload()));
+		FPReaderPtr args(new FPQReader(quest));
 		answer = _questProcessor->processQuest(args, quest, *connectionInfo);
 	}
 	catch (const FpnnError& ex)
@@ -274,12 +299,11 @@ void Client::clearConnectionQuestCallbacks(BasicConnection* connection, int erro
 		{
 			callback->fillResult(NULL, errorCode);
 
-			BasicAnswerCallbackPtr task(callback);
-
-			if (ClientEngine::runTask(task) == false)
+			if (runCallbackTask(callback) == false)
 			{
 				LOG_ERROR("wake up thread pool to process quest callback when connection closing failed. Quest callback will be called in current thread. %s", connection->_connectionInfo->str().c_str());
-				task->run();
+				callback->run();
+				delete callback;
 			}
 		}
 	}
@@ -297,3 +321,22 @@ bool Client::asyncReconnect()
 	close();
 	return asyncConnect();
 }
+
+QuestFuture Client::sendQuestFutureMsec(FPQuestPtr quest, int timeoutMsec)
+{
+	if (quest->isOneWay())
+	{
+		if (sendQuestMsec(quest, (AnswerCallback*)NULL, timeoutMsec))
+			return QuestFuture::makeReady(nullptr, FPNN_EC_OK);
+		else
+			return QuestFuture::makeReady(nullptr, FPNN_EC_CORE_SEND_ERROR);
+	}
+
+	QuestFutureStatePtr state = std::make_shared<QuestFutureState>();
+	FutureAnswerCallback* callback = new FutureAnswerCallback(quest, state);
+	if (sendQuestMsec(quest, callback, timeoutMsec))
+		return QuestFuture(state);
+
+	delete callback;
+	return QuestFuture::makeReady(FPAWriter::errorAnswer(quest, FPNN_EC_CORE_SEND_ERROR, "unknown sending error."), FPNN_EC_CORE_SEND_ERROR);
+}
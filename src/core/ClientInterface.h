@@ -6,8 +6,11 @@
 #include <memory>
 #include <functional>
 #include <condition_variable>
+#include "NetworkUtility.h"
 #include "AnswerCallbacks.h"
 #include "ClientEngine.h"
+#include "TaskStrand.h"
+#include "QuestFuture.h"
 #include "IQuestProcessor.h"
 #include "embedTypes.h"
 
@@ -50,9 +53,13 @@ namespace fpnn
 		IQuestProcessorPtr _questProcessor;
 		ConnectionInfoPtr	_connectionInfo;
 		std::string _endpoint;
+		std::string _hostname;		//-- Empty if host is an IP address. Else, resolved by DNSResolver when connecting.
 
 		int64_t _timeoutQuest;
 		bool _autoReconnect;
+		std::atomic<bool> _inlineAnswerCallback;
+		std::atomic<bool> _orderedCallbacks;
+		TaskStrandPtr _strand;
 
 		bool _requireCacheSendData;
 		std::list<AsyncQuestCacheUnit*> _asyncQuestCache;
@@ -62,6 +69,25 @@ namespace fpnn
 
 	protected:
 		void reclaim(BasicConnection* connection, bool error);
+		//-- MUST be called under _mutex.
+		ConnectionInfoPtr updateResolvedAddress(const std::string& IPAddress, EndPointType eType);
+
+		//-- Run quest, answer & close tasks in thread pool, or in the strand if ordered callbacks enabled.
+		inline bool runCallbackTask(ITaskThreadPool::ITaskPtr task)
+		{
+			if (_orderedCallbacks)
+				return _strand->post(task);
+
+			return ClientEngine::runTask(task);
+		}
+		//-- The task will be deleted after running. If return false, the caller keeps the ownership.
+		inline bool runCallbackTask(ITaskThreadPool::ITask* task)
+		{
+			if (_orderedCallbacks)
+				return _strand->post(task);
+
+			return ClientEngine::runTask(task);
+		}
 
 	public:
 		Client(const std::string& host, int port, bool autoReconnect = true);
@@ -79,7 +105,12 @@ namespace fpnn
 		/*===============================================================================
 		  Call by anybody.
 		=============================================================================== */
-		inline bool connected() { return _connected; }
+		virtual bool connected() { return _connected; }
+		/*
+			The endpoint given when the client created. If created by host name, it is "host:port" and never changes,
+			even after connected. The resolved address, which may change when re-resolved after the cache expired,
+			is in connectionInfo().
+		*/
 		inline const std::string& endpoint() { return _endpoint; }
 		inline int socket()
 		{
@@ -108,6 +139,14 @@ namespace fpnn
 		{
 			return _timeoutQuest / 1000;
 		}
+		inline void setQuestTimeoutMsec(int64_t msec)
+		{
+			_timeoutQuest = msec;
+		}
+		inline int64_t getQuestTimeoutMsec()
+		{
+			return _timeoutQuest;
+		}
 
 		inline bool isAutoReconnect()
 		{
@@ -118,6 +157,40 @@ namespace fpnn
 			_autoReconnect = autoReconnect;
 		}
 
+		/*
+			If enabled, async answer callbacks will be run in the IO thread directly when answers received,
+			the thread pool hop is skipped. Only for lightweight callbacks which never block.
+		*/
+		inline bool isInlineAnswerCallback()
+		{
+			return _inlineAnswerCallback.load(std::memory_order_relaxed);
+		}
+		inline void setInlineAnswerCallback(bool inlineCallback)
+		{
+			_inlineAnswerCallback.store(inlineCallback, std::memory_order_relaxed);
+		}
+
+		/*
+			If enabled, quests from server, async answer callbacks, connection closing errors of callbacks and the
+			connection closed event will be run in a serial strand of this client: one by one, in arrival order,
+			on any free thread of the thread pool.
+			Inline answer callbacks are still run in the IO thread. Quest timeout errors are still processed in the thread pool.
+			Please configure it before connecting.
+		*/
+		inline bool isOrderedCallbacks()
+		{
+			return _orderedCallbacks;
+		}
+		inline void setOrderedCallbacks(bool ordered)
+		{
+			_orderedCallbacks = ordered;
+		}
+		//-- The strand for ordered callbacks. Developers can post own tasks into it for keeping order with the callbacks.
+		inline TaskStrandPtr callbackStrand()
+		{
+			return _strand;
+		}
+
 		/*===============================================================================
 		  Call by Developer.
 		=============================================================================== */
@@ -139,6 +212,34 @@ namespace fpnn
 		virtual bool sendQuest(FPQuestPtr quest, AnswerCallback* callback, int timeout = 0) = 0;
 		virtual bool sendQuest(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeout = 0) = 0;
 
+		/*
+			Timeout in milliseconds.
+			The default implementations round the timeout up to seconds, and call sendQuest().
+			TCPClient & UDPClient override them with millisecond precision.
+		*/
+		virtual FPAnswerPtr sendQuestMsec(FPQuestPtr quest, int timeoutMsec = 0)
+		{
+			return sendQuest(quest, (timeoutMsec + 999) / 1000);
+		}
+		virtual bool sendQuestMsec(FPQuestPtr quest, AnswerCallback* callback, int timeoutMsec = 0)
+		{
+			return sendQuest(quest, callback, (timeoutMsec + 999) / 1000);
+		}
+		virtual bool sendQuestMsec(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeoutMsec = 0)
+		{
+			return sendQuest(quest, std::move(task), (timeoutMsec + 999) / 1000);
+		}
+
+		/*
+			Future mode. Never returns an invalid future: if sending failed, the future is ready with FPNN_EC_CORE_SEND_ERROR.
+			Batches of futures can be waited by QuestFuture::whenAll() & QuestFuture::whenAny() with one wakeup.
+		*/
+		inline QuestFuture sendQuestFuture(FPQuestPtr quest, int timeout = 0)
+		{
+			return sendQuestFutureMsec(quest, timeout * 1000);
+		}
+		QuestFuture sendQuestFutureMsec(FPQuestPtr quest, int timeoutMsec = 0);
+
 		static TCPClientPtr createTCPClient(const std::string& host, int port, bool autoReconnect = true);
 		static TCPClientPtr createTCPClient(const std::string& endpoint, bool autoReconnect = true);
 
@@ -16,6 +16,9 @@ namespace fpnn
 			All SendQuest():
 				If throw exception or return false, caller must free quest & callback.
 				If return true, or FPAnswerPtr is NULL, don't free quest & callback.
+
+			Deprecated: the mutex parameter of the sync sendQuest() is unused, sync calls wait on their own
+			wait primitives. It is kept for interface compatibility, pass NULL.
 		*/
 		virtual FPAnswerPtr sendQuest(int socket, uint64_t token, std::mutex* mutex, FPQuestPtr quest, int timeout = 0) = 0;
 		virtual bool sendQuest(int socket, uint64_t token, FPQuestPtr quest, AnswerCallback* callback, int timeout = 0) = 0;
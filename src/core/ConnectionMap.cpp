@@ -1,13 +1,41 @@
+#include <limits>
 #include "TimeUtil.h"
 #include "ConnectionMap.h"
 
 namespace fpnn
 {
+	void ConnectionMap::waitForEmpty()
+	{
+		for (int i = 0; i < PartitionCount; i++)
+		{
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lck(_partitions[i].mutex);
+					if (_partitions[i].connections.empty())
+						break;
+				}
+				usleep(20000);
+			}
+		}
+	}
+
+	void ConnectionMap::getAllSocket(std::set<int>& fdSet)
+	{
+		for (int i = 0; i < PartitionCount; i++)
+		{
+			std::unique_lock<std::mutex> lck(_partitions[i].mutex);
+			for (auto& cmp: _partitions[i].connections)
+				fdSet.insert(cmp.first);
+		}
+	}
+
 	bool ConnectionMap::embed_checkCallback(int socket, uint32_t seqNum)
 	{
-		std::unique_lock<std::mutex> lck(_mutex);
-		auto it = _connections.find(socket);
-		if (it == _connections.end())
+		Partition& part = partition(socket);
+		std::unique_lock<std::mutex> lck(part.mutex);
+		auto it = part.connections.find(socket);
+		if (it == part.connections.end())
 			return false;
 
 		BasicConnection* connection = it->second;
@@ -16,9 +44,10 @@ namespace fpnn
 
 	BasicAnswerCallback* ConnectionMap::takeCallback(int socket, uint32_t seqNum)
 	{
-		std::unique_lock<std::mutex> lck(_mutex);
-		auto it = _connections.find(socket);
-		if (it != _connections.end())
+		Partition& part = partition(socket);
+		std::unique_lock<std::mutex> lck(part.mutex);
+		auto it = part.connections.find(socket);
+		if (it != part.connections.end())
 		{
 			BasicConnection* connection = it->second;
 			
@@ -26,7 +55,8 @@ namespace fpnn
 			if (iter != connection->_callbackMap.end())
 			{
 				BasicAnswerCallback* cb = iter->second;
-				connection->_callbackMap.erase(seqNum);
+				connection->_callbackMap.erase(iter);
+				part.timeoutWheel.remove(cb);
 				return cb;
 			}
 			return NULL;
@@ -34,45 +64,72 @@ namespace fpnn
 		return NULL;
 	}
 
-	void ConnectionMap::extractTimeoutedCallback(int64_t threshold, std::list<std::map<uint32_t, BasicAnswerCallback*> >& timeouted)
+	void ConnectionMap::extractTimeoutedCallback(int64_t threshold, std::list<BasicAnswerCallback*>& timeouted)
 	{
-		std::unique_lock<std::mutex> lck(_mutex);
-		for (auto& cmp: _connections)
+		for (int i = 0; i < PartitionCount; i++)
 		{
-			BasicConnection* connection = cmp.second;
+			std::unique_lock<std::mutex> lck(_partitions[i].mutex);
+			_partitions[i].timeoutWheel.extract(threshold, timeouted);
+		}
+	}
 
-			std::map<uint32_t, BasicAnswerCallback*> basMap;
-			timeouted.push_back(basMap);
+	void ConnectionMap::waitTimeoutChecking(int64_t latestMsec)
+	{
+		/*
+			Any quest sent during scanning will wake up the checker, because its expired time is less than INT64_MAX.
+			Quests sent before the partition scanned are covered by the scanning.
+		*/
+		_scheduledCheckTime = std::numeric_limits<int64_t>::max();
 
-			std::map<uint32_t, BasicAnswerCallback*>& currMap = timeouted.back();
-			for (auto& cbPair: connection->_callbackMap)
-			{
-				if (cbPair.second->expiredTime() <= threshold)
-					currMap[cbPair.first] = cbPair.second;
-			}
+		int64_t scheduledTime = latestMsec;
+		for (int i = 0; i < PartitionCount; i++)
+		{
+			std::unique_lock<std::mutex> lck(_partitions[i].mutex);
+			int64_t nearestTick = _partitions[i].timeoutWheel.nearestTick();
+			if (nearestTick < scheduledTime)
+				scheduledTime = nearestTick;
+		}
+		_scheduledCheckTime = scheduledTime;
 
-			for (auto& bacPair: currMap)
-				connection->_callbackMap.erase(bacPair.first);
+		std::unique_lock<std::mutex> lck(_scheduleMutex);
+		while (!_checkRequired)
+		{
+			int64_t waitMsec = _scheduledCheckTime - TimeUtil::steady_msec();
+			if (waitMsec <= 0)
+				break;
+
+			_scheduleCondition.wait_for(lck, std::chrono::milliseconds(waitMsec));
 		}
+		_checkRequired = false;
+	}
+
+	void ConnectionMap::wakeUpTimeoutChecker()
+	{
+		std::unique_lock<std::mutex> lck(_scheduleMutex);
+		_checkRequired = true;
+		_scheduleCondition.notify_one();
 	}
 
 	void ConnectionMap::extractTimeoutedConnections(int64_t threshold, std::list<BasicConnection*>& timeouted)
 	{
-		std::list<int> timeoutedNodes;
-		std::unique_lock<std::mutex> lck(_mutex);
-		for (auto& cmp: _connections)
+		for (int i = 0; i < PartitionCount; i++)
 		{
-			BasicConnection* connection = cmp.second;
-
-			if (connection->_activeTime <= threshold)
+			Partition& part = _partitions[i];
+			std::unique_lock<std::mutex> lck(part.mutex);
+			for (auto it = part.connections.begin(); it != part.connections.end(); )
 			{
-				timeoutedNodes.push_back(cmp.first);
-				timeouted.push_back(connection);
+				BasicConnection* connection = it->second;
+
+				if (connection->_activeTime <= threshold)
+				{
+					timeouted.push_back(connection);
+					part.timeoutWheel.detach(connection);
+					it = part.connections.erase(it);
+				}
+				else
+					it++;
 			}
 		}
-
-		for (auto n: timeoutedNodes)
-			_connections.erase(n);
 	}
 
 	bool ConnectionMap::sendQuestWithBasicAnswerCallback(int socket, uint64_t token, FPQuestPtr quest, BasicAnswerCallback* callback, int timeout, bool discardableUDPQuest)
@@ -106,7 +163,7 @@ namespace fpnn
 		uint32_t seqNum = quest->seqNumLE();
 
 		if (callback)
-			callback->updateExpiredTime(TimeUtil::curr_msec() + timeout);
+			callback->updateExpiredTime(TimeUtil::steady_msec() + timeout);
 
 		bool status = sendQuest(socket, token, raw, seqNum, callback, timeout, discardableUDPQuest);
 		if (!status)
@@ -115,7 +172,7 @@ namespace fpnn
 		return status;
 	}
 
-	FPAnswerPtr ConnectionMap::sendQuest(int socket, uint64_t token, std::mutex* mutex, FPQuestPtr quest, int timeout, bool discardableUDPQuest)
+	FPAnswerPtr ConnectionMap::sendQuest(int socket, uint64_t token, FPQuestPtr quest, int timeout, bool discardableUDPQuest)
 	{
 		if (!quest->isTwoWay())
 		{
@@ -123,22 +180,104 @@ namespace fpnn
 			return NULL;
 		}
 
-		std::shared_ptr<SyncedAnswerCallback> s(new SyncedAnswerCallback(mutex, quest));
-		if (!sendQuestWithBasicAnswerCallback(socket, token, quest, s.get(), timeout, discardableUDPQuest))
+		//-- Filled result is the last access of the framework, so the callback can live on the waiting stack.
+		SyncedAnswerCallback s(quest);
+		if (!sendQuestWithBasicAnswerCallback(socket, token, quest, &s, timeout, discardableUDPQuest))
 		{
 			return FPAWriter::errorAnswer(quest, FPNN_EC_CORE_SEND_ERROR, "unknown sending error.");
 		}
 
-		return s->takeAnswer();
+		return s.takeAnswer();
+	}
+
+	bool ConnectionMap::sendQuests(int socket, uint64_t token, const std::vector<FPQuestPtr>& quests, const std::vector<BasicAnswerCallback*>& callbacks, int timeout)
+	{
+		if (quests.size() != callbacks.size())
+			return false;
+
+		std::vector<std::string*> dataList;
+		dataList.reserve(quests.size());
+
+		for (size_t i = 0; i < quests.size(); i++)
+		{
+			const FPQuestPtr& quest = quests[i];
+			bool valid = quest && (quest->isOneWay() || callbacks[i]);
+			if (valid)
+			{
+				try
+				{
+					dataList.push_back(quest->raw());
+					continue;
+				}
+				catch (const FpnnError& ex){
+					LOG_ERROR("Quest Raw Exception:(%d)%s", ex.code(), ex.what());
+				}
+				catch (const std::exception& ex)
+				{
+					LOG_ERROR("Quest Raw Exception: %s", ex.what());
+				}
+				catch (...)
+				{
+					LOG_ERROR("Quest Raw Exception.");
+				}
+			}
+
+			for (std::string* data: dataList)
+				delete data;
+
+			return false;
+		}
+
+		int64_t expiredTime = TimeUtil::steady_msec() + timeout;
+		for (BasicAnswerCallback* callback: callbacks)
+			if (callback)
+				callback->updateExpiredTime(expiredTime);
+
+		BasicConnection* connection = NULL;
+		{
+			Partition& part = partition(socket);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(socket);
+			if (it == part.connections.end() || token != (uint64_t)(it->second)
+				|| it->second->connectionType() != BasicConnection::TCPClientConnectionType)
+			{
+				for (std::string* data: dataList)
+					delete data;
+
+				return false;
+			}
+
+			connection = it->second;
+			connection->_callbackMap.reserve(connection->_callbackMap.size() + callbacks.size());
+			for (size_t i = 0; i < quests.size(); i++)
+			{
+				if (callbacks[i])
+				{
+					connection->_callbackMap[quests[i]->seqNumLE()] = callbacks[i];
+					part.timeoutWheel.insert(connection, quests[i]->seqNumLE(), callbacks[i]);
+				}
+			}
+
+			if (expiredTime < _scheduledCheckTime)
+				wakeUpTimeoutChecker();
+
+			connection->_refCount++;
+		}
+
+		sendTCPData((TCPClientConnection*)connection, dataList);
+		connection->_refCount--;
+		return true;
 	}
 
 	void ConnectionMap::periodUDPSendingCheck(std::unordered_set<UDPClientConnection*>& invalidOrExpiredConnections)
 	{
 		std::set<UDPClientConnection*> udpConnections;
 		std::unordered_set<UDPClientConnection*> invalidConns;
+		for (int i = 0; i < PartitionCount; i++)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			for (auto& cmp: _connections)
+			Partition& part = _partitions[i];
+			std::unique_lock<std::mutex> lck(part.mutex);
+			for (auto& cmp: part.connections)
 			{
 				BasicConnection* connection = cmp.second;
 				if (connection->connectionType() == BasicConnection::UDPClientConnectionType)
@@ -158,7 +297,11 @@ namespace fpnn
 			}
 
 			for (UDPClientConnection* conn: invalidConns)
-				_connections.erase(conn->_connectionInfo->socket);
+			{
+				part.connections.erase(conn->_connectionInfo->socket);
+				part.timeoutWheel.detach(conn);
+			}
+			invalidConns.clear();
 		}
 
 		for (auto conn: udpConnections)
@@ -178,15 +321,18 @@ namespace fpnn
 		std::list<TCPClientKeepAliveTimeoutInfo> keepAliveList;
 
 		//-- Step 1: pick invalid connections & requiring ping connections
+		bool isLost;
+		int timeout;
+		int64_t now = slack_real_msec();
+
+		for (int i = 0; i < PartitionCount; i++)
 		{
-			bool isLost;
-			int timeout;
+			Partition& part = _partitions[i];
 			std::list<int> invalidSockets;
-			int64_t now = slack_real_msec();
 
-			std::unique_lock<std::mutex> lck(_mutex);
+			std::unique_lock<std::mutex> lck(part.mutex);
 
-			for (auto& cmp: _connections)
+			for (auto& cmp: part.connections)
 			{
 				BasicConnection* connection = cmp.second;
 				if (connection->connectionType() == BasicConnection::TCPClientConnectionType)
@@ -217,7 +363,11 @@ namespace fpnn
 			}
 
 			for (auto s: invalidSockets)
-				_connections.erase(s);
+			{
+				auto it = part.connections.find(s);
+				part.timeoutWheel.detach(it->second);
+				part.connections.erase(it);
+			}
 		}
 
 		//--  Step 2: send ping
@@ -228,4 +378,33 @@ namespace fpnn
 			sendTCPClientKeepAlivePingQuest(sharedPing, keepAliveList);
 		}
 	}
+
+	void ConnectionMap::sendTCPClientKeepAlivePingQuest(TCPClientSharedKeepAlivePingDatas& sharedPing, std::list<TCPClientKeepAliveTimeoutInfo>& keepAliveList)
+	{
+		for (auto& node: keepAliveList)
+		{
+			TCPClientConnection* conn = node.conn;
+			KeepAliveCallback* callback = NULL;
+			{
+				//-- Connection maybe removed after keep alive checking. Its callbacks will not be linked in the timeout wheel.
+				Partition& part = partition(conn->socket());
+				std::unique_lock<std::mutex> lck(part.mutex);
+				auto it = part.connections.find(conn->socket());
+				if (it != part.connections.end() && it->second == conn)
+				{
+					callback = new KeepAliveCallback(conn->_connectionInfo);
+					callback->updateExpiredTime(TimeUtil::steady_msec() + node.timeout);
+					registerCallback(part, conn, sharedPing.seqNum, callback);
+				}
+			}
+
+			if (callback)
+			{
+				sendTCPData(conn, new std::string(*(sharedPing.rawData)));
+				conn->updateKeepAliveMS();
+			}
+
+			conn->_refCount--;
+		}
+	}
 }
@@ -5,16 +5,23 @@
 #include <set>
 #include <list>
 #include <mutex>
+#include <atomic>
 #include <vector>
+#include <condition_variable>
 #include <unordered_map>
 #include "FPMessage.h"
 #include "FPWriter.h"
 #include "AnswerCallbacks.h"
+#include "QuestTimeoutWheel.h"
 #include "TCPClientIOWorker.h"
 #include "UDPClientIOWorker.h"
 
 namespace fpnn
 {
+	/*
+		Connections are partitioned by socket. Each partition has its own lock and quest timeout wheel.
+		Socket writing is done outside all partition locks, the connection is pinned by _refCount during sending.
+	*/
 	class ConnectionMap
 	{
 		struct TCPClientKeepAliveTimeoutInfo
@@ -23,74 +30,97 @@ namespace fpnn
 			int timeout;					//-- In milliseconds
 		};
 
-		std::mutex _mutex;
-		std::unordered_map<int, BasicConnection*> _connections;
+		struct Partition
+		{
+			std::mutex mutex;
+			std::unordered_map<int, BasicConnection*> connections;
+			QuestTimeoutWheel timeoutWheel;
+		};
+
+		enum
+		{
+			PartitionBits = 5,
+			PartitionCount = 1 << PartitionBits,
+			PartitionMask = PartitionCount - 1,
+		};
+
+		Partition _partitions[PartitionCount];
+
+		//-- For timeout checking scheduling.
+		std::mutex _scheduleMutex;
+		std::condition_variable _scheduleCondition;
+		std::atomic<int64_t> _scheduledCheckTime;
+		bool _checkRequired;
 
-		inline bool sendTCPData(TCPClientConnection* conn, std::string* data)
+		inline Partition& partition(int socket)
+		{
+			return _partitions[socket & PartitionMask];
+		}
+
+		inline void sendTCPData(TCPClientConnection* conn, std::string* data)
 		{
 			bool needWaitSendEvent = false;
 			conn->send(needWaitSendEvent, data);
 			if (needWaitSendEvent)
 				conn->waitForSendEvent();
+		}
 
-			return true;
+		inline void sendTCPData(TCPClientConnection* conn, std::vector<std::string*>& dataList)
+		{
+			bool needWaitSendEvent = false;
+			conn->send(needWaitSendEvent, dataList);
+			if (needWaitSendEvent)
+				conn->waitForSendEvent();
 		}
 
-		inline bool sendUDPData(UDPClientConnection* conn, std::string* data, int64_t expiredMS, bool discardable)
+		inline void sendUDPData(UDPClientConnection* conn, std::string* data, int64_t expiredMS, bool discardable)
 		{
 			bool needWaitSendEvent = false;
 			conn->sendData(needWaitSendEvent, data, expiredMS, discardable);
 			if (needWaitSendEvent)
 				conn->waitForSendEvent();
-
-			return true;
 		}
 
-		inline bool sendQuest(BasicConnection* conn, std::string* data, uint32_t seqNum, BasicAnswerCallback* callback, int timeout, bool discardableUDPQuest)
+		//-- MUST be called under the lock of the partition.
+		inline void registerCallback(Partition& part, BasicConnection* conn, uint32_t seqNum, BasicAnswerCallback* callback)
 		{
-			if (callback)
-				conn->_callbackMap[seqNum] = callback;
+			conn->_callbackMap[seqNum] = callback;
+			part.timeoutWheel.insert(conn, seqNum, callback);
 
-			bool status;
-			if (conn->connectionType() == BasicConnection::TCPClientConnectionType)
-				status = sendTCPData((TCPClientConnection*)conn, data);
-			else
-				status = sendUDPData((UDPClientConnection*)conn, data, slack_real_msec() + timeout, discardableUDPQuest);
-
-			if (!status && callback)
-				conn->_callbackMap.erase(seqNum);
-			
-			return status;
+			if (callback->expiredTime() < _scheduledCheckTime)
+				wakeUpTimeoutChecker();
 		}
 
-		void sendTCPClientKeepAlivePingQuest(TCPClientSharedKeepAlivePingDatas& sharedPing, std::list<TCPClientKeepAliveTimeoutInfo>& keepAliveList)
+		//-- Returned connection is pinned by _refCount, caller MUST decrease _refCount after using.
+		inline BasicConnection* signConnection(int socket, uint64_t token)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-
-			for (auto& node: keepAliveList)
+			Partition& part = partition(socket);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(socket);
+			if (it != part.connections.end() && token == (uint64_t)(it->second))
 			{
-				std::string* raw = new std::string(*(sharedPing.rawData));
-				KeepAliveCallback* callback = new KeepAliveCallback(node.conn->_connectionInfo);
-
-				callback->updateExpiredTime(slack_real_msec() + node.timeout);
-				sendQuest(node.conn, raw, sharedPing.seqNum, callback, node.timeout, false);
-				
-				node.conn->updateKeepAliveMS();
-				node.conn->_refCount--;
+				it->second->_refCount++;
+				return it->second;
 			}
+			return NULL;
 		}
 
+		void sendTCPClientKeepAlivePingQuest(TCPClientSharedKeepAlivePingDatas& sharedPing, std::list<TCPClientKeepAliveTimeoutInfo>& keepAliveList);
 		bool sendQuestWithBasicAnswerCallback(int socket, uint64_t token, FPQuestPtr quest, BasicAnswerCallback* callback, int timeout, bool discardableUDPQuest);
 
 	public:
+		ConnectionMap(): _scheduledCheckTime(0), _checkRequired(false) {}
+
 		BasicConnection* takeConnection(int fd)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(fd);
-			if (it != _connections.end())
+			Partition& part = partition(fd);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(fd);
+			if (it != part.connections.end())
 			{
 				BasicConnection* conn = it->second;
-				_connections.erase(it);
+				part.connections.erase(it);
+				part.timeoutWheel.detach(conn);
 				return conn;
 			}
 			return NULL;
@@ -98,14 +128,16 @@ namespace fpnn
 
 		BasicConnection* takeConnection(const ConnectionInfo* ci)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(ci->socket);
-			if (it != _connections.end())
+			Partition& part = partition(ci->socket);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(ci->socket);
+			if (it != part.connections.end())
 			{
 				BasicConnection* conn = it->second;
 				if ((uint64_t)conn == ci->token)
 				{
-					_connections.erase(it);
+					part.connections.erase(it);
+					part.timeoutWheel.detach(conn);
 					return conn;
 				}
 			}
@@ -114,11 +146,13 @@ namespace fpnn
 
 		bool insert(int fd, BasicConnection* connection)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(fd);
-			if (it == _connections.end())
+			Partition& part = partition(fd);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(fd);
+			if (it == part.connections.end())
 			{
-				_connections[fd] = connection;
+				part.connections[fd] = connection;
+				part.timeoutWheel.attach(connection);
 				return true;
 			}
 			return false;
@@ -126,16 +160,23 @@ namespace fpnn
 
 		void remove(int fd)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			_connections.erase(fd);
+			Partition& part = partition(fd);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(fd);
+			if (it != part.connections.end())
+			{
+				part.timeoutWheel.detach(it->second);
+				part.connections.erase(it);
+			}
 		}
 
 		BasicConnection* signConnection(int fd)
 		{
 			BasicConnection* connection = NULL;
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(fd);
-			if (it != _connections.end())
+			Partition& part = partition(fd);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(fd);
+			if (it != part.connections.end())
 			{
 				connection = it->second;
 				connection->_refCount++;
@@ -143,65 +184,77 @@ namespace fpnn
 			return connection;
 		}
 
-		void waitForEmpty()
+		//-- Returns the count of the outstanding quest callbacks of the connection. If connection is invalid, returns -1.
+		int callbackCount(int socket, uint64_t token)
 		{
-			while (_connections.size() > 0)
-				usleep(20000);
-		}
+			Partition& part = partition(socket);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(socket);
+			if (it == part.connections.end() || token != (uint64_t)(it->second))
+				return -1;
 
-		void getAllSocket(std::set<int>& fdSet)
-		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			for (auto& cmp: _connections)
-				fdSet.insert(cmp.first);
+			return (int)it->second->_callbackMap.size();
 		}
 
+		void waitForEmpty();
+		void getAllSocket(std::set<int>& fdSet);
+
 		bool sendTCPData(int socket, uint64_t token, std::string* data)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(socket);
-			if (it != _connections.end())
-			{
-				TCPClientConnection* connection = (TCPClientConnection*)(it->second);
-				if (token == (uint64_t)connection)
-					return sendTCPData(connection, data);
-			}
-			return false;
+			BasicConnection* connection = signConnection(socket, token);
+			if (connection == NULL)
+				return false;
+
+			sendTCPData((TCPClientConnection*)connection, data);
+			connection->_refCount--;
+			return true;
 		}
 
 		bool sendUDPData(int socket, uint64_t token, std::string* data, int64_t expiredMS, bool discardable)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(socket);
-			if (it != _connections.end())
-			{
-				UDPClientConnection* connection = (UDPClientConnection*)(it->second);
-				if (token == (uint64_t)connection)
-					return sendUDPData(connection, data, expiredMS, discardable);
-			}
-			return false;
+			BasicConnection* connection = signConnection(socket, token);
+			if (connection == NULL)
+				return false;
+
+			sendUDPData((UDPClientConnection*)connection, data, expiredMS, discardable);
+			connection->_refCount--;
+			return true;
 		}
 
 	protected:
 		bool sendQuest(int socket, uint64_t token, std::string* data, uint32_t seqNum, BasicAnswerCallback* callback, int timeout, bool discardableUDPQuest)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(socket);
-			if (it != _connections.end())
+			BasicConnection* connection = NULL;
 			{
-				BasicConnection* connection = it->second;
-				if (token == (uint64_t)connection)
-					return sendQuest(connection, data, seqNum, callback, timeout, discardableUDPQuest);
+				Partition& part = partition(socket);
+				std::unique_lock<std::mutex> lck(part.mutex);
+				auto it = part.connections.find(socket);
+				if (it == part.connections.end() || token != (uint64_t)(it->second))
+					return false;
+
+				connection = it->second;
+				if (callback)
+					registerCallback(part, connection, seqNum, callback);
+
+				connection->_refCount++;
 			}
-			return false;
+
+			if (connection->connectionType() == BasicConnection::TCPClientConnectionType)
+				sendTCPData((TCPClientConnection*)connection, data);
+			else
+				sendUDPData((UDPClientConnection*)connection, data, slack_real_msec() + timeout, discardableUDPQuest);
+
+			connection->_refCount--;
+			return true;
 		}
 
 	public:
 		void keepAlive(int socket, bool keepAlive)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(socket);
-			if (it != _connections.end())
+			Partition& part = partition(socket);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(socket);
+			if (it != part.connections.end())
 			{
 				BasicConnection* connection = it->second;
 				if (keepAlive && connection->connectionType() == BasicConnection::UDPClientConnectionType)
@@ -213,9 +266,10 @@ namespace fpnn
 
 		void setUDPUntransmittedSeconds(int socket, int untransmittedSeconds)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(socket);
-			if (it != _connections.end())
+			Partition& part = partition(socket);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(socket);
+			if (it != part.connections.end())
 			{
 				BasicConnection* connection = it->second;
 				if (connection->connectionType() == BasicConnection::UDPClientConnectionType)
@@ -227,9 +281,10 @@ namespace fpnn
 
 		void executeConnectionAction(int socket, std::function<void (BasicConnection* conn)> action)
 		{
-			std::unique_lock<std::mutex> lck(_mutex);
-			auto it = _connections.find(socket);
-			if (it != _connections.end())
+			Partition& part = partition(socket);
+			std::unique_lock<std::mutex> lck(part.mutex);
+			auto it = part.connections.find(socket);
+			if (it != part.connections.end())
 			{
 				BasicConnection* connection = it->second;
 				action(connection);
@@ -244,15 +299,23 @@ namespace fpnn
 	public:
 		bool embed_checkCallback(int socket, uint32_t seqNum);
 		BasicAnswerCallback* takeCallback(int socket, uint32_t seqNum);
-		void extractTimeoutedCallback(int64_t threshold, std::list<std::map<uint32_t, BasicAnswerCallback*> >& timeouted);
+		void extractTimeoutedCallback(int64_t threshold, std::list<BasicAnswerCallback*>& timeouted);
 		void extractTimeoutedConnections(int64_t threshold, std::list<BasicConnection*>& timeouted);
 
+		/*
+			Timeout checking scheduling. Only called by timeout checking thread, except wakeUpTimeoutChecker().
+			waitTimeoutChecking() will return at the nearest quest expired time or latestMsec,
+			or when a quest with earlier expired time is sent, or wakeUpTimeoutChecker() is called.
+		*/
+		void waitTimeoutChecking(int64_t latestMsec);
+		void wakeUpTimeoutChecker();
+
 		/**
 			All SendQuest():
 				If return false, caller must free quest & callback.
 				If return true, don't free quest & callback.
 		*/
-		FPAnswerPtr sendQuest(int socket, uint64_t token, std::mutex* mutex, FPQuestPtr quest, int timeout, bool discardableUDPQuest = false);
+		FPAnswerPtr sendQuest(int socket, uint64_t token, FPQuestPtr quest, int timeout, bool discardableUDPQuest = false);
 
 		inline bool sendQuest(int socket, uint64_t token, FPQuestPtr quest, AnswerCallback* callback, int timeout, bool discardableUDPQuest = false)
 		{
@@ -270,6 +333,14 @@ namespace fpnn
 			}
 		}
 
+		/*
+			TCP only. callbacks[i] is the callback of quests[i], NULL for oneway quests.
+			All quests are serialized first, then all callbacks are registered under one lock,
+			and all frames are queued as one batch and sent by gathered writev() calls.
+			If return false, no quest is sent, and caller must free the callbacks.
+		*/
+		bool sendQuests(int socket, uint64_t token, const std::vector<FPQuestPtr>& quests, const std::vector<BasicAnswerCallback*>& callbacks, int timeout);
+
 		/*===============================================================================
 		  Call by framwwork.
 		=============================================================================== */
@@ -281,4 +352,3 @@ namespace fpnn
 }
 
 #endif
-
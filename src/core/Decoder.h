@@ -9,7 +9,10 @@ namespace fpnn
 	class Decoder
 	{
 	public:
-		static FPQuestPtr decodeQuest(const char* buf, int len)
+		/*
+			If frame is not null, buf MUST be in frame, and msgpack payload will reference frame without copying.
+		*/
+		static FPQuestPtr decodeQuest(const char* buf, int len, const FPFrameBufferPtr& frame = nullptr)
 		{
 			size_t total_len = sizeof(FPMessage::Header) + FPMessage::BodyLen(buf);
 
@@ -18,7 +21,10 @@ namespace fpnn
 
 			FPQuestPtr quest = NULL;
 			try{
-				quest.reset(new FPQuest(buf,total_len));
+				if (frame)
+					quest.reset(new FPQuest(frame, buf, total_len));
+				else
+					quest.reset(new FPQuest(buf,total_len));
 			}
 			catch(const FpnnError& ex){
 				LOG_ERROR("Can not create Quest from Raw:(%d) %s", ex.code(), ex.what());
@@ -29,7 +35,7 @@ namespace fpnn
 			return quest;
 		}
 
-		static FPAnswerPtr decodeAnswer(const char* buf, int len)
+		static FPAnswerPtr decodeAnswer(const char* buf, int len, const FPFrameBufferPtr& frame = nullptr)
 		{
 			size_t total_len = sizeof(FPMessage::Header) + FPMessage::BodyLen(buf);
 
@@ -38,7 +44,10 @@ namespace fpnn
 
 			FPAnswerPtr answer = NULL;
 			try{
-				answer.reset(new FPAnswer(buf,total_len));
+				if (frame)
+					answer.reset(new FPAnswer(frame, buf, total_len));
+				else
+					answer.reset(new FPAnswer(buf,total_len));
 			}
 			catch(const FpnnError& ex){
 				LOG_ERROR("Can not create Answer from Raw:(%d) %s", ex.code(), ex.what());
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include "FPLog.h"
+#include "TimeUtil.h"
+#include "KeyExchange.h"
+#include "ECCKeysPool.h"
+
+using namespace fpnn;
+
+static std::mutex gc_ECCKeysPoolCreateMutex;
+static std::atomic<bool> _created(false);
+static ECCKeysPoolPtr _eccKeysPool;
+
+ECCKeysPoolPtr ECCKeysPool::instance()
+{
+	if (!_created)
+	{
+		std::unique_lock<std::mutex> lck(gc_ECCKeysPoolCreateMutex);
+		if (!_created)
+		{
+			_eccKeysPool.reset(new ECCKeysPool);
+			_created = true;
+		}
+	}
+	return _eccKeysPool;
+}
+
+ECCKeysPool::ECCKeysPool()
+{
+	//-- One refilling task per stock. No resident thread.
+	_threadPool.init(0, 1, 2, 4);
+}
+
+ECCKeysPool::~ECCKeysPool()
+{
+	_threadPool.release();
+}
+
+std::string ECCKeysPool::stockKey(const std::string& curve, const std::string& peerPublicKey, int keyLen)
+{
+	std::string key(curve);
+	key.append(1, ':').append(std::to_string(keyLen)).append(1, ':').append(peerPublicKey);
+	return key;
+}
+
+bool ECCKeysPool::makeKeys(const std::string& curve, const std::string& peerPublicKey, int keyLen, PreparedKeys& keys)
+{
+	ECCKeysMaker keysMaker;
+	keysMaker.setPeerPublicKey(peerPublicKey);
+	if (keysMaker.setCurve(curve) == false)
+		return false;
+
+	keys.publicKey = keysMaker.publicKey(true);
+	if (keys.publicKey.empty())
+		return false;
+
+	return keysMaker.calcKey(keys.key, keys.iv, keyLen);
+}
+
+bool ECCKeysPool::makeKeys(const std::string& curve, const std::string& peerPublicKey, int keyLen, int count, std::list<PreparedKeys>& keys)
+{
+	std::vector<std::string> publicKeys, privateKeys;
+	if (ECCKeysMaker::makeKeyPairs(curve, count, publicKeys, privateKeys) == false)
+		return false;
+
+	for (size_t i = 0; i < publicKeys.size(); i++)
+	{
+		ECCKeysMaker keysMaker;
+		keysMaker.setPeerPublicKey(peerPublicKey);
+		if (keysMaker.setCurve(curve) == false || keysMaker.setKeyPair(publicKeys[i], privateKeys[i]) == false)
+			return false;
+
+		PreparedKeys prepared;
+		prepared.publicKey = publicKeys[i];
+		if (keysMaker.calcKey(prepared.key, prepared.iv, keyLen) == false)
+			return false;
+
+		keys.push_back(prepared);
+	}
+	return true;
+}
+
+void ECCKeysPool::refillFailed(Stock& stock, const char* reason)
+{
+	int64_t backoff = RetryBackoffMaxMsec;
+	if (stock.failedCount < 6)
+		backoff = std::min((int64_t)RetryBackoffMinMsec << stock.failedCount, (int64_t)RetryBackoffMaxMsec);
+
+	stock.failedCount += 1;
+	stock.retryAfterMsec = TimeUtil::steady_msec() + backoff;
+
+	LOG_ERROR("%s Curve %s, key length %d. Failed %d times, retry after %d ms.", reason,
+		stock.curve.c_str(), stock.keyLen, stock.failedCount, (int)backoff);
+}
+
+void ECCKeysPool::launchRefilling(const std::string& stockKey, Stock& stock)
+{
+	if (stock.refilling || stock.keys.size() >= stock.reserved)
+		return;
+
+	if (stock.failedCount && stock.retryAfterMsec > TimeUtil::steady_msec())
+		return;
+
+	stock.refilling = _threadPool.wakeUp([this, stockKey](){ refill(stockKey); });
+	if (!stock.refilling)
+		refillFailed(stock, "Launch ECC keys refilling task failed.");
+}
+
+void ECCKeysPool::refill(const std::string& stockKey)
+{
+	std::string curve, peerPublicKey;
+	int keyLen;
+	size_t required;
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		auto it = _stocks.find(stockKey);
+		if (it == _stocks.end())
+			return;
+
+		curve = it->second.curve;
+		peerPublicKey = it->second.peerPublicKey;
+		keyLen = it->second.keyLen;
+		required = it->second.reserved - it->second.keys.size();
+	}
+
+	while (true)
+	{
+		std::list<PreparedKeys> keys;
+		int count = (required < (size_t)RefillBatchSize) ? (int)required : (int)RefillBatchSize;
+		bool made = makeKeys(curve, peerPublicKey, keyLen, count, keys);
+
+		std::unique_lock<std::mutex> lck(_mutex);
+		auto it = _stocks.find(stockKey);
+		if (it == _stocks.end())
+			return;
+
+		Stock& stock = it->second;
+		if (!made)
+		{
+			stock.refilling = false;
+			refillFailed(stock, "Prepare ECC keys failed.");
+			return;
+		}
+
+		stock.failedCount = 0;
+
+		while (keys.size() && stock.keys.size() < stock.reserved)
+		{
+			stock.keys.push_back(keys.front());
+			keys.pop_front();
+		}
+
+		if (stock.keys.size() >= stock.reserved)
+		{
+			stock.refilling = false;
+			return;
+		}
+
+		required = stock.reserved - stock.keys.size();
+	}
+}
+
+void ECCKeysPool::reserve(const std::string& curve, const std::string& peerPublicKey, int keyLen, size_t count)
+{
+	if (count == 0)
+		return;
+
+	std::string key = stockKey(curve, peerPublicKey, keyLen);
+
+	std::unique_lock<std::mutex> lck(_mutex);
+	Stock& stock = _stocks[key];
+	if (stock.reserved == 0)
+	{
+		stock.curve = curve;
+		stock.peerPublicKey = peerPublicKey;
+		stock.keyLen = keyLen;
+	}
+
+	if (stock.reserved < count)
+		stock.reserved = count;
+
+	launchRefilling(key, stock);
+}
+
+bool ECCKeysPool::take(const std::string& curve, const std::string& peerPublicKey, int keyLen, PreparedKeys& keys)
+{
+	std::string key = stockKey(curve, peerPublicKey, keyLen);
+
+	std::unique_lock<std::mutex> lck(_mutex);
+	auto it = _stocks.find(key);
+	if (it == _stocks.end())
+		return false;
+
+	Stock& stock = it->second;
+	bool taken = false;
+	if (stock.keys.size())
+	{
+		keys = stock.keys.front();
+		stock.keys.pop_front();
+		taken = true;
+	}
+
+	launchRefilling(key, stock);
+	return taken;
+}
+
+size_t ECCKeysPool::stockSize(const std::string& curve, const std::string& peerPublicKey, int keyLen)
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+	auto it = _stocks.find(stockKey(curve, peerPublicKey, keyLen));
+	if (it == _stocks.end())
+		return 0;
+
+	return it->second.keys.size();
+}
+
+void ECCKeysPool::clear()
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+	_stocks.clear();
+}
@@ -0,0 +1,100 @@
+#ifndef FPNN_ECC_Keys_Pool_H
+#define FPNN_ECC_Keys_Pool_H
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include "TaskThreadPool.h"
+
+namespace fpnn
+{
+	class ECCKeysPool;
+	typedef std::shared_ptr<ECCKeysPool> ECCKeysPoolPtr;
+
+	/*
+		Background pool of prepared client side ECDH results.
+
+		The server public key of a client is fixed, so the whole client side key exchanging (ephemeral key pair
+		generating & shared secret calculating) can be done before connecting. Connecting takes a prepared result,
+		and only sends the handshake quest. No scalar multiplication is on the connecting path.
+
+		*. Each prepared result is used by one connection only. It is removed from the pool when taken.
+		*. Results are stocked by (curve, peer public key, AES key length). Clients with the same parameters share
+			one stock, and the stock size is the max count reserved by them.
+		*. Stocks are refilled in the pool's own thread pool in batches, when a result is taken.
+		*. If refilling failed, the stock isn't refilled again until the backoff expired. The backoff starts
+			from 1 second, and doubles on each failure up to 60 seconds. Meanwhile, take() returns false
+			if the stock is empty, and the caller makes the keys itself.
+	*/
+	class ECCKeysPool
+	{
+	public:
+		struct PreparedKeys
+		{
+			std::string publicKey;		//-- Self public key, in binary format.
+			uint8_t key[32];
+			uint8_t iv[16];
+		};
+
+	private:
+		enum
+		{
+			RefillBatchSize = 16,
+			RetryBackoffMinMsec = 1000,
+			RetryBackoffMaxMsec = 60 * 1000,
+		};
+
+		struct Stock
+		{
+			std::string curve;
+			std::string peerPublicKey;
+			int keyLen;
+			size_t reserved;
+			bool refilling;
+			int failedCount;				//-- Continuous failed refilling.
+			int64_t retryAfterMsec;			//-- Steady clock.
+			std::list<PreparedKeys> keys;
+
+			Stock(): keyLen(0), reserved(0), refilling(false), failedCount(0), retryAfterMsec(0) {}
+		};
+
+		std::mutex _mutex;
+		std::unordered_map<std::string, Stock> _stocks;
+		TaskThreadPool _threadPool;
+
+		ECCKeysPool();
+		static std::string stockKey(const std::string& curve, const std::string& peerPublicKey, int keyLen);
+		//-- MUST be called under the lock.
+		void launchRefilling(const std::string& stockKey, Stock& stock);
+		//-- MUST be called under the lock.
+		void refillFailed(Stock& stock, const char* reason);
+		void refill(const std::string& stockKey);
+
+	public:
+		~ECCKeysPool();
+
+		static ECCKeysPoolPtr instance();
+
+		/*
+			Does the whole client side ECDH in current thread.
+			keyLen: 16 or 32.
+		*/
+		static bool makeKeys(const std::string& curve, const std::string& peerPublicKey, int keyLen, PreparedKeys& keys);
+		//-- Batched version. The key pairs are generated by ECCKeysMaker::makeKeyPairs(). Results are appended to keys.
+		static bool makeKeys(const std::string& curve, const std::string& peerPublicKey, int keyLen, int count, std::list<PreparedKeys>& keys);
+
+		//-- Raises the stock size to count at least, and starts refilling.
+		void reserve(const std::string& curve, const std::string& peerPublicKey, int keyLen, size_t count);
+
+		//-- Returns false if the stock is empty or isn't reserved. The caller should call makeKeys() instead.
+		bool take(const std::string& curve, const std::string& peerPublicKey, int keyLen, PreparedKeys& keys);
+
+		size_t stockSize(const std::string& curve, const std::string& peerPublicKey, int keyLen);
+		void clear();
+	};
+}
+
+#endif
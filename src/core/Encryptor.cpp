@@ -9,10 +9,7 @@ void PackageEncryptor::decrypt(uint8_t* dest, uint8_t* src, int len)
 	memcpy(iv, _iv, 16);
 
 	size_t pos = 0;
-	rijndael_context deCtx;
-	rijndael_setup_encrypt(&deCtx, _key, _keyLen);
-
-	rijndael_cfb_encrypt(&deCtx, false, src, dest, len, iv, &pos);
+	rijndael_cfb_encrypt(&_ctx, false, src, dest, len, iv, &pos);
 }
 
 void PackageEncryptor::encrypt(uint8_t* dest, uint8_t* src, int len)
@@ -21,10 +18,7 @@ void PackageEncryptor::encrypt(uint8_t* dest, uint8_t* src, int len)
 	memcpy(iv, _iv, 16);
 
 	size_t pos = 0;
-	rijndael_context enCtx;
-	rijndael_setup_encrypt(&enCtx, _key, _keyLen);
-
-	rijndael_cfb_encrypt(&enCtx, true, src, dest, len, iv, &pos);
+	rijndael_cfb_encrypt(&_ctx, true, src, dest, len, iv, &pos);
 }
 
 void PackageEncryptor::encrypt(std::string* buffer)
@@ -33,17 +27,16 @@ void PackageEncryptor::encrypt(std::string* buffer)
 	memcpy(iv, _iv, 16);
 
 	size_t pos = 0;
-	rijndael_context enCtx;
-	rijndael_setup_encrypt(&enCtx, _key, _keyLen);
-
 	const size_t int32Len = sizeof(int32_t);
-	size_t buf_len = buffer->length() + int32Len;
-	char* buf = (char*)malloc(buf_len);
+	uint32_t len = (uint32_t)buffer->length();
 
-	*((uint32_t*)buf) = htole32((uint32_t)(buffer->length()));
-	rijndael_cfb_encrypt(&enCtx, true, (uint8_t *)buffer->data(), (uint8_t *)(buf + int32Len), buffer->length(), iv, &pos);
-	buffer->assign(buf, buf_len);
-	free(buf);
+	buffer->insert(0, int32Len, '\0');
+
+	uint8_t* data = (uint8_t *)&((*buffer)[0]);
+	uint32_t lenLE = htole32(len);
+	memcpy(data, &lenLE, int32Len);
+
+	rijndael_cfb_encrypt(&_ctx, true, data + int32Len, data + int32Len, len, iv, &pos);
 }
 
 void StreamEncryptor::decrypt(uint8_t* dest, uint8_t* src, int len)
@@ -58,9 +51,9 @@ void StreamEncryptor::encrypt(uint8_t* dest, uint8_t* src, int len)
 
 void StreamEncryptor::encrypt(std::string* buffer)
 {
-	size_t buf_len = buffer->length();
-	char* buf = (char*)malloc(buf_len);
-	rijndael_cfb_encrypt(&_ctx, true, (uint8_t *)buffer->data(), (uint8_t *)buf, buffer->length(), _iv, &_pos);
-	buffer->assign(buf, buf_len);
-	free(buf);
+	if (buffer->empty())
+		return;
+
+	uint8_t* data = (uint8_t *)&((*buffer)[0]);
+	rijndael_cfb_encrypt(&_ctx, true, data, data, buffer->length(), _iv, &_pos);
 }
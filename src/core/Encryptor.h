@@ -29,11 +29,21 @@ namespace fpnn
 		virtual void encrypt(std::string* buffer) = 0;
 	};
 
+	/*
+		Each package is encrypted from the initial IV. The key schedule is expanded once per connection.
+		encrypt(std::string*) inserts the package length before the package, which moves the whole package.
+		SendBuffer encrypts packages in place by encrypt(dest, src, len) instead, and sends the length separately.
+	*/
 	class PackageEncryptor: public Encryptor
 	{
+		rijndael_context _ctx;
+
 	public:
 		PackageEncryptor(uint8_t *key, size_t key_len, uint8_t *iv):
-			Encryptor(key, key_len, iv) {}
+			Encryptor(key, key_len, iv)
+		{
+			rijndael_setup_encrypt(&_ctx, (const uint8_t *)_key, key_len);
+		}
 		virtual ~PackageEncryptor() {}
 
 		virtual void decrypt(uint8_t* dest, uint8_t* src, int len);
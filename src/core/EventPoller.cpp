@@ -0,0 +1,256 @@
+#include <sys/select.h>
+#ifdef __linux__
+	#include <sys/epoll.h>
+#endif
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <map>
+#include "FPLog.h"
+#include "EventPoller.h"
+
+using namespace fpnn;
+
+EventPoller* EventPoller::create(int notifyFd, bool useSelect)
+{
+#ifdef __linux__
+	if (!useSelect)
+	{
+		EventPoller* poller = new EpollPoller(notifyFd);
+		if (poller->init())
+			return poller;
+
+		delete poller;
+		LOG_WARN("Create epoll poller failed, errno: %d. Select poller will be used.", errno);
+	}
+#else
+	(void)useSelect;
+#endif
+
+	EventPoller* poller = new SelectPoller(notifyFd);
+	poller->init();
+	return poller;
+}
+
+//================================//
+//--        SelectPoller        --//
+//================================//
+bool SelectPoller::acceptable(int fd) const
+{
+	return fd < FD_SETSIZE;
+}
+
+bool SelectPoller::add(int fd)
+{
+	_allSocket.insert(fd);
+	return true;
+}
+
+void SelectPoller::remove(int fd)
+{
+	_allSocket.erase(fd);
+	_wantWriteSocket.erase(fd);
+}
+
+void SelectPoller::waitWrite(int fd)
+{
+	_wantWriteSocket.insert(fd);
+}
+
+void SelectPoller::cancelWrite(int fd)
+{
+	_wantWriteSocket.erase(fd);
+}
+
+int SelectPoller::wait(std::vector<PolledEvent>& events, bool& notified)
+{
+	fd_set rfds;
+	fd_set wfds;
+	fd_set efds;
+
+	FD_ZERO(&rfds);
+	FD_ZERO(&wfds);
+	FD_ZERO(&efds);
+
+	int maxfd = _notifyFd;
+
+	FD_SET(_notifyFd, &rfds);
+	for (int socket: _allSocket)
+	{
+		FD_SET(socket, &rfds);
+		FD_SET(socket, &efds);
+
+		if (socket > maxfd)
+			maxfd = socket;
+	}
+
+	for (int socket: _wantWriteSocket)
+		FD_SET(socket, &wfds);
+
+	int activeCount = select(maxfd + 1, &rfds, &wfds, &efds, NULL);
+	if (activeCount <= 0)
+		return activeCount;
+
+	notified = FD_ISSET(_notifyFd, &rfds);
+
+	std::map<int, PolledEvent> connStatus;
+	for (int socket: _allSocket)
+	{
+		if (FD_ISSET(socket, &efds))
+		{
+			FD_CLR(socket, &wfds);
+			connStatus.emplace(socket, PolledEvent(socket)).first->second.error = true;
+		}
+		else if (FD_ISSET(socket, &rfds))
+			connStatus.emplace(socket, PolledEvent(socket)).first->second.canRead = true;
+	}
+
+	for (int socket: _wantWriteSocket)
+		if (FD_ISSET(socket, &wfds))
+			connStatus.emplace(socket, PolledEvent(socket)).first->second.canWrite = true;
+
+	for (auto& csp: connStatus)
+		events.push_back(csp.second);
+
+	return activeCount;
+}
+
+#ifdef __linux__
+//================================//
+//--        EpollPoller         --//
+//================================//
+EpollPoller::~EpollPoller()
+{
+	if (_epollFd >= 0)
+		close(_epollFd);
+
+	if (_events)
+		free(_events);
+}
+
+bool EpollPoller::init()
+{
+	_epollFd = epoll_create(_maxEvents);
+	if (_epollFd < 0)
+		return false;
+
+	_events = (struct epoll_event*)malloc(sizeof(struct epoll_event) * _maxEvents);
+
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.fd = _notifyFd;
+
+	return epoll_ctl(_epollFd, EPOLL_CTL_ADD, _notifyFd, &ev) == 0;
+}
+
+bool EpollPoller::modify(int fd, bool wantWrite)
+{
+	struct epoll_event ev;
+	ev.events = EPOLLIN | EPOLLPRI | EPOLLRDHUP;
+	if (wantWrite)
+		ev.events |= EPOLLOUT;
+
+	ev.data.fd = fd;
+
+	return epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+bool EpollPoller::add(int fd)
+{
+	struct epoll_event ev;
+	ev.events = EPOLLIN | EPOLLPRI | EPOLLRDHUP;
+	ev.data.fd = fd;
+
+	if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+	{
+		//-- fd number reused before the old one removed from the interest list.
+		if (errno != EEXIST || !modify(fd, false))
+		{
+			LOG_ERROR("Add socket %d into epoll failed, errno: %d", fd, errno);
+			return false;
+		}
+	}
+
+	_interests[fd] = false;
+	return true;
+}
+
+void EpollPoller::remove(int fd)
+{
+	auto it = _interests.find(fd);
+	if (it == _interests.end())
+		return;
+
+	_interests.erase(it);
+
+	struct epoll_event ev;		//-- For kernel before 2.6.9.
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+void EpollPoller::waitWrite(int fd)
+{
+	auto it = _interests.find(fd);
+	if (it == _interests.end() || it->second)
+		return;
+
+	if (modify(fd, true))
+		it->second = true;
+}
+
+void EpollPoller::cancelWrite(int fd)
+{
+	auto it = _interests.find(fd);
+	if (it == _interests.end() || !it->second)
+		return;
+
+	if (modify(fd, false))
+		it->second = false;
+}
+
+int EpollPoller::wait(std::vector<PolledEvent>& events, bool& notified)
+{
+	int activeCount = epoll_wait(_epollFd, _events, _maxEvents, -1);
+	if (activeCount <= 0)
+		return activeCount;
+
+	for (int i = 0; i < activeCount; i++)
+	{
+		int fd = _events[i].data.fd;
+		uint32_t flags = _events[i].events;
+
+		if (fd == _notifyFd)
+		{
+			notified = true;
+			continue;
+		}
+
+		auto it = _interests.find(fd);
+		if (it == _interests.end())
+			continue;
+
+		PolledEvent event(fd);
+
+		//-- Keep the same semantics as select(): exceptional condition means dropped.
+		if (flags & EPOLLPRI)
+			event.error = true;
+		else
+		{
+			if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+				event.canRead = true;
+
+			if (it->second && (flags & (EPOLLOUT | EPOLLERR)))
+				event.canWrite = true;
+		}
+
+		events.push_back(event);
+	}
+
+	if (activeCount == _maxEvents)
+	{
+		_maxEvents *= 2;
+		_events = (struct epoll_event*)realloc(_events, sizeof(struct epoll_event) * _maxEvents);
+	}
+
+	return activeCount;
+}
+#endif
@@ -0,0 +1,113 @@
+#ifndef FPNN_Event_Poller_H
+#define FPNN_Event_Poller_H
+
+#include <set>
+#include <vector>
+#include <unordered_map>
+
+#ifdef __linux__
+struct epoll_event;
+#endif
+
+namespace fpnn
+{
+	struct PolledEvent
+	{
+		int fd;
+		bool canRead;
+		bool canWrite;
+		bool error;
+
+		PolledEvent(int fd_): fd(fd_), canRead(false), canWrite(false), error(false) {}
+	};
+
+	/*
+		Event poller for ClientEngine loop.
+
+		!!! IMPORTANT !!!
+		All functions, except acceptable(), MUST be called in the loop thread only.
+		Write interest is one-shot: loop thread will cancel it after the write event triggered.
+	*/
+	class EventPoller
+	{
+	protected:
+		int _notifyFd;
+
+	public:
+		EventPoller(int notifyFd): _notifyFd(notifyFd) {}
+		virtual ~EventPoller() {}
+
+		virtual bool init() = 0;
+		virtual bool acceptable(int fd) const { return true; }
+
+		virtual bool add(int fd) = 0;
+		virtual void remove(int fd) = 0;
+		virtual void waitWrite(int fd) = 0;
+		virtual void cancelWrite(int fd) = 0;
+
+		/**
+			Returned value is same as select() & epoll_wait().
+			notified: the notify fd is readable.
+		*/
+		virtual int wait(std::vector<PolledEvent>& events, bool& notified) = 0;
+		virtual const char* name() const = 0;
+
+		/** If epoll is unavailable or useSelect is true, select poller will be returned. */
+		static EventPoller* create(int notifyFd, bool useSelect);
+	};
+
+	//================================//
+	//--        SelectPoller        --//
+	//================================//
+	class SelectPoller: public EventPoller
+	{
+		std::set<int> _allSocket; //-- except _notifyFd.
+		std::set<int> _wantWriteSocket;
+
+	public:
+		SelectPoller(int notifyFd): EventPoller(notifyFd) {}
+		virtual ~SelectPoller() {}
+
+		virtual bool init() { return true; }
+		virtual bool acceptable(int fd) const;
+
+		virtual bool add(int fd);
+		virtual void remove(int fd);
+		virtual void waitWrite(int fd);
+		virtual void cancelWrite(int fd);
+
+		virtual int wait(std::vector<PolledEvent>& events, bool& notified);
+		virtual const char* name() const { return "select"; }
+	};
+
+#ifdef __linux__
+	//================================//
+	//--        EpollPoller         --//
+	//================================//
+	class EpollPoller: public EventPoller
+	{
+		int _epollFd;
+		int _maxEvents;
+		struct epoll_event* _events;
+		std::unordered_map<int, bool> _interests;		//-- fd: wantWrite
+
+		bool modify(int fd, bool wantWrite);
+
+	public:
+		EpollPoller(int notifyFd): EventPoller(notifyFd), _epollFd(-1), _maxEvents(1024), _events(NULL) {}
+		virtual ~EpollPoller();
+
+		virtual bool init();
+
+		virtual bool add(int fd);
+		virtual void remove(int fd);
+		virtual void waitWrite(int fd);
+		virtual void cancelWrite(int fd);
+
+		virtual int wait(std::vector<PolledEvent>& events, bool& notified);
+		virtual const char* name() const { return "epoll"; }
+	};
+#endif
+}
+
+#endif
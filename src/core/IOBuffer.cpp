@@ -1,4 +1,5 @@
 #include <errno.h>
+#include <limits.h>
 #include "Endian.h"
 #include "IOBuffer.h"
 
@@ -18,49 +19,121 @@ bool RecvBuffer::entryEncryptMode(uint8_t *key, size_t key_len, uint8_t *iv, boo
 	return true;
 }
 
-void SendBuffer::encryptData()
+/*
+	Stream mode: the cipher state depends on the sending order, so buffers are encrypted by the send token holder
+	when they are gathered into _sendingQueue.
+*/
+void SendBuffer::encryptData(std::string* buffer)
 {
-	if (_sentPackage > 0)
-		_encryptor->encrypt(_currBuffer);
+	if (_processedPackage > 0)
+		_encryptor->encrypt(buffer);
 	else
 	{
 		if (!_encryptAfterFirstPackage)
-			_encryptor->encrypt(_currBuffer);
+			_encryptor->encrypt(buffer);
 	}
 }
 
+/*
+	Package mode: every package is encrypted with the initial IV, independent of the others. So packages are encrypted
+	by the sending threads before they are queued, and the IO thread only writes ciphertext.
+	The plain first package (key exchanging quest) is queued before the connection joins the engine, so no package
+	races with it.
+	The package is encrypted in place, and its length prefix is kept in the unit and sent by a separate iovec.
+*/
+void SendBuffer::encryptPackage(SendUnit& unit)
+{
+	if (_encryptAfterFirstPackage && !_firstPackageQueued)
+		return;
+
+	uint8_t* data = (uint8_t *)&((*unit.data)[0]);
+	_packageEncryptor->encrypt(data, data, (int)unit.data->length());
+
+	unit.lengthLE = htole32((uint32_t)unit.data->length());
+	unit.prefixed = true;
+}
+
+//-- MUST be called under the lock.
+void SendBuffer::queueData(const SendUnit& unit)
+{
+	_outQueue.push(unit);
+	_firstPackageQueued = true;
+}
+
+/*
+	Queued buffers are gathered into _sendingQueue in order, and processed (encrypted) one by one when gathered.
+	Then they are sent by one writev() call, up to IOV_MAX iovecs. An encrypted package takes two iovecs,
+	one for the length prefix.
+*/
 int SendBuffer::realSend(int fd, bool& needWaitSendEvent)
 {
+	const size_t maxBatchCount = (IOV_MAX < 1024) ? IOV_MAX : 1024;
+	const size_t prefixLen = sizeof(uint32_t);
 	uint64_t currSendBytes = 0;
 
 	needWaitSendEvent = false;
 	while (true)
 	{
-		if (_currBuffer == NULL)
+		if (_sendingQueue.size() < maxBatchCount)
 		{
+			size_t gatheredBegin = _sendingQueue.size();
 			CurrBufferProcessFunc currBufferProcess;
 			{
 				std::unique_lock<std::mutex> lck(*_mutex);
-				if (_outQueue.size() == 0)
+				if (_outQueue.size() == 0 && _sendingQueue.size() == 0)
 				{
 					_sentBytes += currSendBytes;
 					_sendToken = true;
 					return 0;
 				}
 
-				_currBuffer = _outQueue.front();
-				_outQueue.pop();
-				_offset = 0;
+				while (_outQueue.size() && _sendingQueue.size() < maxBatchCount)
+				{
+					_sendingQueue.push_back(_outQueue.front());
+					_outQueue.pop();
+				}
 
 				currBufferProcess = _currBufferProcess;
 			}
 
 			if (currBufferProcess)
-				(this->*currBufferProcess)();
+			{
+				for (size_t i = gatheredBegin; i < _sendingQueue.size(); i++)
+				{
+					(this->*currBufferProcess)(_sendingQueue[i].data);
+					_processedPackage += 1;
+				}
+			}
+			else
+				_processedPackage += _sendingQueue.size() - gatheredBegin;
 		}
 
-		size_t requireSend = _currBuffer->length() - _offset;
-		ssize_t sendBytes = write(fd, _currBuffer->data() + _offset, requireSend);
+		_iovecs.clear();
+		for (size_t i = 0; i < _sendingQueue.size() && _iovecs.size() + 2 <= maxBatchCount; i++)
+		{
+			SendUnit& unit = _sendingQueue[i];
+			size_t skip = (i == 0) ? _offset : 0;
+			struct iovec vec;
+
+			if (unit.prefixed)
+			{
+				if (skip < prefixLen)
+				{
+					vec.iov_base = (void*)((char*)&unit.lengthLE + skip);
+					vec.iov_len = prefixLen - skip;
+					_iovecs.push_back(vec);
+					skip = 0;
+				}
+				else
+					skip -= prefixLen;
+			}
+
+			vec.iov_base = (void*)(unit.data->data() + skip);
+			vec.iov_len = unit.data->length() - skip;
+			_iovecs.push_back(vec);
+		}
+
+		ssize_t sendBytes = writev(fd, &(_iovecs[0]), (int)_iovecs.size());
 		if (sendBytes == -1)
 		{
 			if (errno == EAGAIN || errno == EWOULDBLOCK)
@@ -81,12 +154,22 @@ int SendBuffer::realSend(int fd, bool& needWaitSendEvent)
 		}
 		else
 		{
-			_offset += (size_t)sendBytes;
 			currSendBytes += (uint64_t)sendBytes;
-			if (_offset == _currBuffer->length())
+
+			size_t remained = (size_t)sendBytes;
+			while (remained > 0)
 			{
-				delete _currBuffer;
-				_currBuffer = NULL;
+				SendUnit& unit = _sendingQueue.front();
+				size_t unsent = unit.length() - _offset;
+				if (remained < unsent)
+				{
+					_offset += remained;
+					break;
+				}
+
+				remained -= unsent;
+				delete unit.data;
+				_sendingQueue.pop_front();
 				_offset = 0;
 				_sentPackage += 1;
 			}
@@ -102,10 +185,14 @@ int SendBuffer::send(int fd, bool& needWaitSendEvent, std::string* data)
 		data = NULL;
 	}
 
+	SendUnit unit(data);
+	if (data && _packageEncryptor)
+		encryptPackage(unit);
+
 	{
 		std::unique_lock<std::mutex> lck(*_mutex);
 		if (data)
-			_outQueue.push(data);
+			queueData(unit);
 
 		if (!_sendToken)
 			return 0;
@@ -118,24 +205,66 @@ int SendBuffer::send(int fd, bool& needWaitSendEvent, std::string* data)
 	return err;
 }
 
+int SendBuffer::send(int fd, bool& needWaitSendEvent, std::vector<std::string*>& dataList)
+{
+	std::vector<SendUnit> units;
+	units.reserve(dataList.size());
+	for (std::string* data: dataList)
+	{
+		if (data->empty())
+		{
+			delete data;
+			continue;
+		}
+
+		units.push_back(SendUnit(data));
+		if (_packageEncryptor)
+			encryptPackage(units.back());
+	}
+	dataList.clear();
+
+	{
+		std::unique_lock<std::mutex> lck(*_mutex);
+		for (SendUnit& unit: units)
+			queueData(unit);
+
+		if (!_sendToken)
+			return 0;
+
+		_sendToken = false;
+	}
+
+	//-- Token will be return in realSend() function.
+	return realSend(fd, needWaitSendEvent);
+}
+
 bool SendBuffer::entryEncryptMode(uint8_t *key, size_t key_len, uint8_t *iv, bool streamMode)
 {
 	if (_encryptor)
 		return false;
 
 	Encryptor* encryptor = NULL;
+	PackageEncryptor* packageEncryptor = NULL;
 	if (streamMode)
 		encryptor = new StreamEncryptor(key, key_len, iv);
 	else
-		encryptor = new PackageEncryptor(key, key_len, iv);
+	{
+		packageEncryptor = new PackageEncryptor(key, key_len, iv);
+		encryptor = packageEncryptor;
+	}
 
 	{
 		std::unique_lock<std::mutex> lck(*_mutex);
-		if (_sentBytes) return false;
-		if (_sendToken == false) return false;
+		if (_sentBytes || _sendToken == false || _outQueue.size())
+		{
+			delete encryptor;
+			return false;
+		}
 
 		_encryptor = encryptor;
-		_currBufferProcess = &SendBuffer::encryptData;
+		_packageEncryptor = packageEncryptor;
+		if (streamMode)
+			_currBufferProcess = &SendBuffer::encryptData;
 	}
 
 	return true;
@@ -149,7 +278,11 @@ void SendBuffer::appendData(std::string* data)
 		return;
 	}
 
+	SendUnit unit(data);
+	if (data && _packageEncryptor)
+		encryptPackage(unit);
+
 	std::unique_lock<std::mutex> lck(*_mutex);
 	if (data)
-		_outQueue.push(data);
+		queueData(unit);
 }
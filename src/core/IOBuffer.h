@@ -5,7 +5,10 @@
 #include <atomic>
 #include <string>
 #include <queue>
+#include <deque>
+#include <vector>
 #include <mutex>
+#include <sys/uio.h>
 #include <memory>
 #include "FPMessage.h"
 #include "Receiver.h"
@@ -83,39 +86,59 @@ namespace fpnn
 
 	class SendBuffer
 	{
-		typedef void (SendBuffer::* CurrBufferProcessFunc)();
+		typedef void (SendBuffer::* CurrBufferProcessFunc)(std::string* buffer);
+
+		/*
+			In package mode, the encrypted package is prefixed by its length. The length is sent by its own iovec,
+			so the package is encrypted in place, without moving it for the prefix.
+		*/
+		struct SendUnit
+		{
+			std::string* data;
+			uint32_t lengthLE;		//-- Little endian length prefix, only for encrypted packages.
+			bool prefixed;
+
+			explicit SendUnit(std::string* data_): data(data_), lengthLE(0), prefixed(false) {}
+			inline size_t length() const { return data->length() + (prefixed ? sizeof(uint32_t) : 0); }
+		};
 
 	private:
 		std::mutex* _mutex;		//-- only using for sendBuffer and sendToken
 		bool _sendToken;
 
-		size_t _offset;
-		std::string* _currBuffer;
-		std::queue<std::string*> _outQueue;
+		size_t _offset;							//-- Sent bytes of the first unit in _sendingQueue, including the length prefix.
+		std::deque<SendUnit> _sendingQueue;		//-- Processed (encrypted) buffers. Only accessed by the token holder.
+		std::vector<struct iovec> _iovecs;
+		std::queue<SendUnit> _outQueue;
 		uint64_t _sentBytes;		//-- Total Bytes
 		uint64_t _sentPackage;
+		uint64_t _processedPackage;
 		bool _encryptAfterFirstPackage;
+		std::atomic<bool> _firstPackageQueued;
 		Encryptor* _encryptor;
+		PackageEncryptor* _packageEncryptor;		//-- Same object as _encryptor in package mode, else NULL.
 
 		CurrBufferProcessFunc _currBufferProcess;
 
-		void encryptData();
+		void encryptData(std::string* buffer);
+		void encryptPackage(SendUnit& unit);
+		void queueData(const SendUnit& unit);
 		int realSend(int fd, bool& needWaitSendEvent);
 
 	public:
-		SendBuffer(std::mutex* mutex): _mutex(mutex), _sendToken(true), _offset(0), _currBuffer(0),
-			_sentBytes(0), _sentPackage(0), _encryptAfterFirstPackage(false), _encryptor(NULL), _currBufferProcess(NULL) {}
+		SendBuffer(std::mutex* mutex): _mutex(mutex), _sendToken(true), _offset(0), _sentBytes(0), _sentPackage(0),
+			_processedPackage(0), _encryptAfterFirstPackage(false), _firstPackageQueued(false), _encryptor(NULL),
+			_packageEncryptor(NULL), _currBufferProcess(NULL) {}
 		~SendBuffer()
 		{
 			while (_outQueue.size())
 			{
-				std::string* data = _outQueue.front();
+				delete _outQueue.front().data;
 				_outQueue.pop();
-				delete data;
 			}
 
-			if (_currBuffer)
-				delete _currBuffer;
+			for (SendUnit& unit: _sendingQueue)
+				delete unit.data;
 
 			if (_encryptor)
 				delete _encryptor;
@@ -128,6 +151,8 @@ namespace fpnn
 
 		/** returned INT: id 0, success, else, is errno. */
 		int send(int fd, bool& needWaitSendEvent, std::string* data = NULL);
+		//-- All buffers are queued under one lock, and sent by the gathered writev() calls. dataList will be cleared.
+		int send(int fd, bool& needWaitSendEvent, std::vector<std::string*>& dataList);
 		bool entryEncryptMode(uint8_t *key, size_t key_len, uint8_t *iv, bool streamMode);
 		void encryptAfterFirstPackage() { _encryptAfterFirstPackage = true; }
 		void appendData(std::string* data);
@@ -12,7 +12,7 @@ namespace fpnn
 	class IReleaseable
 	{
 	public:
-		virtual bool releaseable(uint64_t currentLoopTicket) = 0;
+		virtual bool releaseable() = 0;
 		virtual ~IReleaseable() {}
 	};
 	typedef std::shared_ptr<IReleaseable> IReleaseablePtr;
@@ -114,9 +114,11 @@ namespace fpnn
 		std::unordered_map<uint32_t, BasicAnswerCallback*> _callbackMap;
 
 		uint64_t _quitEngineLoopTicket;
+		const std::atomic<uint64_t>* _engineLoopTicket;		//-- Loop ticket of the IO loop which the connection belongs to.
 
 	public:
-		BasicConnection(ConnectionInfoPtr connectionInfo): _connectionInfo(connectionInfo), _refCount(0), _quitEngineLoopTicket(0)
+		BasicConnection(ConnectionInfoPtr connectionInfo): _connectionInfo(connectionInfo), _refCount(0),
+			_quitEngineLoopTicket(0), _engineLoopTicket(NULL)
 		{
 			_connectionInfo->token = (uint64_t)this;	//-- if use Virtual Derive, must redo this in subclass constructor.
 			_activeTime = time(NULL);
@@ -129,11 +131,11 @@ namespace fpnn
 
 		virtual bool waitForSendEvent() = 0;
 		virtual enum ConnectionType connectionType() = 0;
-		virtual bool releaseable(uint64_t currentLoopTicket)
+		virtual bool releaseable()
 		{
 			if (_quitEngineLoopTicket > 0)
 			{
-				if (currentLoopTicket - _quitEngineLoopTicket > 1) ;
+				if (*_engineLoopTicket - _quitEngineLoopTicket > 1) ;
 				else
 					return false;
 			}
@@ -6,31 +6,41 @@
 
 using namespace fpnn;
 
-bool ECCKeysMaker::setCurve(const std::string& curve)
+static uECC_Curve curveByName(const std::string& curve, int& secertLen)
 {
 	if (curve == "secp256k1")
 	{
-		_curve = uECC_secp256k1();
-		_secertLen = 32;
+		secertLen = 32;
+		return uECC_secp256k1();
 	}
 	else if (curve == "secp256r1")
 	{
-		_curve = uECC_secp256r1();
-		_secertLen = 32;
+		secertLen = 32;
+		return uECC_secp256r1();
 	}
 	else if (curve == "secp224r1")
 	{
-		_curve = uECC_secp224r1();
-		_secertLen = 28;
+		secertLen = 28;
+		return uECC_secp224r1();
 	}
 	else if (curve == "secp192r1")
 	{
-		_curve = uECC_secp192r1();
-		_secertLen = 24;
+		secertLen = 24;
+		return uECC_secp192r1();
 	}
 	else
+		return NULL;
+}
+
+bool ECCKeysMaker::setCurve(const std::string& curve)
+{
+	int secertLen = 0;
+	uECC_Curve eccCurve = curveByName(curve, secertLen);
+	if (eccCurve == NULL)
 		return false;
 
+	_curve = eccCurve;
+	_secertLen = secertLen;
 	_publicKey.clear();
 	_privateKey.clear();
 
@@ -65,6 +75,48 @@ std::string ECCKeysMaker::publicKey(bool reGen)
 	return _publicKey;
 }
 
+bool ECCKeysMaker::setKeyPair(const std::string& publicKey, const std::string& privateKey)
+{
+	if (!_curve)
+	{
+		LOG_FATAL("ECC Private Key Config ERROR.");
+		return false;
+	}
+	if ((int)publicKey.length() != _secertLen * 2 || (int)privateKey.length() != _secertLen)
+	{
+		LOG_ERROR("Key pair length missmatched.");
+		return false;
+	}
+
+	_publicKey = publicKey;
+	_privateKey = privateKey;
+	return true;
+}
+
+bool ECCKeysMaker::makeKeyPairs(const std::string& curve, int count, std::vector<std::string>& publicKeys, std::vector<std::string>& privateKeys)
+{
+	int secertLen = 0;
+	uECC_Curve eccCurve = curveByName(curve, secertLen);
+	if (eccCurve == NULL || count <= 0)
+		return false;
+
+	std::string publicBuffer((size_t)count * secertLen * 2, '\0');
+	std::string privateBuffer((size_t)count * secertLen, '\0');
+
+	if (uECC_make_keys((uint8_t*)&publicBuffer[0], (uint8_t*)&privateBuffer[0], (unsigned)count, eccCurve) == 0)
+	{
+		LOG_ERROR("Gen %d public keys & private keys failed.", count);
+		return false;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		publicKeys.push_back(publicBuffer.substr((size_t)i * secertLen * 2, secertLen * 2));
+		privateKeys.push_back(privateBuffer.substr((size_t)i * secertLen, secertLen));
+	}
+	return true;
+}
+
 bool ECCKeysMaker::calcKey(uint8_t* key, uint8_t* iv, int keylen)
 {
 	if (!_curve)
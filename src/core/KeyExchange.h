@@ -2,6 +2,7 @@
 #define FPNN_KeyExchange_h
 
 #include <string>
+#include <vector>
 #include <stdint.h>
 #include "micro-ecc/uECC.h"
 
@@ -50,6 +51,15 @@ namespace fpnn
 		bool setCurve(const std::string& curve);
 		std::string publicKey(bool reGen = false);
 
+		//-- Uses a key pair made by makeKeyPairs(). MUST be called after setCurve().
+		bool setKeyPair(const std::string& publicKey, const std::string& privateKey);
+
+		/*
+			Batched key pairs generating. The key pairs are appended to publicKeys & privateKeys.
+			Faster than calling publicKey(true) count times.
+		*/
+		static bool makeKeyPairs(const std::string& curve, int count, std::vector<std::string>& publicKeys, std::vector<std::string>& privateKeys);
+
 		/*
 			key: OUT. Key buffer length is equal to keylen.
 			iv: OUT. iv buffer length is 16 bytes.
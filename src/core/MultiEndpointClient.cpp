@@ -0,0 +1,556 @@
+#include <stdint.h>
+#include <algorithm>
+#include "FPLog.h"
+#include "TimeUtil.h"
+#include "MultiEndpointClient.h"
+
+using namespace fpnn;
+
+namespace
+{
+	/*
+		Wraps the developer's quest processor for each member. Failed connecting & closing by error
+		(including keep-alive lost) eject the endpoint, then the events are forwarded.
+	*/
+	class EndpointQuestProcessor: public IQuestProcessor
+	{
+		std::weak_ptr<MultiEndpointClient::Endpoint> _endpoint;
+		IQuestProcessorPtr _processor;
+
+		inline void eject()
+		{
+			MultiEndpointClient::EndpointPtr endpoint = _endpoint.lock();
+			if (endpoint)
+				endpoint->eject();
+		}
+
+	public:
+		EndpointQuestProcessor(MultiEndpointClient::EndpointPtr endpoint, IQuestProcessorPtr processor):
+			_endpoint(endpoint), _processor(processor) {}
+		virtual ~EndpointQuestProcessor() {}
+
+		virtual void setConcurrentSender(IConcurrentSender* concurrentSender)
+		{
+			IQuestProcessor::setConcurrentSender(concurrentSender);
+			if (_processor)
+				_processor->setConcurrentSender(concurrentSender);
+		}
+
+		virtual FPAnswerPtr processQuest(const FPReaderPtr args, const FPQuestPtr quest, const ConnectionInfo& connectionInfo)
+		{
+			if (_processor)
+				return _processor->processQuest(args, quest, connectionInfo);
+
+			return unknownMethod(quest->method(), args, quest, connectionInfo);
+		}
+
+		virtual void connected(const ConnectionInfo& connInfo, bool connected)
+		{
+			if (!connected)
+				eject();
+
+			if (_processor)
+				_processor->connected(connInfo, connected);
+		}
+
+		virtual void connectionWillClose(const ConnectionInfo& connInfo, bool closeByError)
+		{
+			if (closeByError)
+				eject();
+
+			if (_processor)
+				_processor->connectionWillClose(connInfo, closeByError);
+		}
+	};
+
+	//-- Failed quests are sampled with their elapsed time plus this penalty, so fast error answers never lower the score.
+	const int64_t ErrorPenaltyUsec = 1000 * 1000;
+
+	inline bool failed(FPAnswerPtr answer, int errorCode)
+	{
+		return errorCode != FPNN_EC_OK || !answer || answer->status() != 0;
+	}
+
+	/*
+		Measures the latency from quest sent to answer received. The result is filled in the IO thread when
+		the answer received, the wrapped callback is run as it is sent by the member directly.
+		If the result is never filled (sending failed), the in-flight count is released when deleted.
+	*/
+	class EndpointAnswerCallback: public BasicAnswerCallback
+	{
+		MultiEndpointClient::EndpointPtr _endpoint;
+		BasicAnswerCallback* _callback;
+		int64_t _sentUsec;
+		bool _pending;
+
+		inline void release()
+		{
+			if (_pending)
+			{
+				_pending = false;
+				_endpoint->inflight--;
+			}
+		}
+
+	public:
+		EndpointAnswerCallback(MultiEndpointClient::EndpointPtr endpoint, BasicAnswerCallback* callback):
+			_endpoint(endpoint), _callback(callback), _sentUsec(TimeUtil::curr_usec()), _pending(true)
+		{
+			setInlineCallback(callback->inlineCallback());
+			_endpoint->inflight++;
+		}
+		virtual ~EndpointAnswerCallback()
+		{
+			release();
+			delete _callback;
+		}
+
+		static void* operator new(size_t size) { return ThreadCachedPool::allocate(size); }
+		static void operator delete(void* p, size_t size) { ThreadCachedPool::deallocate(p, size); }
+
+		//-- If sending failed, the wrapped callback is returned to the caller.
+		BasicAnswerCallback* cancel()
+		{
+			BasicAnswerCallback* callback = _callback;
+			_callback = NULL;
+			release();
+			return callback;
+		}
+
+		virtual void fillResult(FPAnswerPtr answer, int errorCode)
+		{
+			release();
+
+			int64_t latencyUsec = TimeUtil::curr_usec() - _sentUsec;
+			if (failed(answer, errorCode))
+				latencyUsec += ErrorPenaltyUsec;
+
+			_endpoint->updateLatency(latencyUsec);
+			_callback->fillResult(answer, errorCode);
+		}
+
+		virtual void run()
+		{
+			_callback->run();
+		}
+	};
+
+	inline uint32_t randomValue()
+	{
+		static thread_local uint32_t seed = 0;
+		if (seed == 0)
+			seed = (uint32_t)(TimeUtil::curr_usec() ^ (uintptr_t)&seed) | 1;
+
+		//-- xorshift32
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+}
+
+//=================================================================//
+//- Endpoint
+//=================================================================//
+/*
+	EWMA with weight 1/8, as TCP smoothed RTT. Failed quests (including timeouts) are sampled with
+	their elapsed time plus a fixed penalty, so a degraded endpoint is penalized.
+*/
+void MultiEndpointClient::Endpoint::updateLatency(int64_t latencyUsec)
+{
+	if (latencyUsec < 0)
+		latencyUsec = 0;
+
+	int64_t current = ewmaLatencyUsec.load();
+	while (true)
+	{
+		int64_t ewma = (current == 0) ? latencyUsec : current + (latencyUsec - current) / 8;
+		if (ewmaLatencyUsec.compare_exchange_weak(current, ewma))
+			return;
+	}
+}
+
+//-- The samples before ejection are stale, the EWMA is seeded again when the endpoint recovered.
+void MultiEndpointClient::Endpoint::eject()
+{
+	latencyStale = true;
+	ejectedUntilMsec = TimeUtil::steady_msec() + ejectionMsec;
+}
+
+//=================================================================//
+//- MultiEndpointClient
+//=================================================================//
+MultiEndpointClientPtr MultiEndpointClient::createClient(const std::vector<std::string>& endpoints, bool autoReconnect)
+{
+	if (endpoints.empty())
+		return nullptr;
+
+	std::vector<std::pair<std::string, int>> addresses;
+	for (auto& endpoint: endpoints)
+	{
+		std::string host;
+		int port;
+
+		if (!parseAddress(endpoint, host, port))
+		{
+			LOG_ERROR("Invalid endpoint %s for multi-endpoint client.", endpoint.c_str());
+			return nullptr;
+		}
+
+		addresses.push_back(std::make_pair(host, port));
+	}
+
+	return MultiEndpointClientPtr(new MultiEndpointClient(addresses, autoReconnect));
+}
+
+MultiEndpointClient::MultiEndpointClient(const std::vector<std::pair<std::string, int>>& addresses, bool autoReconnect):
+	Client(addresses[0].first, addresses[0].second, autoReconnect), _membersPrepared(false), _ejectionMsec(5000)
+{
+	_endpoint.clear();
+	_endpoints.reserve(addresses.size());
+	for (size_t i = 0; i < addresses.size(); i++)
+	{
+		TCPClientPtr client = TCPClient::createClient(addresses[i].first, addresses[i].second, autoReconnect);
+		_endpoints.push_back(std::make_shared<Endpoint>(client));
+
+		_endpoint.append(i ? "," : "").append(client->endpoint());
+	}
+}
+
+MultiEndpointClient::~MultiEndpointClient()
+{
+	if (_membersPrepared)
+		close();
+}
+
+//-- MUST be called under _mutex.
+void MultiEndpointClient::prepareMembers()
+{
+	for (auto& endpoint: _endpoints)
+	{
+		TCPClientPtr& member = endpoint->client;
+
+		member->setQuestProcessor(std::make_shared<EndpointQuestProcessor>(endpoint, _questProcessor));
+		member->setQuestTimeoutMsec(_timeoutQuest);
+		member->setAutoReconnect(_autoReconnect);
+		member->setInlineAnswerCallback(isInlineAnswerCallback());
+		member->setOrderedCallbacks(_orderedCallbacks);
+
+		if (_embedRecvNotifyDeleagte)
+			member->embed_configRecvNotifyDelegate(_embedRecvNotifyDeleagte);
+	}
+
+	_membersPrepared = true;
+}
+
+bool MultiEndpointClient::available(const EndpointPtr& endpoint, int64_t now)
+{
+	if (endpoint->ejectedUntilMsec > now)
+		return false;
+
+	if (endpoint->client->connected())
+	{
+		if (endpoint->latencyStale.exchange(false))
+			reseedLatency(endpoint);
+
+		return true;
+	}
+
+	//-- Ejection expired, or never connected.
+	if (_autoReconnect)
+		endpoint->client->asyncConnect();
+
+	return false;
+}
+
+/*
+	Seeds the EWMA of a recovered endpoint with the median of the other endpoints, so it is neither
+	avoided for its samples before ejection, nor flooded as a fresh endpoint.
+	If no other endpoint has samples, the EWMA is cleared, and seeded by its first sample.
+*/
+void MultiEndpointClient::reseedLatency(const EndpointPtr& endpoint)
+{
+	std::vector<int64_t> latencies;
+	for (auto& other: _endpoints)
+	{
+		if (other == endpoint || other->latencyStale)
+			continue;
+
+		int64_t ewma = other->ewmaLatencyUsec;
+		if (ewma > 0)
+			latencies.push_back(ewma);
+	}
+
+	if (latencies.empty())
+	{
+		endpoint->ewmaLatencyUsec = 0;
+		return;
+	}
+
+	std::nth_element(latencies.begin(), latencies.begin() + latencies.size() / 2, latencies.end());
+	endpoint->ewmaLatencyUsec = latencies[latencies.size() / 2];
+}
+
+//-- Returns the first available endpoint from a random position. If none, returns -1.
+int MultiEndpointClient::pick(int64_t now, int exclude)
+{
+	int count = (int)_endpoints.size();
+	int start = (int)(randomValue() % count);
+
+	for (int i = 0; i < count; i++)
+	{
+		int index = (start + i) % count;
+		if (index != exclude && available(_endpoints[index], now))
+			return index;
+	}
+	return -1;
+}
+
+/*
+	Power of two choices. If no endpoint is available, a random one is used,
+	and it will reconnect itself if auto reconnect is enabled.
+*/
+MultiEndpointClient::EndpointPtr MultiEndpointClient::choose()
+{
+	if (!_membersPrepared)
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		if (!_membersPrepared)
+			prepareMembers();
+	}
+
+	int64_t now = TimeUtil::steady_msec();
+	int first = pick(now, -1);
+	if (first < 0)
+		return _endpoints[randomValue() % _endpoints.size()];
+
+	int second = pick(now, first);
+	if (second < 0)
+		return _endpoints[first];
+
+	const EndpointPtr& a = _endpoints[first];
+	const EndpointPtr& b = _endpoints[second];
+
+	int64_t scoreA = a->ewmaLatencyUsec * (a->inflight + 1);
+	int64_t scoreB = b->ewmaLatencyUsec * (b->inflight + 1);
+
+	return (scoreA <= scoreB) ? a : b;
+}
+
+void MultiEndpointClient::setEjectionMsec(int msec)
+{
+	_ejectionMsec = msec;
+	for (auto& endpoint: _endpoints)
+		endpoint->ejectionMsec = msec;
+}
+
+void MultiEndpointClient::enableEncryptor(const std::string& curve, const std::string& peerPublicKey, bool packageMode, bool reinforce)
+{
+	for (auto& endpoint: _endpoints)
+		endpoint->client->enableEncryptor(curve, peerPublicKey, packageMode, reinforce);
+}
+
+bool MultiEndpointClient::enableEncryptorByDerData(const std::string &derData, bool packageMode, bool reinforce)
+{
+	for (auto& endpoint: _endpoints)
+		if (endpoint->client->enableEncryptorByDerData(derData, packageMode, reinforce) == false)
+			return false;
+
+	return true;
+}
+
+bool MultiEndpointClient::enableEncryptorByPemData(const std::string &PemData, bool packageMode, bool reinforce)
+{
+	for (auto& endpoint: _endpoints)
+		if (endpoint->client->enableEncryptorByPemData(PemData, packageMode, reinforce) == false)
+			return false;
+
+	return true;
+}
+
+bool MultiEndpointClient::enableEncryptorByDerFile(const char *derFilePath, bool packageMode, bool reinforce)
+{
+	for (auto& endpoint: _endpoints)
+		if (endpoint->client->enableEncryptorByDerFile(derFilePath, packageMode, reinforce) == false)
+			return false;
+
+	return true;
+}
+
+bool MultiEndpointClient::enableEncryptorByPemFile(const char *pemFilePath, bool packageMode, bool reinforce)
+{
+	for (auto& endpoint: _endpoints)
+		if (endpoint->client->enableEncryptorByPemFile(pemFilePath, packageMode, reinforce) == false)
+			return false;
+
+	return true;
+}
+
+void MultiEndpointClient::reserveEncryptionKeys(size_t count)
+{
+	for (auto& endpoint: _endpoints)
+		endpoint->client->reserveEncryptionKeys(count);
+}
+
+void MultiEndpointClient::keepAlive()
+{
+	for (auto& endpoint: _endpoints)
+		endpoint->client->keepAlive();
+}
+
+void MultiEndpointClient::setKeepAlivePingTimeout(int seconds)
+{
+	for (auto& endpoint: _endpoints)
+		endpoint->client->setKeepAlivePingTimeout(seconds);
+}
+
+void MultiEndpointClient::setKeepAliveInterval(int seconds)
+{
+	for (auto& endpoint: _endpoints)
+		endpoint->client->setKeepAliveInterval(seconds);
+}
+
+void MultiEndpointClient::setKeepAliveMaxPingRetryCount(int count)
+{
+	for (auto& endpoint: _endpoints)
+		endpoint->client->setKeepAliveMaxPingRetryCount(count);
+}
+
+void MultiEndpointClient::setConnectTimeout(int seconds)
+{
+	for (auto& endpoint: _endpoints)
+		endpoint->client->setConnectTimeout(seconds);
+}
+
+void MultiEndpointClient::status(std::vector<EndpointStatus>& infos)
+{
+	int64_t now = TimeUtil::steady_msec();
+
+	infos.clear();
+	infos.reserve(_endpoints.size());
+	for (auto& endpoint: _endpoints)
+	{
+		EndpointStatus info;
+		info.endpoint = endpoint->client->endpoint();
+		info.connected = endpoint->client->connected();
+		info.ejected = (endpoint->ejectedUntilMsec > now);
+		info.inflight = endpoint->inflight;
+		info.ewmaLatencyUsec = endpoint->ewmaLatencyUsec;
+		infos.push_back(info);
+	}
+}
+
+bool MultiEndpointClient::connect()
+{
+	if (!asyncConnect())
+		return false;
+
+	bool connected = false;
+	for (auto& endpoint: _endpoints)
+		if (endpoint->client->connect())
+			connected = true;
+
+	return connected;
+}
+
+bool MultiEndpointClient::asyncConnect()
+{
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		prepareMembers();
+	}
+
+	bool launched = false;
+	for (auto& endpoint: _endpoints)
+	{
+		if (endpoint->client->asyncConnect())
+			launched = true;
+		else
+			endpoint->eject();
+	}
+
+	return launched;
+}
+
+bool MultiEndpointClient::connected()
+{
+	for (auto& endpoint: _endpoints)
+		if (endpoint->client->connected())
+			return true;
+
+	return false;
+}
+
+void MultiEndpointClient::close()
+{
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		_membersPrepared = false;
+	}
+
+	for (auto& endpoint: _endpoints)
+		endpoint->client->close();
+}
+
+FPAnswerPtr MultiEndpointClient::sendQuestMsec(FPQuestPtr quest, int timeoutMsec)
+{
+	EndpointPtr endpoint = choose();
+	if (quest->isOneWay())
+		return endpoint->client->sendQuestMsec(quest, timeoutMsec);
+
+	int64_t sentUsec = TimeUtil::curr_usec();
+	endpoint->inflight++;
+
+	FPAnswerPtr answer = endpoint->client->sendQuestMsec(quest, timeoutMsec);
+
+	endpoint->inflight--;
+
+	int64_t latencyUsec = TimeUtil::curr_usec() - sentUsec;
+	if (failed(answer, FPNN_EC_OK))
+		latencyUsec += ErrorPenaltyUsec;
+
+	endpoint->updateLatency(latencyUsec);
+	return answer;
+}
+
+bool MultiEndpointClient::sendQuestMsec(FPQuestPtr quest, AnswerCallback* callback, int timeoutMsec)
+{
+	EndpointPtr endpoint = choose();
+	if (quest->isOneWay() || !callback)
+		return endpoint->client->sendQuestMsec(quest, callback, timeoutMsec);
+
+	EndpointAnswerCallback* wrapper = new EndpointAnswerCallback(endpoint, callback);
+	if (endpoint->client->sendQuestWithBasicAnswerCallback(quest, wrapper, timeoutMsec))
+		return true;
+
+	//-- Caller keeps the ownership of callback.
+	wrapper->cancel();
+	delete wrapper;
+	return false;
+}
+
+bool MultiEndpointClient::sendQuestMsec(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeoutMsec)
+{
+	EndpointPtr endpoint = choose();
+	if (quest->isOneWay())
+		return endpoint->client->sendQuestMsec(quest, std::move(task), timeoutMsec);
+
+	EndpointAnswerCallback* wrapper = new EndpointAnswerCallback(endpoint, new FunctionAnswerCallback(std::move(task)));
+	if (endpoint->client->sendQuestWithBasicAnswerCallback(quest, wrapper, timeoutMsec))
+		return true;
+
+	delete wrapper;
+	return false;
+}
+
+void MultiEndpointClient::embed_configRecvNotifyDelegate(EmbedRecvNotifyDelegate delegate)
+{
+	_embedRecvNotifyDeleagte = delegate;
+	for (auto& endpoint: _endpoints)
+		endpoint->client->embed_configRecvNotifyDelegate(delegate);
+}
+
+bool MultiEndpointClient::embed_sendData(std::string* rawData)
+{
+	return choose()->client->embed_sendData(rawData);
+}
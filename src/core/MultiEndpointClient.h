@@ -0,0 +1,146 @@
+#ifndef FPNN_Multi_Endpoint_Client_H
+#define FPNN_Multi_Endpoint_Client_H
+
+#include <vector>
+#include "TCPClient.h"
+
+namespace fpnn
+{
+	class MultiEndpointClient;
+	typedef std::shared_ptr<MultiEndpointClient> MultiEndpointClientPtr;
+
+	//=================================================================//
+	//- Multi-Endpoint Client:
+	//=================================================================//
+	/*
+		Latency-aware client for a group of replicas, with the same interfaces as Client.
+
+		*. Each endpoint is a TCPClient member. Reconnecting & keep-alive are processed by each member itself.
+		*. For each endpoint, the EWMA latency (from quest sent to answer received) and the in-flight quests are tracked.
+			Failed quests are sampled with a fixed penalty.
+		*. Each quest is routed with power-of-two-choices: two available endpoints are picked randomly,
+			and the one with lower (EWMA latency * (in-flight + 1)) is used.
+		*. Endpoints which failed to connect, or were closed by error (including keep-alive lost),
+			are ejected for a while. If all endpoints are ejected, quests are routed randomly.
+			When an ejected endpoint recovered, its EWMA latency is seeded with the median of the other endpoints.
+		*. Configurations of Client (quest processor, quest timeout, auto reconnect, inline & ordered callbacks)
+			are applied to members when connecting, or when the first quest sent.
+			Please configure it before connecting.
+	*/
+	class MultiEndpointClient: public Client
+	{
+	public:
+		struct EndpointStatus
+		{
+			std::string endpoint;
+			bool connected;
+			bool ejected;
+			int inflight;
+			int64_t ewmaLatencyUsec;
+		};
+
+		struct Endpoint
+		{
+			TCPClientPtr client;
+			std::atomic<int64_t> ewmaLatencyUsec;
+			std::atomic<int32_t> inflight;
+			std::atomic<int64_t> ejectedUntilMsec;
+			std::atomic<int32_t> ejectionMsec;
+			std::atomic<bool> latencyStale;
+
+			explicit Endpoint(TCPClientPtr client_): client(client_), ewmaLatencyUsec(0), inflight(0),
+				ejectedUntilMsec(0), ejectionMsec(5000), latencyStale(false) {}
+
+			void updateLatency(int64_t latencyUsec);
+			void eject();
+		};
+		typedef std::shared_ptr<Endpoint> EndpointPtr;
+
+	private:
+		std::vector<EndpointPtr> _endpoints;
+		std::atomic<bool> _membersPrepared;
+		int _ejectionMsec;
+
+		MultiEndpointClient(const std::vector<std::pair<std::string, int>>& addresses, bool autoReconnect);
+
+		void prepareMembers();
+		EndpointPtr choose();
+		bool available(const EndpointPtr& endpoint, int64_t now);
+		void reseedLatency(const EndpointPtr& endpoint);
+		int pick(int64_t now, int exclude);
+
+	public:
+		virtual ~MultiEndpointClient();
+
+		/*===============================================================================
+		  Call by Developer. Configure Function.
+		=============================================================================== */
+		//-- Ejection duration of failed endpoints. Default is 5 seconds.
+		void setEjectionMsec(int msec);
+		inline int getEjectionMsec() { return _ejectionMsec; }
+
+		//-- Applied to all member connections.
+		void enableEncryptor(const std::string& curve, const std::string& peerPublicKey, bool packageMode = true, bool reinforce = false);
+		bool enableEncryptorByDerData(const std::string &derData, bool packageMode = true, bool reinforce = false);
+		bool enableEncryptorByPemData(const std::string &PemData, bool packageMode = true, bool reinforce = false);
+		bool enableEncryptorByDerFile(const char *derFilePath, bool packageMode = true, bool reinforce = false);
+		bool enableEncryptorByPemFile(const char *pemFilePath, bool packageMode = true, bool reinforce = false);
+		//-- Members share one stock of prepared ECDH results.
+		void reserveEncryptionKeys(size_t count);
+		virtual void keepAlive();
+		void setKeepAlivePingTimeout(int seconds);
+		void setKeepAliveInterval(int seconds);
+		void setKeepAliveMaxPingRetryCount(int count);
+		void setConnectTimeout(int seconds);
+
+		inline size_t endpointCount() { return _endpoints.size(); }
+		inline TCPClientPtr member(size_t index) { return _endpoints[index]->client; }
+		void status(std::vector<EndpointStatus>& infos);
+
+		/*===============================================================================
+		  Call by Developer.
+		=============================================================================== */
+		//-- Returns true if any endpoint connected.
+		virtual bool connect();
+		virtual bool asyncConnect();
+		virtual void close();
+		//-- Returns true if any endpoint is connected.
+		virtual bool connected();
+
+		/**
+			All SendQuest():
+				If return false, caller must free quest & callback.
+				If return true, don't free quest & callback.
+
+			timeout in seconds.
+		*/
+		virtual FPAnswerPtr sendQuest(FPQuestPtr quest, int timeout = 0)
+		{
+			return sendQuestMsec(quest, timeout * 1000);
+		}
+		virtual bool sendQuest(FPQuestPtr quest, AnswerCallback* callback, int timeout = 0)
+		{
+			return sendQuestMsec(quest, callback, timeout * 1000);
+		}
+		virtual bool sendQuest(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeout = 0)
+		{
+			return sendQuestMsec(quest, std::move(task), timeout * 1000);
+		}
+
+		//-- Timeout in milliseconds
+		virtual FPAnswerPtr sendQuestMsec(FPQuestPtr quest, int timeoutMsec = 0);
+		virtual bool sendQuestMsec(FPQuestPtr quest, AnswerCallback* callback, int timeoutMsec = 0);
+		virtual bool sendQuestMsec(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeoutMsec = 0);
+
+		//-- Returns nullptr if endpoints is empty, or any endpoint is invalid.
+		static MultiEndpointClientPtr createClient(const std::vector<std::string>& endpoints, bool autoReconnect = true);
+
+		/*===============================================================================
+		  Interfaces for embed mode.
+		=============================================================================== */
+		virtual void embed_configRecvNotifyDelegate(EmbedRecvNotifyDelegate delegate);
+		virtual bool embed_sendData(std::string* rawData);
+	};
+}
+
+#endif
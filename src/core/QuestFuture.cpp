@@ -0,0 +1,193 @@
+#include <chrono>
+#include "QuestFuture.h"
+
+using namespace fpnn;
+
+//=================================================================//
+//- QuestFutureState
+//=================================================================//
+void QuestFutureState::Waiter::done()
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+	if (_remaining > 0)
+	{
+		_remaining -= 1;
+		if (_remaining == 0)
+			_condition.notify_one();
+	}
+}
+
+bool QuestFutureState::Waiter::wait(int timeoutMsec)
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+	if (timeoutMsec <= 0)
+	{
+		while (_remaining > 0)
+			_condition.wait(lck);
+
+		return true;
+	}
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMsec);
+	while (_remaining > 0)
+	{
+		if (_condition.wait_until(lck, deadline) == std::cv_status::timeout)
+			return _remaining == 0;
+	}
+	return true;
+}
+
+void QuestFutureState::fill(FPAnswerPtr answer, int errorCode)
+{
+	//-- Waiters are notified under the state lock, so a waiter is alive until it detached.
+	std::unique_lock<std::mutex> lck(_mutex);
+	_answer = answer;
+	_errorCode = errorCode;
+	_ready = true;
+
+	for (WaitEntry* entry = _waitEntries; entry; entry = entry->next)
+		entry->waiter->done();
+
+	_waitEntries = NULL;
+}
+
+bool QuestFutureState::attach(WaitEntry* entry)
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+	if (_ready)
+		return false;
+
+	entry->next = _waitEntries;
+	_waitEntries = entry;
+	return true;
+}
+
+void QuestFutureState::detach(WaitEntry* entry)
+{
+	std::unique_lock<std::mutex> lck(_mutex);
+	WaitEntry** curr = &_waitEntries;
+	while (*curr)
+	{
+		if (*curr == entry)
+		{
+			*curr = entry->next;
+			break;
+		}
+		curr = &((*curr)->next);
+	}
+	entry->next = NULL;
+}
+
+//=================================================================//
+//- QuestFuture
+//=================================================================//
+QuestFuture QuestFuture::makeReady(FPAnswerPtr answer, int errorCode)
+{
+	QuestFutureStatePtr state = std::make_shared<QuestFutureState>();
+	state->fill(answer, errorCode);
+	return QuestFuture(state);
+}
+
+void QuestFuture::wait() const
+{
+	waitFor(0);
+}
+
+bool QuestFuture::waitFor(int timeoutMsec) const
+{
+	QuestFutureState::Waiter waiter(1);
+	QuestFutureState::WaitEntry entry;
+	entry.waiter = &waiter;
+
+	if (_state->attach(&entry) == false)
+		return true;
+
+	bool done = waiter.wait(timeoutMsec);
+	_state->detach(&entry);
+	return done;
+}
+
+FPAnswerPtr QuestFuture::get() const
+{
+	wait();
+	return _state->answer();
+}
+
+int QuestFuture::errorCode() const
+{
+	wait();
+	return _state->errorCode();
+}
+
+bool QuestFuture::whenAll(const std::vector<QuestFuture>& futures, int timeoutMsec)
+{
+	QuestFutureState::Waiter waiter((int)futures.size());
+	std::vector<QuestFutureState::WaitEntry> entries(futures.size());
+
+	for (size_t i = 0; i < futures.size(); i++)
+	{
+		entries[i].waiter = &waiter;
+		if (!futures[i]._state || futures[i]._state->attach(&entries[i]) == false)
+		{
+			entries[i].waiter = NULL;
+			waiter.done();
+		}
+	}
+
+	bool done = waiter.wait(timeoutMsec);
+
+	for (size_t i = 0; i < futures.size(); i++)
+		if (entries[i].waiter)
+			futures[i]._state->detach(&entries[i]);
+
+	return done;
+}
+
+int QuestFuture::whenAny(const std::vector<QuestFuture>& futures, int timeoutMsec)
+{
+	bool hasValid = false;
+	for (size_t i = 0; i < futures.size(); i++)
+	{
+		if (futures[i]._state)
+		{
+			if (futures[i]._state->ready())
+				return (int)i;
+
+			hasValid = true;
+		}
+	}
+
+	if (!hasValid)
+		return -1;
+
+	QuestFutureState::Waiter waiter(1);
+	std::vector<QuestFutureState::WaitEntry> entries(futures.size());
+
+	for (size_t i = 0; i < futures.size(); i++)
+	{
+		if (!futures[i]._state)
+			continue;
+
+		entries[i].waiter = &waiter;
+		if (futures[i]._state->attach(&entries[i]) == false)
+		{
+			entries[i].waiter = NULL;
+			waiter.done();
+			break;
+		}
+	}
+
+	waiter.wait(timeoutMsec);
+
+	int index = -1;
+	for (size_t i = 0; i < futures.size(); i++)
+	{
+		if (entries[i].waiter)
+			futures[i]._state->detach(&entries[i]);
+
+		if (index == -1 && futures[i]._state && futures[i]._state->ready())
+			index = (int)i;
+	}
+
+	return index;
+}
@@ -0,0 +1,144 @@
+#ifndef FPNN_Quest_Future_H
+#define FPNN_Quest_Future_H
+
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <condition_variable>
+#include "AnswerCallbacks.h"
+
+namespace fpnn
+{
+	class QuestFutureState;
+	typedef std::shared_ptr<QuestFutureState> QuestFutureStatePtr;
+
+	/*
+		Shared state of a QuestFuture. Filled by the answer callback, and waited by QuestFuture.
+		No thread is created for waiting: waiters are linked into the state, and are notified by the thread
+		which fills the result.
+	*/
+	class QuestFutureState
+	{
+	public:
+		class Waiter
+		{
+			std::mutex _mutex;
+			std::condition_variable _condition;
+			int _remaining;
+
+		public:
+			explicit Waiter(int remaining): _remaining(remaining) {}
+
+			void done();
+			bool wait(int timeoutMsec);		//-- timeoutMsec <= 0 means waiting until done.
+		};
+
+		struct WaitEntry
+		{
+			Waiter* waiter;
+			WaitEntry* next;
+
+			WaitEntry(): waiter(NULL), next(NULL) {}
+		};
+
+	private:
+		std::mutex _mutex;
+		bool _ready;
+		int _errorCode;
+		FPAnswerPtr _answer;
+		WaitEntry* _waitEntries;
+
+	public:
+		QuestFutureState(): _ready(false), _errorCode(FPNN_EC_OK), _waitEntries(NULL) {}
+
+		void fill(FPAnswerPtr answer, int errorCode);
+		bool attach(WaitEntry* entry);		//-- If return false, the state is ready, and the entry isn't attached.
+		void detach(WaitEntry* entry);
+
+		bool ready()
+		{
+			std::unique_lock<std::mutex> lck(_mutex);
+			return _ready;
+		}
+		//-- Only available after ready.
+		inline FPAnswerPtr answer() { return _answer; }
+		inline int errorCode() { return _errorCode; }
+	};
+
+	/*
+		Future of an async two-way quest. Copyable, all copies share the same result.
+		Created by Client::sendQuestFuture() & Client::sendQuestFutureMsec().
+	*/
+	class QuestFuture
+	{
+		QuestFutureStatePtr _state;
+
+	public:
+		QuestFuture() {}
+		explicit QuestFuture(QuestFutureStatePtr state): _state(std::move(state)) {}
+
+		static QuestFuture makeReady(FPAnswerPtr answer, int errorCode);
+
+		inline bool valid() const { return (bool)_state; }
+		inline bool ready() const { return _state->ready(); }
+
+		void wait() const;
+		bool waitFor(int timeoutMsec) const;		//-- If return false, the future isn't ready.
+
+		/*
+			Wait and return the answer.
+			If the quest failed without an answer, an error answer is returned, as the sync sendQuest() does.
+			Oneway quests return nullptr.
+		*/
+		FPAnswerPtr get() const;
+		//-- Wait and return the error code. FPNN_EC_OK means success.
+		int errorCode() const;
+
+		/*
+			Wait a batch of futures with one wakeup. Invalid futures are ignored.
+			timeoutMsec <= 0 means waiting until done.
+
+			whenAll(): If return false, timeout, and some futures aren't ready.
+			whenAny(): Return the index of a ready future. If timeout, return -1.
+		*/
+		static bool whenAll(const std::vector<QuestFuture>& futures, int timeoutMsec = 0);
+		static int whenAny(const std::vector<QuestFuture>& futures, int timeoutMsec = 0);
+	};
+
+	//=================================================================//
+	//- Future Answer Callback:
+	//=================================================================//
+	/*
+		Fills the future state directly in the IO thread when the answer received (inline callback).
+		Timeout & connection closed errors are filled in the thread pool.
+	*/
+	class FutureAnswerCallback: public AnswerCallback
+	{
+		FPQuestPtr _quest;
+		QuestFutureStatePtr _state;
+
+	public:
+		FutureAnswerCallback(FPQuestPtr quest, QuestFutureStatePtr state): _quest(std::move(quest)), _state(std::move(state))
+		{
+			setInlineCallback(true);
+		}
+		virtual ~FutureAnswerCallback() {}
+
+		static void* operator new(size_t size) { return ThreadCachedPool::allocate(size); }
+		static void operator delete(void* p, size_t size) { ThreadCachedPool::deallocate(p, size); }
+
+		virtual void onAnswer(FPAnswerPtr answer)
+		{
+			_state->fill(answer, FPNN_EC_OK);
+		}
+		virtual void onException(FPAnswerPtr answer, int errorCode)
+		{
+			if (!answer)
+				answer = FPAWriter::errorAnswer(_quest, errorCode, "no msg, please refer to log.:)");
+
+			_state->fill(answer, errorCode);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,228 @@
+#include <string.h>
+#include <limits>
+#include "TimeUtil.h"
+#include "QuestTimeoutWheel.h"
+
+using namespace fpnn;
+
+QuestTimeoutWheel::QuestTimeoutWheel(): _count(0)
+{
+	memset(_root, 0, sizeof(_root));
+	memset(_levels, 0, sizeof(_levels));
+
+	_currentTick = TimeUtil::steady_msec();
+}
+
+void QuestTimeoutWheel::link(BasicAnswerCallback* callback)
+{
+	int64_t expired = callback->_expiredTime;
+	if (expired < _currentTick)
+		expired = _currentTick;
+
+	int64_t delta = expired - _currentTick;
+	BasicAnswerCallback** slot;
+
+	if (delta < RootSize)
+		slot = &_root[expired & RootMask];
+	else
+	{
+		int level = 0;
+		while (level < UpperLevels && delta >= ((int64_t)1 << (RootBits + (level + 1) * LevelBits)))
+			level++;
+
+		if (level == UpperLevels)
+		{
+			level = UpperLevels - 1;
+			expired = _currentTick + ((int64_t)1 << (RootBits + UpperLevels * LevelBits)) - 1;
+		}
+
+		slot = &_levels[level][(expired >> (RootBits + level * LevelBits)) & LevelMask];
+	}
+
+	callback->_wheelSlot = slot;
+	callback->_wheelPrev = NULL;
+	callback->_wheelNext = *slot;
+	if (*slot)
+		(*slot)->_wheelPrev = callback;
+
+	*slot = callback;
+}
+
+void QuestTimeoutWheel::unlink(BasicAnswerCallback* callback)
+{
+	if (callback->_wheelPrev)
+		callback->_wheelPrev->_wheelNext = callback->_wheelNext;
+	else
+		*(callback->_wheelSlot) = callback->_wheelNext;
+
+	if (callback->_wheelNext)
+		callback->_wheelNext->_wheelPrev = callback->_wheelPrev;
+
+	callback->_wheelPrev = NULL;
+	callback->_wheelNext = NULL;
+	callback->_wheelSlot = NULL;
+}
+
+void QuestTimeoutWheel::cascade(int level, int index)
+{
+	BasicAnswerCallback* callback = _levels[level][index];
+	_levels[level][index] = NULL;
+
+	while (callback)
+	{
+		BasicAnswerCallback* next = callback->_wheelNext;
+		link(callback);
+		callback = next;
+	}
+}
+
+void QuestTimeoutWheel::insert(BasicConnection* connection, uint32_t seqNum, BasicAnswerCallback* callback)
+{
+	if (callback->_wheelSlot)
+		remove(callback);
+
+	callback->_wheelConnection = connection;
+	callback->_wheelSeqNum = seqNum;
+
+	link(callback);
+	_count++;
+}
+
+void QuestTimeoutWheel::remove(BasicAnswerCallback* callback)
+{
+	if (callback->_wheelSlot == NULL)
+		return;
+
+	unlink(callback);
+	callback->_wheelConnection = NULL;
+	_count--;
+}
+
+void QuestTimeoutWheel::attach(BasicConnection* connection)
+{
+	for (auto& cbPair: connection->_callbackMap)
+		insert(connection, cbPair.first, cbPair.second);
+}
+
+void QuestTimeoutWheel::detach(BasicConnection* connection)
+{
+	for (auto& cbPair: connection->_callbackMap)
+		remove(cbPair.second);
+}
+
+bool QuestTimeoutWheel::cascadePending(int64_t tick) const
+{
+	for (int level = 0; level < UpperLevels; level++)
+	{
+		int levelIndex = (int)((tick >> (RootBits + level * LevelBits)) & LevelMask);
+		if (_levels[level][levelIndex])
+			return true;
+
+		if (levelIndex)
+			break;
+	}
+	return false;
+}
+
+int64_t QuestTimeoutWheel::nextActiveTick(int64_t limit) const
+{
+	//-- Callbacks in the root wheel expire in the next RootSize ticks.
+	int64_t tick = _currentTick;
+	for (int i = 0; i < RootSize; i++, tick++)
+	{
+		if (tick >= limit)
+			return limit;
+
+		if ((tick & RootMask) == 0 && cascadePending(tick))
+			return tick;
+
+		if (_root[tick & RootMask])
+			return tick;
+	}
+
+	//-- Root wheel is empty. Only the cascading points of the lowest non-empty upper wheel are concerned.
+	int level = 0;
+	for (; level < UpperLevels; level++)
+	{
+		int index = 0;
+		while (index < LevelSize && _levels[level][index] == NULL)
+			index++;
+
+		if (index < LevelSize)
+			break;
+	}
+
+	if (level == UpperLevels)
+		return limit;
+
+	int64_t step = (int64_t)1 << (RootBits + level * LevelBits);
+	tick = (tick + step - 1) & ~(step - 1);
+
+	while (tick < limit)
+	{
+		if (cascadePending(tick))
+			return tick;
+
+		tick += step;
+	}
+	return limit;
+}
+
+void QuestTimeoutWheel::extract(int64_t threshold, std::list<BasicAnswerCallback*>& timeouted)
+{
+	while (_currentTick <= threshold)
+	{
+		if (_count == 0)
+		{
+			_currentTick = threshold + 1;
+			return;
+		}
+
+		//-- Skip the empty ticks. The wheel isn't turned tick by tick when the checking is late.
+		_currentTick = nextActiveTick(threshold + 1);
+		if (_currentTick > threshold)
+			return;
+
+		int index = (int)(_currentTick & RootMask);
+		if (index == 0)
+		{
+			for (int level = 0; level < UpperLevels; level++)
+			{
+				int levelIndex = (int)((_currentTick >> (RootBits + level * LevelBits)) & LevelMask);
+				cascade(level, levelIndex);
+
+				if (levelIndex)
+					break;
+			}
+		}
+
+		BasicAnswerCallback* callback = _root[index];
+		_root[index] = NULL;
+
+		while (callback)
+		{
+			BasicAnswerCallback* next = callback->_wheelNext;
+
+			callback->_wheelPrev = NULL;
+			callback->_wheelNext = NULL;
+			callback->_wheelSlot = NULL;
+
+			callback->_wheelConnection->_callbackMap.erase(callback->_wheelSeqNum);
+			callback->_wheelConnection = NULL;
+			_count--;
+
+			timeouted.push_back(callback);
+			callback = next;
+		}
+
+		_currentTick++;
+	}
+}
+
+int64_t QuestTimeoutWheel::nearestTick() const
+{
+	if (_count == 0)
+		return std::numeric_limits<int64_t>::max();
+
+	return nextActiveTick(std::numeric_limits<int64_t>::max());
+}
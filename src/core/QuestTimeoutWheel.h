@@ -0,0 +1,77 @@
+#ifndef FPNN_Quest_Timeout_Wheel_H
+#define FPNN_Quest_Timeout_Wheel_H
+
+#include <list>
+#include <stdint.h>
+#include "AnswerCallbacks.h"
+#include "IOWorker.h"
+
+namespace fpnn
+{
+	/*
+		Hierarchical timing wheel for answer callbacks, one tick is one millisecond.
+
+		Root wheel: 256 slots, covers 256 ms.
+		Upper wheels: 64 slots for each, cover 16.4 seconds, 17.5 minutes and 18.6 hours.
+		Callbacks expired later than the last wheel will be cascaded again when the last wheel turned.
+
+		Insert & remove are O(1). Extracting is O(expired callbacks + occupied slots). Empty ticks are skipped,
+		so a long checking delay doesn't turn the wheel tick by tick.
+		Ticks are TimeUtil::steady_msec(), the monotonic clock. System time changing doesn't affect timeouts.
+
+		!!! IMPORTANT !!!
+		Not thread safe. Only the callbacks in the _callbackMap of the connections which are in ConnectionMap
+		are linked in the wheel, and all functions MUST be called under the lock of ConnectionMap.
+	*/
+	class QuestTimeoutWheel
+	{
+		enum
+		{
+			RootBits = 8,
+			RootSize = 1 << RootBits,
+			RootMask = RootSize - 1,
+			LevelBits = 6,
+			LevelSize = 1 << LevelBits,
+			LevelMask = LevelSize - 1,
+			UpperLevels = 3,
+		};
+
+		BasicAnswerCallback* _root[RootSize];
+		BasicAnswerCallback* _levels[UpperLevels][LevelSize];
+
+		int64_t _currentTick;		//-- All ticks before _currentTick are processed.
+		size_t _count;
+
+		void link(BasicAnswerCallback* callback);
+		void unlink(BasicAnswerCallback* callback);
+		void cascade(int level, int index);
+
+		//-- Is any upper wheel slot cascaded at tick? tick MUST be the beginning of a root wheel round.
+		bool cascadePending(int64_t tick) const;
+		//-- The first tick from _currentTick requiring processing. Returns limit if no such tick before limit.
+		int64_t nextActiveTick(int64_t limit) const;
+
+	public:
+		QuestTimeoutWheel();
+
+		void insert(BasicConnection* connection, uint32_t seqNum, BasicAnswerCallback* callback);
+		void remove(BasicAnswerCallback* callback);
+
+		//-- Link/unlink all callbacks in connection->_callbackMap. Using when connection joins/leaves ConnectionMap.
+		void attach(BasicConnection* connection);
+		void detach(BasicConnection* connection);
+
+		//-- Extract callbacks which expiredTime <= threshold, and erase them from the _callbackMap of their connections.
+		void extract(int64_t threshold, std::list<BasicAnswerCallback*>& timeouted);
+
+		/*
+			The nearest tick requiring extract(). Returns INT64_MAX if the wheel is empty.
+			If the nearest processing is cascading an upper wheel slot, the cascading point will be returned.
+		*/
+		int64_t nearestTick() const;
+
+		inline size_t size() const { return _count; }
+	};
+}
+
+#endif
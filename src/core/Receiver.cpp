@@ -0,0 +1,300 @@
+#ifdef __APPLE__
+	#include <sys/types.h>
+	#include <sys/uio.h>
+#endif
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "FPLog.h"
+#include "Config.h"
+#include "Decoder.h"
+#include "Receiver.h"
+
+using namespace fpnn;
+
+Receiver::~Receiver()
+{
+	if (_buffer)
+		free(_buffer);
+
+	if (_largeBuffer)
+		free(_largeBuffer);
+}
+
+bool Receiver::readIntoBuffer(int fd, uint8_t* buf, int length, int& received)
+{
+	received = 0;
+	while (true)
+	{
+		int readBytes = (int)::read(fd, buf, length);
+		if (readBytes > 0)
+		{
+			decryptReceivedData(buf, readBytes);
+			received = readBytes;
+			_drained = (readBytes < length);
+			return true;
+		}
+
+		if (readBytes == 0)
+		{
+			_closed = true;
+			return true;
+		}
+
+		if (errno == EINTR)
+			continue;
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ETIMEDOUT)
+			return true;
+
+		return false;
+	}
+}
+
+/*
+	Checks the buffered data. If a frame is completed, ready will be set true and _frame will point to it.
+	Frames larger than MaxBufferSize will be moved into the dedicated buffer.
+*/
+bool Receiver::prepareFrame(int fd, bool& ready)
+{
+	ready = false;
+
+	int available = _end - _begin;
+	if (available == 0)
+	{
+		_begin = _end = 0;
+		return true;
+	}
+
+	int64_t length = frameLength(_buffer + _begin, available);
+	if (length < 0)
+	{
+		LOG_ERROR("Received Error data (Not available FPNN-TCP-Message), fd:%d", fd);
+		return false;
+	}
+	if (length > Config::_max_recv_package_length)
+	{
+		LOG_ERROR("Recv huge TCP data from socket: %d. Connection will be closed by framework.", fd);
+		return false;
+	}
+	if (length == 0)
+		return true;
+
+	if (length <= available)
+	{
+		_frame = _buffer + _begin;
+		_frameLen = (int)length;
+		_begin += _frameLen;
+		ready = true;
+		return true;
+	}
+
+	if (length > MaxBufferSize)
+	{
+		_largeTotal = (int)length;
+		_largeBuffer = (uint8_t*)malloc(_largeTotal);
+		memcpy(_largeBuffer, _buffer + _begin, available);
+		_largeReceived = available;
+		_begin = _end = 0;
+		return true;
+	}
+
+	//-- Make room for the whole frame.
+	if (_begin > 0)
+	{
+		memmove(_buffer, _buffer + _begin, available);
+		_begin = 0;
+		_end = available;
+	}
+
+	if (length > _capacity)
+	{
+		int capacity = _capacity;
+		while (capacity < length)
+			capacity *= 2;
+
+		_buffer = (uint8_t*)realloc(_buffer, capacity);
+		_capacity = capacity;
+	}
+
+	return true;
+}
+
+bool Receiver::recvPackage(int fd, bool& needNextEvent)
+{
+	frameFetched();
+
+	if (_buffer == NULL)
+	{
+		_capacity = InitBufferSize;
+		_buffer = (uint8_t*)malloc(_capacity);
+	}
+
+	while (true)
+	{
+		if (_largeBuffer)
+		{
+			if (_largeReceived == _largeTotal)
+			{
+				_frame = _largeBuffer;
+				_frameLen = _largeTotal;
+				needNextEvent = false;
+				return true;
+			}
+		}
+		else
+		{
+			bool ready;
+			if (prepareFrame(fd, ready) == false)
+				return false;
+
+			if (ready)
+			{
+				needNextEvent = false;
+				return true;
+			}
+		}
+
+		//-- The last read() was short, the socket is drained. Poller is level-triggered, so wait next event.
+		if (_drained)
+		{
+			_drained = false;
+			needNextEvent = true;
+			return true;
+		}
+
+		int received;
+		if (_largeBuffer)
+		{
+			if (readIntoBuffer(fd, _largeBuffer + _largeReceived, _largeTotal - _largeReceived, received) == false)
+				return false;
+
+			_largeReceived += received;
+		}
+		else
+		{
+			if (_end == _capacity)
+			{
+				memmove(_buffer, _buffer + _begin, _end - _begin);
+				_end -= _begin;
+				_begin = 0;
+			}
+
+			if (readIntoBuffer(fd, _buffer + _end, _capacity - _end, received) == false)
+				return false;
+
+			_end += received;
+
+			//-- Small frames burst: enlarge buffer for reducing read() calls.
+			if (received > 0 && _end == _capacity && _capacity < MaxBufferSize)
+			{
+				_capacity *= 2;
+				_buffer = (uint8_t*)realloc(_buffer, _capacity);
+			}
+		}
+
+		if (_closed)
+			return (_largeBuffer == NULL && _end == _begin);
+
+		if (received == 0)
+		{
+			needNextEvent = true;
+			return true;
+		}
+	}
+}
+
+void Receiver::frameFetched()
+{
+	if (_frame && _frame == _largeBuffer)
+	{
+		free(_largeBuffer);
+		_largeBuffer = NULL;
+		_largeTotal = 0;
+		_largeReceived = 0;
+	}
+
+	_frame = NULL;
+	_frameLen = 0;
+}
+
+uint8_t* Receiver::detachLargeBuffer()
+{
+	uint8_t* buffer = _largeBuffer;
+	if (_frame == _largeBuffer)
+	{
+		_frame = NULL;
+		_frameLen = 0;
+	}
+
+	_largeBuffer = NULL;
+	_largeTotal = 0;
+	_largeReceived = 0;
+	return buffer;
+}
+
+bool Receiver::decodeFrame(const char* buf, int len, FPQuestPtr& quest, FPAnswerPtr& answer)
+{
+	//-- Large frame: messages take the dedicated buffer, and payload is decoded without copying.
+	FPFrameBufferPtr frame;
+	if (_largeBuffer && _frame == _largeBuffer)
+		frame.reset((char*)detachLargeBuffer(), free);
+
+	bool rev = false;
+	const char *desc = "unknown";
+	try
+	{
+		if (FPMessage::isQuest(buf))
+		{
+			desc = "TCP quest";
+			quest = Decoder::decodeQuest(buf, len, frame);
+		}
+		else
+		{
+			desc = "TCP answer";
+			answer = Decoder::decodeAnswer(buf, len, frame);
+		}
+		rev = true;
+	}
+	catch (const FpnnError& ex)
+	{
+		LOG_ERROR("Decode %s error. Connection will be closed by server. Code: %d, error: %s.", desc, ex.code(), ex.what());
+	}
+	catch (...)
+	{
+		LOG_ERROR("Decode %s error. Connection will be closed by server.", desc);
+	}
+
+	frameFetched();
+	return rev;
+}
+
+bool Receiver::deliverFrame(uint8_t* buf, int len, TCPClientConnection * connection, EmbedInteriorRecvNotifyDelegate delegate)
+{
+	if (Config::_embed_receiveBuffer_freeBySDK)
+	{
+		bool status = delegate(connection, buf, len);
+		frameFetched();
+		return status;
+	}
+
+	/*
+		Delegate takes the ownership of the buffer. A large frame hands its dedicated buffer over.
+		In package mode, buf is behind the length prefix, so the data is moved to the buffer start in place.
+	*/
+	uint8_t* data;
+	if (_largeBuffer && _frame == _largeBuffer)
+	{
+		data = detachLargeBuffer();
+		if (buf != data)
+			memmove(data, buf, len);
+	}
+	else
+	{
+		data = (uint8_t*)malloc(len);
+		memcpy(data, buf, len);
+		frameFetched();
+	}
+
+	return delegate(connection, data, len);
+}
@@ -20,19 +20,62 @@ namespace fpnn
 	//================================//
 	//--     Receiver Interface     --//
 	//================================//
+	/*
+		Batched receiving:
+			Each receiver owns a receive buffer (growable, 4 KB initially, 64 KB at most). recvPackage() reads as much
+			as the socket has into the buffer, then all complete frames in the buffer are fetched one by one without
+			any more read() calls.
+			Frames larger than the receive buffer are received into a dedicated buffer, and the decoded messages take
+			the dedicated buffer as their payload (zero-copy decoding).
+	*/
 	class Receiver
 	{
+		enum
+		{
+			InitBufferSize = 4 * 1024,
+			MaxBufferSize = 64 * 1024,
+		};
+
+		uint8_t* _buffer;
+		int _capacity;
+		int _begin;
+		int _end;
+		bool _drained;		//-- The last read() returned less than required.
+
+		uint8_t* _largeBuffer;
+		int _largeTotal;
+		int _largeReceived;
+
+		bool readIntoBuffer(int fd, uint8_t* buf, int length, int& received);
+		bool prepareFrame(int fd, bool& ready);
+		uint8_t* detachLargeBuffer();
+
 	protected:
-		int _curr;
-		int _total;
 		bool _closed;
+		uint8_t* _frame;		//-- Current completed frame. Available until next recvPackage() called.
+		int _frameLen;
+
+		/**
+			Returns the whole frame length.
+			If return 0, mean more data required; if return -1, mean invalid data.
+		*/
+		virtual int64_t frameLength(const uint8_t* data, int available) = 0;
+		virtual void decryptReceivedData(uint8_t* data, int length) { (void)data; (void)length; }
+
+		/** Release the dedicated buffer if current frame is in it. */
+		void frameFetched();
+
+		/** Decode or deliver the current frame, and then frameFetched() will be called. */
+		bool decodeFrame(const char* buf, int len, FPQuestPtr& quest, FPAnswerPtr& answer);
+		bool deliverFrame(uint8_t* buf, int len, TCPClientConnection * connection, EmbedInteriorRecvNotifyDelegate delegate);
 
 	public:
-		Receiver(): _curr(0), _total(FPMessage::_HeaderLength), _closed(false) {}
-		virtual ~Receiver() {}
+		Receiver(): _buffer(NULL), _capacity(0), _begin(0), _end(0), _drained(false),
+			_largeBuffer(NULL), _largeTotal(0), _largeReceived(0), _closed(false), _frame(NULL), _frameLen(0) {}
+		virtual ~Receiver();
 
 		virtual bool isClosed() { return _closed; }
-		virtual bool recvPackage(int fd, bool& needNextEvent) = 0;
+		virtual bool recvPackage(int fd, bool& needNextEvent);
 		virtual bool fetch(FPQuestPtr& quest, FPAnswerPtr& answer) = 0;
 		virtual bool embed_fetchRawData(TCPClientConnection * connection, EmbedInteriorRecvNotifyDelegate delegate) = 0;
 	};
@@ -42,35 +85,13 @@ namespace fpnn
 	//================================//
 	class UnencryptedReceiver: public Receiver
 	{
-		uint8_t* _header;
-		uint8_t* _currBuf;
-		uint8_t* _bodyBuffer;
-
-		/**
-			Only called when protocol is TCP, and header has be read.
-			if return -1, mean unsupported protocol.
-		*/
-		int remainDataLen();
+	protected:
+		virtual int64_t frameLength(const uint8_t* data, int available);
 
-		/** If length > 0; will do _total += length; */
-		bool recv(int fd, int length = 0);
-		bool recvTcpPackage(int fd, int length, bool& needNextEvent);
-		
 	public:
-		UnencryptedReceiver(): Receiver(), _bodyBuffer(NULL)
-		{
-			_header = (uint8_t*)malloc(FPMessage::_HeaderLength);
-			_currBuf = _header;
-		}
-		virtual ~UnencryptedReceiver()
-		{
-			if (_bodyBuffer)
-				free(_bodyBuffer);
-
-			free(_header);
-		}
+		UnencryptedReceiver(): Receiver() {}
+		virtual ~UnencryptedReceiver() {}
 
-		virtual bool recvPackage(int fd, bool& needNextEvent);
 		virtual bool fetch(FPQuestPtr& quest, FPAnswerPtr& answer);
 		virtual bool embed_fetchRawData(TCPClientConnection * connection, EmbedInteriorRecvNotifyDelegate delegate);
 	};
@@ -81,38 +102,15 @@ namespace fpnn
 	class EncryptedStreamReceiver: public Receiver
 	{
 		StreamEncryptor _encryptor;
-		uint8_t* _header;
-		uint8_t* _decHeader;
-		uint8_t* _currBuf;
-		uint8_t* _bodyBuffer;
 
-		/**
-			Only called when protocol is TCP, and header has be read.
-			if return -1, mean unsupported protocol.
-		*/
-		int remainDataLen();
+	protected:
+		virtual int64_t frameLength(const uint8_t* data, int available);
+		virtual void decryptReceivedData(uint8_t* data, int length);
 
-		/** If length > 0; will do _total += length; */
-		bool recv(int fd, int length = 0);
-		bool recvTcpPackage(int fd, int length, bool& needNextEvent);
-		
 	public:
-		EncryptedStreamReceiver(uint8_t *key, size_t key_len, uint8_t *iv): Receiver(), _encryptor(key, key_len, iv), _bodyBuffer(NULL)
-		{
-			_header = (uint8_t*)malloc(FPMessage::_HeaderLength);
-			_decHeader = (uint8_t*)malloc(FPMessage::_HeaderLength);
-			_currBuf = _header;
-		}
-		virtual ~EncryptedStreamReceiver()
-		{
-			if (_bodyBuffer)
-				free(_bodyBuffer);
+		EncryptedStreamReceiver(uint8_t *key, size_t key_len, uint8_t *iv): Receiver(), _encryptor(key, key_len, iv) {}
+		virtual ~EncryptedStreamReceiver() {}
 
-			free(_header);
-			free(_decHeader);
-		}
-
-		virtual bool recvPackage(int fd, bool& needNextEvent);
 		virtual bool fetch(FPQuestPtr& quest, FPAnswerPtr& answer);
 		virtual bool embed_fetchRawData(TCPClientConnection * connection, EmbedInteriorRecvNotifyDelegate delegate);
 	};
@@ -123,28 +121,16 @@ namespace fpnn
 	class EncryptedPackageReceiver: public Receiver
 	{
 		PackageEncryptor _encryptor;
-		uint32_t _packageLen;
-		uint8_t* _dataBuffer;
-		uint8_t* _currBuf;
-		bool _getLength;
 
-		/** If length > 0; will do _total += length; */
-		bool recv(int fd, int length = 0);
+		bool decryptFrame();
+
+	protected:
+		virtual int64_t frameLength(const uint8_t* data, int available);
 
 	public:
-		EncryptedPackageReceiver(uint8_t *key, size_t key_len, uint8_t *iv):
-			Receiver(), _encryptor(key, key_len, iv), _packageLen(0), _dataBuffer(NULL), _getLength(false)
-		{
-			_total = sizeof(uint32_t);
-			_currBuf = (uint8_t*)&_packageLen;
-		}
-		virtual ~EncryptedPackageReceiver()
-		{
-			if (_dataBuffer)
-				free(_dataBuffer);
-		}
+		EncryptedPackageReceiver(uint8_t *key, size_t key_len, uint8_t *iv): Receiver(), _encryptor(key, key_len, iv) {}
+		virtual ~EncryptedPackageReceiver() {}
 
-		virtual bool recvPackage(int fd, bool& needNextEvent);
 		virtual bool fetch(FPQuestPtr& quest, FPAnswerPtr& answer);
 		virtual bool embed_fetchRawData(TCPClientConnection * connection, EmbedInteriorRecvNotifyDelegate delegate);
 	};
@@ -9,19 +9,27 @@
 #include "FPWriter.h"
 #include "AutoRelease.h"
 #include "FileSystemUtil.h"
+#include "DNSResolver.h"
 #include "PEM_DER_SAX.h"
 #include "TCPClient.h"
 
 using namespace fpnn;
 
 TCPClient::TCPClient(const std::string& host, int port, bool autoReconnect):
-	Client(host, port, autoReconnect), _AESKeyLen(16), _packageEncryptionMode(true),
+	Client(host, port, autoReconnect), _AESKeyLen(16), _packageEncryptionMode(true), _reservedEncryptionKeys(0),
 	_keepAliveParams(NULL), _connectTimeout(0)
 {
 	if (Config::Client::KeepAlive::defaultEnable)
 		keepAlive();
 }
 
+void TCPClient::reserveEncryptionKeys(size_t count)
+{
+	_reservedEncryptionKeys = count;
+	if (count && _eccCurve.size())
+		ECCKeysPool::instance()->reserve(_eccCurve, _serverPublicKey, _AESKeyLen, count);
+}
+
 bool TCPClient::enableEncryptorByDerData(const std::string &derData, bool packageMode, bool reinforce)
 {
 	EccKeyReader reader;
@@ -139,7 +147,7 @@ void TCPClient::dealQuest(FPQuestPtr quest, ConnectionInfoPtr connectionInfo)		/
 	}
 
 	std::shared_ptr<QuestTask> task(new QuestTask(shared_from_this(), quest, connectionInfo));
-	if (ClientEngine::runTask(task) == false)
+	if (runCallbackTask(task) == false)
 	{
 		LOG_ERROR("wake up thread pool to process TCP quest failed. Quest pool limitation is caught. Quest task havn't be executed. %s",
 			connectionInfo->str().c_str());
@@ -224,7 +232,7 @@ void TCPClient::close()
 	willClose(conn, false);
 }
 
-FPAnswerPtr TCPClient::sendQuest(FPQuestPtr quest, int timeout)
+FPAnswerPtr TCPClient::sendQuestMsec(FPQuestPtr quest, int timeoutMsec)
 {
 	if (!_connected)
 	{
@@ -238,7 +246,7 @@ FPAnswerPtr TCPClient::sendQuest(FPQuestPtr quest, int timeout)
 
 		if (quest->isOneWay())
 		{
-			sendQuest(quest, NULL, timeout);
+			sendQuestMsec(quest, NULL, timeoutMsec);
 			return NULL;
 		}
 
@@ -258,13 +266,18 @@ FPAnswerPtr TCPClient::sendQuest(FPQuestPtr quest, int timeout)
 	}
 	Config::ClientQuestLog(quest, connInfo->ip.c_str(), connInfo->port);
 
-	if (timeout == 0)
-		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, &_mutex, quest, _timeoutQuest);
+	if (timeoutMsec == 0)
+		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, NULL, quest, _timeoutQuest);
 	else
-		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, &_mutex, quest, timeout * 1000);
+		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, NULL, quest, timeoutMsec);
 }
 
-bool TCPClient::sendQuest(FPQuestPtr quest, AnswerCallback* callback, int timeout)
+bool TCPClient::sendQuestMsec(FPQuestPtr quest, AnswerCallback* callback, int timeoutMsec)
+{
+	return sendQuestWithBasicAnswerCallback(quest, callback, timeoutMsec);
+}
+
+bool TCPClient::sendQuestWithBasicAnswerCallback(FPQuestPtr quest, BasicAnswerCallback* callback, int timeoutMsec)
 {
 	if (!_connected)
 	{
@@ -280,19 +293,19 @@ bool TCPClient::sendQuest(FPQuestPtr quest, AnswerCallback* callback, int timeou
 		std::unique_lock<std::mutex> lck(_mutex);
 		if (_requireCacheSendData)
 		{
-			cacheSendQuest(quest, callback, timeout);
+			cacheSendQuest(quest, callback, timeoutMsec);
 			return true;
 		}
 		connInfo = _connectionInfo;
 	}
 	Config::ClientQuestLog(quest, connInfo->ip.c_str(), connInfo->port);
 
-	if (timeout == 0)
+	if (timeoutMsec == 0)
 		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, quest, callback, _timeoutQuest);
 	else
-		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, quest, callback, timeout * 1000);
+		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, quest, callback, timeoutMsec);
 }
-bool TCPClient::sendQuest(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeout)
+bool TCPClient::sendQuestMsec(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeoutMsec)
 {
 	if (!_connected)
 	{
@@ -309,7 +322,7 @@ bool TCPClient::sendQuest(FPQuestPtr quest, std::function<void (FPAnswerPtr answ
 		if (_requireCacheSendData)
 		{
 			BasicAnswerCallback* callback = new FunctionAnswerCallback(std::move(task));
-			cacheSendQuest(quest, callback, timeout);
+			cacheSendQuest(quest, callback, timeoutMsec);
 			return true;
 		}
 
@@ -317,10 +330,72 @@ bool TCPClient::sendQuest(FPQuestPtr quest, std::function<void (FPAnswerPtr answ
 	}
 	Config::ClientQuestLog(quest, connInfo->ip.c_str(), connInfo->port);
 
-	if (timeout == 0)
+	if (timeoutMsec == 0)
 		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, quest, std::move(task), _timeoutQuest);
 	else
-		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, quest, std::move(task), timeout * 1000);
+		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, quest, std::move(task), timeoutMsec);
+}
+
+bool TCPClient::sendQuestsMsec(const std::vector<FPQuestPtr>& quests, std::function<AnswerCallback* (FPQuestPtr quest, size_t index)> callbackFactory, int timeoutMsec)
+{
+	if (quests.empty())
+		return true;
+
+	if (!_connected)
+	{
+		if (!_autoReconnect)
+			return false;
+
+		if (!asyncReconnect())
+			return false;
+	}
+
+	std::vector<BasicAnswerCallback*> callbacks(quests.size(), NULL);
+	for (size_t i = 0; i < quests.size(); i++)
+	{
+		if (quests[i] && quests[i]->isOneWay())
+			continue;
+
+		if (quests[i])
+			callbacks[i] = callbackFactory(quests[i], i);
+
+		if (callbacks[i] == NULL)
+		{
+			LOG_ERROR("Quest %d of batch is null, or callback factory returned NULL. Batch is cancelled.", (int)i);
+			for (auto callback: callbacks)
+				delete callback;
+
+			return false;
+		}
+	}
+
+	ConnectionInfoPtr connInfo;
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		if (_requireCacheSendData)
+		{
+			for (size_t i = 0; i < quests.size(); i++)
+				cacheSendQuest(quests[i], callbacks[i], timeoutMsec);
+
+			return true;
+		}
+
+		connInfo = _connectionInfo;
+	}
+
+	for (auto& quest: quests)
+		Config::ClientQuestLog(quest, connInfo->ip.c_str(), connInfo->port);
+
+	if (timeoutMsec == 0)
+		timeoutMsec = _timeoutQuest;
+
+	if (ClientEngine::instance()->sendQuests(connInfo->socket, connInfo->token, quests, callbacks, timeoutMsec))
+		return true;
+
+	for (auto callback: callbacks)
+		delete callback;
+
+	return false;
 }
 
 	/*===============================================================================
@@ -355,24 +430,20 @@ bool TCPClient::embed_sendData(std::string* rawData)
 
 bool TCPClient::configEncryptedConnection(TCPClientConnection* connection, std::string& publicKey)
 {
-	ECCKeysMaker keysMaker;
-	keysMaker.setPeerPublicKey(_serverPublicKey);
-	if (keysMaker.setCurve(_eccCurve) == false)
-		return false;
+	ECCKeysPool::PreparedKeys keys;
+	bool prepared = false;
 
-	publicKey = keysMaker.publicKey(true);
-	if (publicKey.empty())
-		return false;
+	if (_reservedEncryptionKeys)
+		prepared = ECCKeysPool::instance()->take(_eccCurve, _serverPublicKey, _AESKeyLen, keys);
 
-	uint8_t key[32];
-	uint8_t iv[16];
-	if (keysMaker.calcKey(key, iv, _AESKeyLen) == false)
+	if (!prepared && ECCKeysPool::makeKeys(_eccCurve, _serverPublicKey, _AESKeyLen, keys) == false)
 	{
 		LOG_ERROR("Client's keys maker calcKey failed. Peer %s", connection->_connectionInfo->str().c_str());
 		return false;
 	}
 
-	if (!connection->entryEncryptMode(key, _AESKeyLen, iv, !_packageEncryptionMode))
+	publicKey = keys.publicKey;
+	if (!connection->entryEncryptMode(keys.key, _AESKeyLen, keys.iv, !_packageEncryptionMode))
 	{
 		LOG_ERROR("Client connection entry encrypt mode failed. Peer %s", connection->_connectionInfo->str().c_str());
 		return false;
@@ -430,19 +501,19 @@ void TCPClient::sendEncryptHandshake(TCPClientConnection* connection, const std:
 
 	int timeout = _timeoutQuest;
 	if (timeout == 0)
-		timeout = ClientEngine::getQuestTimeout() * 1000;
+		timeout = ClientEngine::getQuestTimeoutMsec();
 
-	callback->updateExpiredTime(TimeUtil::curr_msec() + timeout);
+	callback->updateExpiredTime(TimeUtil::steady_msec() + timeout);
 
 	connection->_callbackMap[seqNum] = callback;
 	connection->_sendBuffer.appendData(raw);
 }
 
-void TCPClient::cacheSendQuest(FPQuestPtr quest, BasicAnswerCallback* callback, int timeout)
+void TCPClient::cacheSendQuest(FPQuestPtr quest, BasicAnswerCallback* callback, int timeoutMsec)
 {
 	AsyncQuestCacheUnit* unit = new AsyncQuestCacheUnit();
 	unit->quest = quest;
-	unit->timeoutMS = timeout * 1000;
+	unit->timeoutMS = timeoutMsec;
 	unit->callback = callback;
 	_asyncQuestCache.push_back(unit);
 }
@@ -492,10 +563,12 @@ void TCPClient::dumpCachedSendData(ConnectionInfoPtr connInfo)
 		}*/
 		
 		callback->fillResult(NULL, FPNN_EC_CORE_INVALID_CONNECTION);
-		BasicAnswerCallbackPtr task(callback);
 
-		if (ClientEngine::runTask(task) == false)
+		if (runCallbackTask(callback) == false)
+		{
 			LOG_ERROR("[Fatal] wake up thread pool to process cached quest in async mode failed. Callback havn't called. %s", connInfo->str().c_str());
+			delete callback;
+		}
 	}
 }
 
@@ -522,7 +595,7 @@ bool TCPClient::perpareConnection(int socket, bool connected, ConnectionInfoPtr
 				connection->configKeepAlive(_keepAliveParams);
 			else
 			{
-				_keepAliveParams->pingTimeout = _timeoutQuest ? _timeoutQuest : ClientEngine::getQuestTimeout() * 1000;
+				_keepAliveParams->pingTimeout = _timeoutQuest ? _timeoutQuest : ClientEngine::getQuestTimeoutMsec();
 				connection->configKeepAlive(_keepAliveParams);
 				_keepAliveParams->pingTimeout = 0;
 			}
@@ -774,14 +847,14 @@ bool TCPClient::connect()
 	}
 }
 
-void TCPClient::connectFailed(ConnectionInfoPtr connInfo, int errorCode)
+bool TCPClient::connectFailed(ConnectionInfoPtr connInfo, int errorCode)
 {
 	std::list<AsyncQuestCacheUnit*> asyncQuestCache;
 	std::list<std::string*> asyncEmbedDataCache;
 	{
 		std::unique_lock<std::mutex> lck(_mutex);
 		if (connInfo.get() != _connectionInfo.get())
-			return;
+			return false;
 
 		ConnectionInfoPtr newConnectionInfo(new ConnectionInfo(0, _connectionInfo->port, _connectionInfo->ip, _isIPv4));
 		_connectionInfo = newConnectionInfo;
@@ -796,6 +869,7 @@ void TCPClient::connectFailed(ConnectionInfoPtr connInfo, int errorCode)
 	}
 
 	failedCachedSendingData(connInfo, asyncQuestCache, asyncEmbedDataCache);
+	return true;
 }
 
 bool TCPClient::connectSuccessed(TCPClientConnection* conn)
@@ -832,23 +906,70 @@ bool TCPClient::asyncConnect()
 		_connStatus = ConnStatus::Connecting;
 	}
 
-	//-- begin connect
+	if (_hostname.empty())
+		return connectAddress(currentConnInfo);
+
+	std::string IPAddress;
+	EndPointType eType = ENDPOINT_TYPE_IP4;
+	bool resolved = false;
+	if (DNSResolver::instance()->lookupCache(_hostname, IPAddress, eType, resolved))
+		return connectResolvedAddress(currentConnInfo, resolved, IPAddress, eType);
+
+	//-- Continue connecting in resolver thread. Quests are cached meanwhile.
+	TCPClientPtr self = shared_from_this();
+	bool launched = DNSResolver::instance()->resolve(_hostname,
+		[self, currentConnInfo](bool ok, const std::string& address, EndPointType type) {
+			self->connectResolvedAddress(currentConnInfo, ok, address, type);
+		});
+
+	if (!launched)
+		return connectResolvedAddress(currentConnInfo, false, IPAddress, eType);
+
+	return true;
+}
+
+bool TCPClient::connectResolvedAddress(ConnectionInfoPtr currConnInfo, bool resolved, const std::string& IPAddress, EndPointType eType)
+{
+	if (!resolved)
+	{
+		//-- Checks the attempt is still current first. A stale attempt mustn't trigger the failed event.
+		if (!connectFailed(currConnInfo, FPNN_EC_CORE_INVALID_CONNECTION))
+			return false;		//-- Connecting is cancelled.
+
+		LOG_ERROR("Get IP address for %s failed. TCP client connect remote server %s failed.", _hostname.c_str(), currConnInfo->str().c_str());
+		triggerConnectingFailedEvent(currConnInfo, FPNN_EC_CORE_INVALID_CONNECTION);
+		return false;
+	}
+
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		if (currConnInfo.get() != _connectionInfo.get())
+			return false;		//-- Connecting is cancelled.
+
+		currConnInfo = updateResolvedAddress(IPAddress, eType);
+	}
+
+	return connectAddress(currConnInfo);
+}
+
+bool TCPClient::connectAddress(ConnectionInfoPtr currConnInfo)
+{
 	bool connected = false;
 	int socket = 0;
 	if (_isIPv4)
-		socket = connectIPv4Address(currentConnInfo, connected);
+		socket = connectIPv4Address(currConnInfo, connected);
 	else
-		socket = connectIPv6Address(currentConnInfo, connected);
+		socket = connectIPv6Address(currConnInfo, connected);
 
 	if (socket == 0)
 	{
-		LOG_ERROR("TCP client connect remote server %s failed.", currentConnInfo->str().c_str());
-		connectFailed(currentConnInfo, FPNN_EC_CORE_INVALID_CONNECTION);
-		triggerConnectingFailedEvent(currentConnInfo, FPNN_EC_CORE_INVALID_CONNECTION);
+		LOG_ERROR("TCP client connect remote server %s failed.", currConnInfo->str().c_str());
+		if (connectFailed(currConnInfo, FPNN_EC_CORE_INVALID_CONNECTION))
+			triggerConnectingFailedEvent(currConnInfo, FPNN_EC_CORE_INVALID_CONNECTION);
 		return false;
 	}
 
-	return perpareConnection(socket, connected, currentConnInfo);
+	return perpareConnection(socket, connected, currConnInfo);
 }
 
 void TCPClient::triggerConnectingFailedEvent(ConnectionInfoPtr connInfo, int errorCode)
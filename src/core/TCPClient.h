@@ -5,6 +5,7 @@
 #include "NetworkUtility.h"
 #include "TCPClientIOWorker.h"
 #include "KeyExchange.h"
+#include "ECCKeysPool.h"
 #include "ClientInterface.h"
 
 namespace fpnn
@@ -22,6 +23,7 @@ namespace fpnn
 		bool _packageEncryptionMode;
 		std::string _eccCurve;
 		std::string _serverPublicKey;
+		size_t _reservedEncryptionKeys;
 		//----------
 		TCPClientKeepAliveParams* _keepAliveParams;
 		//----------
@@ -34,9 +36,14 @@ namespace fpnn
 		int connectIPv4Address(ConnectionInfoPtr currConnInfo, bool& connected);
 		int connectIPv6Address(ConnectionInfoPtr currConnInfo, bool& connected);
 		bool perpareConnection(int socket, bool connected, ConnectionInfoPtr currConnInfo);
-		void cacheSendQuest(FPQuestPtr quest, BasicAnswerCallback* callback, int timeout);
+		bool connectAddress(ConnectionInfoPtr currConnInfo);
+		bool connectResolvedAddress(ConnectionInfoPtr currConnInfo, bool resolved, const std::string& IPAddress, EndPointType eType);
+		void cacheSendQuest(FPQuestPtr quest, BasicAnswerCallback* callback, int timeoutMsec);
 		void dumpCachedSendData(ConnectionInfoPtr connInfo);
 		void triggerConnectingFailedEvent(ConnectionInfoPtr connInfo, int errorCode);
+		bool sendQuestWithBasicAnswerCallback(FPQuestPtr quest, BasicAnswerCallback* callback, int timeoutMsec);
+
+		friend class MultiEndpointClient;
 
 		TCPClient(const std::string& host, int port, bool autoReconnect = true);
 
@@ -52,7 +59,8 @@ namespace fpnn
 		=============================================================================== */
 		void dealQuest(FPQuestPtr quest, ConnectionInfoPtr connectionInfo);
 		void socketConnected(TCPClientConnection* conn, bool connected);
-		void connectFailed(ConnectionInfoPtr connInfo, int errorCode);
+		//-- Returns false if connInfo isn't the current connecting, which is cancelled or replaced.
+		bool connectFailed(ConnectionInfoPtr connInfo, int errorCode);
 		bool connectSuccessed(TCPClientConnection* conn);
 
 		/*===============================================================================
@@ -64,6 +72,9 @@ namespace fpnn
 			_serverPublicKey = peerPublicKey;
 			_packageEncryptionMode = packageMode;
 			_AESKeyLen = reinforce ? 32 : 16;
+
+			if (_reservedEncryptionKeys)
+				ECCKeysPool::instance()->reserve(_eccCurve, _serverPublicKey, _AESKeyLen, _reservedEncryptionKeys);
 		}
 
 		bool enableEncryptorByDerData(const std::string &derData, bool packageMode = true, bool reinforce = false);
@@ -71,6 +82,14 @@ namespace fpnn
 		bool enableEncryptorByDerFile(const char *derFilePath, bool packageMode = true, bool reinforce = false);
 		bool enableEncryptorByPemFile(const char *pemFilePath, bool packageMode = true, bool reinforce = false);
 
+		/*
+			Keeps count ECDH results prepared in background for the encryptor configuration (see ECCKeysPool).
+			Connecting & reconnecting take a prepared result instead of doing ECDH on the connecting path.
+			If the stock is empty, the ECDH is done on the connecting path as usual. 0 (default) means disabled.
+			Can be called before or after enableEncryptor*().
+		*/
+		void reserveEncryptionKeys(size_t count);
+
 		virtual void keepAlive();
 		void setKeepAlivePingTimeout(int seconds);
 		void setKeepAliveInterval(int seconds);
@@ -98,9 +117,39 @@ namespace fpnn
 
 			timeout in seconds.
 		*/
-		virtual FPAnswerPtr sendQuest(FPQuestPtr quest, int timeout = 0);
-		virtual bool sendQuest(FPQuestPtr quest, AnswerCallback* callback, int timeout = 0);
-		virtual bool sendQuest(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeout = 0);
+		virtual FPAnswerPtr sendQuest(FPQuestPtr quest, int timeout = 0)
+		{
+			return sendQuestMsec(quest, timeout * 1000);
+		}
+		virtual bool sendQuest(FPQuestPtr quest, AnswerCallback* callback, int timeout = 0)
+		{
+			return sendQuestMsec(quest, callback, timeout * 1000);
+		}
+		virtual bool sendQuest(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeout = 0)
+		{
+			return sendQuestMsec(quest, std::move(task), timeout * 1000);
+		}
+
+		//-- Timeout in milliseconds
+		virtual FPAnswerPtr sendQuestMsec(FPQuestPtr quest, int timeoutMsec = 0);
+		virtual bool sendQuestMsec(FPQuestPtr quest, AnswerCallback* callback, int timeoutMsec = 0);
+		virtual bool sendQuestMsec(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeoutMsec = 0);
+
+		/*
+			Batched pipelined sending. All quests are serialized, all callbacks are registered under one lock,
+			and all frames are queued as one batch and flushed by gathered writev() calls.
+
+			callbackFactory is called for each two-way quest, with the quest and its index in quests.
+			It MUST return a new AnswerCallback. Oneway quests don't require callbacks.
+
+			If return true, the callbacks will be deleted by SDK after called.
+			If return false, no quest is sent, and the created callbacks are deleted by SDK without being called.
+		*/
+		bool sendQuests(const std::vector<FPQuestPtr>& quests, std::function<AnswerCallback* (FPQuestPtr quest, size_t index)> callbackFactory, int timeout = 0)
+		{
+			return sendQuestsMsec(quests, std::move(callbackFactory), timeout * 1000);
+		}
+		bool sendQuestsMsec(const std::vector<FPQuestPtr>& quests, std::function<AnswerCallback* (FPQuestPtr quest, size_t index)> callbackFactory, int timeoutMsec = 0);
 
 		inline static TCPClientPtr createClient(const std::string& host, int port, bool autoReconnect = true)
 		{
@@ -152,6 +152,11 @@ namespace fpnn
 			_activeTime = time(NULL);
 			return _sendBuffer.send(_connectionInfo->socket, needWaitSendEvent, data);
 		}
+		inline int send(bool& needWaitSendEvent, std::vector<std::string*>& dataList)
+		{
+			_activeTime = time(NULL);
+			return _sendBuffer.send(_connectionInfo->socket, needWaitSendEvent, dataList);
+		}
 		
 		TCPClientConnection(TCPClientPtr client, ConnectionInfoPtr connectionInfo, IQuestProcessorPtr questProcessor):
 			BasicConnection(connectionInfo), _client(client), _keepAliveInfos(NULL),
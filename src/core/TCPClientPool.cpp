@@ -0,0 +1,243 @@
+#include <limits.h>
+#include "FPLog.h"
+#include "TCPClientPool.h"
+
+using namespace fpnn;
+
+TCPClientPool::TCPClientPool(const std::string& host, int port, int connectionCount, bool autoReconnect):
+	Client(host, port, autoReconnect), _dispatchIndex(0), _membersPrepared(false)
+{
+	//-- Members share the address cache of DNSResolver, a domain is resolved once for all members.
+	_members.reserve(connectionCount);
+	for (int i = 0; i < connectionCount; i++)
+		_members.push_back(TCPClient::createClient(host, port, autoReconnect));
+}
+
+TCPClientPool::~TCPClientPool()
+{
+	if (_membersPrepared)
+		close();
+}
+
+//-- MUST be called under _mutex.
+void TCPClientPool::prepareMembers()
+{
+	for (auto& member: _members)
+	{
+		if (_questProcessor)
+			member->setQuestProcessor(_questProcessor);
+
+		member->setQuestTimeoutMsec(_timeoutQuest);
+		member->setAutoReconnect(_autoReconnect);
+		member->setInlineAnswerCallback(isInlineAnswerCallback());
+		member->setOrderedCallbacks(_orderedCallbacks);
+
+		if (_embedRecvNotifyDeleagte)
+			member->embed_configRecvNotifyDelegate(_embedRecvNotifyDeleagte);
+	}
+
+	_membersPrepared = true;
+}
+
+/*
+	Dispatch to the connected member with the fewest outstanding quests. Members are scanned from a rotating
+	start position, so equal members are used in turn. Disconnected members are reconnected asynchronously
+	if auto reconnect is enabled. If no member is connected, the member at the start position is used.
+*/
+TCPClientPtr TCPClientPool::dispatch()
+{
+	if (!_membersPrepared)
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		if (!_membersPrepared)
+			prepareMembers();
+	}
+
+	size_t count = _members.size();
+	size_t start = _dispatchIndex++ % count;
+
+	TCPClientPtr best;
+	int bestCount = INT_MAX;
+	for (size_t i = 0; i < count; i++)
+	{
+		const TCPClientPtr& member = _members[(start + i) % count];
+		if (!member->connected())
+		{
+			if (_autoReconnect)
+				member->asyncConnect();
+
+			continue;
+		}
+
+		ConnectionInfoPtr connInfo = member->connectionInfo();
+		int outstanding = ClientEngine::instance()->outstandingQuestCount(connInfo->socket, connInfo->token);
+		if (outstanding < 0 || outstanding >= bestCount)
+			continue;
+
+		best = member;
+		bestCount = outstanding;
+		if (outstanding == 0)
+			break;
+	}
+
+	if (best)
+		return best;
+
+	return _members[start];
+}
+
+void TCPClientPool::enableEncryptor(const std::string& curve, const std::string& peerPublicKey, bool packageMode, bool reinforce)
+{
+	for (auto& member: _members)
+		member->enableEncryptor(curve, peerPublicKey, packageMode, reinforce);
+}
+
+bool TCPClientPool::enableEncryptorByDerData(const std::string &derData, bool packageMode, bool reinforce)
+{
+	for (auto& member: _members)
+		if (member->enableEncryptorByDerData(derData, packageMode, reinforce) == false)
+			return false;
+
+	return true;
+}
+
+bool TCPClientPool::enableEncryptorByPemData(const std::string &PemData, bool packageMode, bool reinforce)
+{
+	for (auto& member: _members)
+		if (member->enableEncryptorByPemData(PemData, packageMode, reinforce) == false)
+			return false;
+
+	return true;
+}
+
+bool TCPClientPool::enableEncryptorByDerFile(const char *derFilePath, bool packageMode, bool reinforce)
+{
+	for (auto& member: _members)
+		if (member->enableEncryptorByDerFile(derFilePath, packageMode, reinforce) == false)
+			return false;
+
+	return true;
+}
+
+bool TCPClientPool::enableEncryptorByPemFile(const char *pemFilePath, bool packageMode, bool reinforce)
+{
+	for (auto& member: _members)
+		if (member->enableEncryptorByPemFile(pemFilePath, packageMode, reinforce) == false)
+			return false;
+
+	return true;
+}
+
+void TCPClientPool::reserveEncryptionKeys(size_t count)
+{
+	for (auto& member: _members)
+		member->reserveEncryptionKeys(count);
+}
+
+void TCPClientPool::keepAlive()
+{
+	for (auto& member: _members)
+		member->keepAlive();
+}
+
+void TCPClientPool::setKeepAlivePingTimeout(int seconds)
+{
+	for (auto& member: _members)
+		member->setKeepAlivePingTimeout(seconds);
+}
+
+void TCPClientPool::setKeepAliveInterval(int seconds)
+{
+	for (auto& member: _members)
+		member->setKeepAliveInterval(seconds);
+}
+
+void TCPClientPool::setKeepAliveMaxPingRetryCount(int count)
+{
+	for (auto& member: _members)
+		member->setKeepAliveMaxPingRetryCount(count);
+}
+
+void TCPClientPool::setConnectTimeout(int seconds)
+{
+	for (auto& member: _members)
+		member->setConnectTimeout(seconds);
+}
+
+bool TCPClientPool::connect()
+{
+	if (!asyncConnect())
+		return false;
+
+	bool connected = false;
+	for (auto& member: _members)
+		if (member->connect())
+			connected = true;
+
+	return connected;
+}
+
+bool TCPClientPool::asyncConnect()
+{
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		prepareMembers();
+	}
+
+	bool launched = false;
+	for (auto& member: _members)
+		if (member->asyncConnect())
+			launched = true;
+
+	if (!launched)
+		LOG_ERROR("All member connections of TCP client pool to %s connect failed.", _endpoint.c_str());
+
+	return launched;
+}
+
+bool TCPClientPool::connected()
+{
+	for (auto& member: _members)
+		if (member->connected())
+			return true;
+
+	return false;
+}
+
+void TCPClientPool::close()
+{
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		_membersPrepared = false;
+	}
+
+	for (auto& member: _members)
+		member->close();
+}
+
+FPAnswerPtr TCPClientPool::sendQuestMsec(FPQuestPtr quest, int timeoutMsec)
+{
+	return dispatch()->sendQuestMsec(quest, timeoutMsec);
+}
+
+bool TCPClientPool::sendQuestMsec(FPQuestPtr quest, AnswerCallback* callback, int timeoutMsec)
+{
+	return dispatch()->sendQuestMsec(quest, callback, timeoutMsec);
+}
+
+bool TCPClientPool::sendQuestMsec(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeoutMsec)
+{
+	return dispatch()->sendQuestMsec(quest, std::move(task), timeoutMsec);
+}
+
+void TCPClientPool::embed_configRecvNotifyDelegate(EmbedRecvNotifyDelegate delegate)
+{
+	_embedRecvNotifyDeleagte = delegate;
+	for (auto& member: _members)
+		member->embed_configRecvNotifyDelegate(delegate);
+}
+
+bool TCPClientPool::embed_sendData(std::string* rawData)
+{
+	return dispatch()->embed_sendData(rawData);
+}
@@ -0,0 +1,125 @@
+#ifndef FPNN_TCP_Client_Pool_H
+#define FPNN_TCP_Client_Pool_H
+
+#include <vector>
+#include "TCPClient.h"
+
+namespace fpnn
+{
+	class TCPClientPool;
+	typedef std::shared_ptr<TCPClientPool> TCPClientPoolPtr;
+
+	//=================================================================//
+	//- TCP Client Pool:
+	//=================================================================//
+	/*
+		Keeps N TCP connections to the same endpoint, with the same interfaces as Client.
+		Each quest is dispatched to the connected member with the fewest outstanding quests,
+		so a large answer on one connection doesn't block the small answers on the others.
+
+		*. Each member is a TCPClient, reconnecting & keep-alive are processed by each member itself.
+		*. Configurations of Client (quest processor, quest timeout, auto reconnect, inline & ordered callbacks)
+			are applied to members when the pool connecting, or when the first quest sent.
+			Please configure the pool before connecting.
+		*. Connection events of the quest processor are triggered for each member connection.
+		*. Ordered callbacks are only ordered in each member connection.
+	*/
+	class TCPClientPool: public Client
+	{
+		std::vector<TCPClientPtr> _members;
+		std::atomic<uint32_t> _dispatchIndex;
+		std::atomic<bool> _membersPrepared;
+
+		TCPClientPool(const std::string& host, int port, int connectionCount, bool autoReconnect = true);
+
+		void prepareMembers();
+		TCPClientPtr dispatch();
+
+	public:
+		virtual ~TCPClientPool();
+
+		/*===============================================================================
+		  Call by Developer. Configure Function. Applied to all member connections.
+		=============================================================================== */
+		void enableEncryptor(const std::string& curve, const std::string& peerPublicKey, bool packageMode = true, bool reinforce = false);
+		bool enableEncryptorByDerData(const std::string &derData, bool packageMode = true, bool reinforce = false);
+		bool enableEncryptorByPemData(const std::string &PemData, bool packageMode = true, bool reinforce = false);
+		bool enableEncryptorByDerFile(const char *derFilePath, bool packageMode = true, bool reinforce = false);
+		bool enableEncryptorByPemFile(const char *pemFilePath, bool packageMode = true, bool reinforce = false);
+		//-- Members share one stock of prepared ECDH results.
+		void reserveEncryptionKeys(size_t count);
+
+		virtual void keepAlive();
+		void setKeepAlivePingTimeout(int seconds);
+		void setKeepAliveInterval(int seconds);
+		void setKeepAliveMaxPingRetryCount(int count);
+		void setConnectTimeout(int seconds);
+
+		inline size_t connectionCount() { return _members.size(); }
+		inline TCPClientPtr member(size_t index) { return _members[index]; }
+
+		/*===============================================================================
+		  Call by Developer.
+		=============================================================================== */
+		/*
+			All members are connected. Returns true if any member connected.
+			The failed members will be reconnected when dispatched if auto reconnect is enabled.
+		*/
+		virtual bool connect();
+		virtual bool asyncConnect();
+		virtual void close();
+		//-- Returns true if any member is connected.
+		virtual bool connected();
+
+		/**
+			All SendQuest():
+				If return false, caller must free quest & callback.
+				If return true, don't free quest & callback.
+
+			timeout in seconds.
+		*/
+		virtual FPAnswerPtr sendQuest(FPQuestPtr quest, int timeout = 0)
+		{
+			return sendQuestMsec(quest, timeout * 1000);
+		}
+		virtual bool sendQuest(FPQuestPtr quest, AnswerCallback* callback, int timeout = 0)
+		{
+			return sendQuestMsec(quest, callback, timeout * 1000);
+		}
+		virtual bool sendQuest(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeout = 0)
+		{
+			return sendQuestMsec(quest, std::move(task), timeout * 1000);
+		}
+
+		//-- Timeout in milliseconds
+		virtual FPAnswerPtr sendQuestMsec(FPQuestPtr quest, int timeoutMsec = 0);
+		virtual bool sendQuestMsec(FPQuestPtr quest, AnswerCallback* callback, int timeoutMsec = 0);
+		virtual bool sendQuestMsec(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeoutMsec = 0);
+
+		inline static TCPClientPoolPtr createClient(const std::string& host, int port, int connectionCount, bool autoReconnect = true)
+		{
+			if (connectionCount < 1)
+				connectionCount = 1;
+
+			return TCPClientPoolPtr(new TCPClientPool(host, port, connectionCount, autoReconnect));
+		}
+		inline static TCPClientPoolPtr createClient(const std::string& endpoint, int connectionCount, bool autoReconnect = true)
+		{
+			std::string host;
+			int port;
+
+			if (!parseAddress(endpoint, host, port))
+				return nullptr;
+
+			return createClient(host, port, connectionCount, autoReconnect);
+		}
+
+		/*===============================================================================
+		  Interfaces for embed mode.
+		=============================================================================== */
+		virtual void embed_configRecvNotifyDelegate(EmbedRecvNotifyDelegate delegate);
+		virtual bool embed_sendData(std::string* rawData);
+	};
+}
+
+#endif
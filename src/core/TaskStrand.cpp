@@ -0,0 +1,110 @@
+#include "TaskThreadPool.h"
+#include "ClientEngine.h"
+#include "TaskStrand.h"
+
+using namespace fpnn;
+
+//-- If return false, task is kept.
+bool TaskStrand::post(WorkStealingThreadPool::TaskItem& task)
+{
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		_tasks.push_back(std::move(task));
+		if (_scheduled)
+			return true;
+
+		_scheduled = true;
+	}
+
+	if (ClientEngine::runTask(shared_from_this()))
+		return true;
+
+	/*
+		Only the current task fails. The strand was idle, so the first one is the current task.
+		The tasks posted concurrently have been accepted, so they are run in current thread.
+	*/
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		task = std::move(_tasks.front());
+		_tasks.pop_front();
+
+		if (_tasks.empty())
+		{
+			_scheduled = false;
+			return false;
+		}
+	}
+
+	LOG_ERROR("Wake up thread pool to run strand failed. The tasks posted concurrently are run in current thread.");
+	run();
+	return false;
+}
+
+bool TaskStrand::post(ITaskThreadPool::ITaskPtr task)
+{
+	if (!task)
+		return true;
+
+	WorkStealingThreadPool::TaskItem item(std::move(task));
+	return post(item);
+}
+
+bool TaskStrand::post(ITaskThreadPool::ITask* task)
+{
+	if (task == NULL)
+		return true;
+
+	WorkStealingThreadPool::TaskItem item(task);
+	if (post(item))
+		return true;
+
+	item.detachOwnedTask();
+	return false;
+}
+
+bool TaskStrand::post(std::function<void ()> task)
+{
+	TaskThreadPool::FunctionTask* t = new TaskThreadPool::FunctionTask(std::move(task));
+	if (post(t))
+		return true;
+
+	delete t;
+	return false;
+}
+
+void TaskStrand::run()
+{
+	while (true)
+	{
+		for (int i = 0; i < BatchSize; i++)
+		{
+			WorkStealingThreadPool::TaskItem task;
+			{
+				std::unique_lock<std::mutex> lck(_mutex);
+				if (_tasks.empty())
+				{
+					_scheduled = false;
+					return;
+				}
+
+				task = std::move(_tasks.front());
+				_tasks.pop_front();
+			}
+
+			task.run();
+		}
+
+		{
+			std::unique_lock<std::mutex> lck(_mutex);
+			if (_tasks.empty())
+			{
+				_scheduled = false;
+				return;
+			}
+		}
+
+		//-- Yield to other tasks. If rescheduling failed (pool is exiting), continue in current thread.
+		if (ClientEngine::runTask(shared_from_this()))
+			return;
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef FPNN_Task_Strand_H
+#define FPNN_Task_Strand_H
+
+#include <mutex>
+#include <deque>
+#include <memory>
+#include <functional>
+#include "WorkStealingThreadPool.h"
+
+namespace fpnn
+{
+	class TaskStrand;
+	typedef std::shared_ptr<TaskStrand> TaskStrandPtr;
+
+	/*
+		Serial lane on top of the ClientEngine task thread pool.
+
+		Tasks posted into the same strand are run one by one in posted order, on any free pool thread.
+		The strand is scheduled into the pool only when it has tasks, and no pool thread blocks on the strand:
+		the strand mutex only guards the task queue, and is never held when a task is running.
+
+		After BatchSize tasks were run, the rest tasks are rescheduled into the pool, for other strands & tasks.
+	*/
+	class TaskStrand: public ITaskThreadPool::ITask, public std::enable_shared_from_this<TaskStrand>
+	{
+		enum
+		{
+			BatchSize = 32,
+		};
+
+		std::mutex _mutex;
+		std::deque<WorkStealingThreadPool::TaskItem> _tasks;
+		bool _scheduled;		//-- True if the strand is queued in pool or is running.
+
+		TaskStrand(): _scheduled(false) {}
+		bool post(WorkStealingThreadPool::TaskItem& task);
+
+	public:
+		static TaskStrandPtr create() { return TaskStrandPtr(new TaskStrand()); }
+		virtual ~TaskStrand() {}
+
+		/*
+			If return false, the thread pool refused the strand (pool queue limitation is caught, or pool is exiting).
+			Only the task isn't queued. The other tasks posted concurrently when the strand is idle were accepted,
+			they are run in the thread which posted the refused task.
+		*/
+		bool post(ITaskThreadPool::ITaskPtr task);
+		bool post(std::function<void ()> task);
+		//-- The task will be deleted after running. If return false, the caller keeps the ownership.
+		bool post(ITaskThreadPool::ITask* task);
+
+		//-- Called by thread pool only.
+		virtual void run();
+	};
+}
+
+#endif
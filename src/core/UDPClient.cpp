@@ -8,6 +8,7 @@
 #include "FPWriter.h"
 #include "AutoRelease.h"
 #include "FileSystemUtil.h"
+#include "DNSResolver.h"
 #include "PEM_DER_SAX.h"
 
 using namespace fpnn;
@@ -108,7 +109,7 @@ void UDPClient::dealQuest(FPQuestPtr quest, ConnectionInfoPtr connectionInfo)		/
 	}
 
 	std::shared_ptr<UDPQuestTask> task(new UDPQuestTask(shared_from_this(), quest, connectionInfo));
-	if (ClientEngine::runTask(task) == false)
+	if (runCallbackTask(task) == false)
 	{
 		LOG_ERROR("wake up thread pool to process UDP quest failed. Quest pool limitation is caught. Quest task havn't be executed. %s",
 			connectionInfo->str().c_str());
@@ -245,6 +246,15 @@ bool UDPClient::connect()
 	if (_connected)
 		return true;
 
+	//-- Synchronous connecting. Cached address is used, or waits for the resolver thread.
+	std::string IPAddress;
+	EndPointType eType = ENDPOINT_TYPE_IP4;
+	if (_hostname.size() && !DNSResolver::instance()->resolveSync(_hostname, IPAddress, eType))
+	{
+		LOG_ERROR("Get IP address for %s failed. UDP client connect remote server %s failed.", _hostname.c_str(), _endpoint.c_str());
+		return false;
+	}
+
 	ConnectionInfoPtr currConnInfo;
 	{
 		std::unique_lock<std::mutex> lck(_mutex);
@@ -254,6 +264,9 @@ bool UDPClient::connect()
 		if (_connStatus == ConnStatus::Connected)
 			return true;
 
+		if (_hostname.size())
+			updateResolvedAddress(IPAddress, eType)->changeToUDP();
+
 		currConnInfo = _connectionInfo;
 
 		_connected = false;
@@ -412,9 +425,9 @@ FPAnswerPtr UDPClient::sendQuestEx(FPQuestPtr quest, bool discardable, int timeo
 	Config::ClientQuestLog(quest, connInfo->ip, connInfo->port);
 
 	if (timeoutMsec == 0)
-		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, &_mutex, quest, _timeoutQuest, discardable);
+		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, NULL, quest, _timeoutQuest, discardable);
 	else
-		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, &_mutex, quest, timeoutMsec, discardable);
+		return ClientEngine::instance()->sendQuest(connInfo->socket, connInfo->token, NULL, quest, timeoutMsec, discardable);
 }
 bool UDPClient::sendQuestEx(FPQuestPtr quest, AnswerCallback* callback, bool discardable, int timeoutMsec)
 {
@@ -488,7 +501,7 @@ bool UDPClient::embed_sendData(std::string* rawData, bool discardable, int timeo
 	//-- Config::ClientQuestLog(quest, connInfo->ip, connInfo->port);
 	int64_t expiredMS = (timeoutMsec == 0) ? _timeoutQuest : timeoutMsec;
 	if (expiredMS == 0)
-		expiredMS = ClientEngine::getQuestTimeout() * 1000;
+		expiredMS = ClientEngine::getQuestTimeoutMsec();
 
 	expiredMS += slack_real_msec();
 
@@ -109,6 +109,20 @@ namespace fpnn
 			return sendQuestEx(quest, std::move(task), quest->isOneWay(), timeout * 1000);
 		}
 
+		//-- Timeout in milliseconds
+		virtual FPAnswerPtr sendQuestMsec(FPQuestPtr quest, int timeoutMsec = 0)
+		{
+			return sendQuestEx(quest, quest->isOneWay(), timeoutMsec);
+		}
+		virtual bool sendQuestMsec(FPQuestPtr quest, AnswerCallback* callback, int timeoutMsec = 0)
+		{
+			return sendQuestEx(quest, callback, quest->isOneWay(), timeoutMsec);
+		}
+		virtual bool sendQuestMsec(FPQuestPtr quest, std::function<void (FPAnswerPtr answer, int errorCode)> task, int timeoutMsec = 0)
+		{
+			return sendQuestEx(quest, std::move(task), quest->isOneWay(), timeoutMsec);
+		}
+
 		//-- Timeout in milliseconds
 		virtual FPAnswerPtr sendQuestEx(FPQuestPtr quest, bool discardable, int timeoutMsec = 0);
 		virtual bool sendQuestEx(FPQuestPtr quest, AnswerCallback* callback, bool discardable, int timeoutMsec = 0);
@@ -4,9 +4,9 @@
 /*
 *	Embed 注意事项：
 *
-*	0. **强烈建议** 上层语言将域名解析成IP(IPv4/IPv6)后，再传入C++ SDK层。否则创建 Client(TCPClient/UDPClient)
-*	   时，C++ SDK 会去执行DNS 解析。但目前DNS解析在各平台没有通用的异步解析接口。因此此时的DNS解析。将会调用同步接口，
-*	   因此极有可能导致上层调用的阻塞。
+*	0. 传入域名时，TCPClient 的 DNS 解析由 DNSResolver 在其线程池中异步执行，并按 TTL 缓存，创建 Client 和
+*	   asyncConnect() 均不会因解析而阻塞。UDPClient 的 connect() 为同步接口，缓存未命中时将等待解析完成。
+*	   若上层语言已有解析结果，依然建议传入 IP(IPv4/IPv6)。
 *	
 *	1. 发送数据(FPNN 的二进制数据)请使用 Client/TCPClient/UDPClient 的 embed_sendData() 接口；
 *	2. Client/TCPClient/UDPClient 的 embed_sendData() 接口为异步接口，同步发送需要上层封装。上层封装可参见
@@ -3,6 +3,10 @@
 #include "uECC.h"
 #include "uECC_vli.h"
 
+#if uECC_FIXED_BASE_TABLE
+    #include <stdlib.h>
+#endif
+
 #ifndef uECC_RNG_MAX_TRIES
     #define uECC_RNG_MAX_TRIES 64
 #endif
@@ -912,6 +916,302 @@ static uECC_word_t regularize_k(const uECC_word_t * const k,
     return carry;
 }
 
+#if uECC_FIXED_BASE_TABLE
+
+/* Fixed-base multiplication with 4-bit windows.
+   For window i, the table holds (d + 1) * 16^i * G for d = 0..15, in affine coordinates. Digits are offset
+   by 1, so no window selects the point at infinity, and every window costs one mixed addition. The offset
+   S = sum(16^i) is removed at the end by adding the last table entry -S * G.
+   Entries are selected by scanning all 16 entries of a window, so the memory access pattern does not depend
+   on the scalar. */
+
+#define uECC_FIXED_BASE_WINDOW_BITS 4
+#define uECC_FIXED_BASE_WINDOW_SIZE 16
+#define uECC_BATCH_SIZE 16
+
+#define fixed_base_windows(curve) \
+    (((curve)->num_n_bits + uECC_FIXED_BASE_WINDOW_BITS - 1) / uECC_FIXED_BASE_WINDOW_BITS)
+
+static uECC_word_t *g_fixed_base_tables[5];
+static volatile int g_fixed_base_enabled = 1;
+
+#if defined(__GNUC__) || defined(__clang__)
+static uECC_word_t *fixed_base_load(uECC_word_t **slot) {
+    return __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+}
+
+/* Returns 0 if another thread published its table first. */
+static int fixed_base_publish(uECC_word_t **slot, uECC_word_t *table) {
+    uECC_word_t *expected = 0;
+    return __atomic_compare_exchange_n(slot, &expected, table, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#else
+/* Without atomics, call uECC_precompute_fixed_base() before using the curve in multiple threads. */
+static uECC_word_t *fixed_base_load(uECC_word_t **slot) {
+    return *slot;
+}
+
+static int fixed_base_publish(uECC_word_t **slot, uECC_word_t *table) {
+    *slot = table;
+    return 1;
+}
+#endif
+
+static uECC_word_t **fixed_base_slot(uECC_Curve curve) {
+#if uECC_SUPPORTS_secp160r1
+    if (curve == uECC_secp160r1()) return &g_fixed_base_tables[0];
+#endif
+#if uECC_SUPPORTS_secp192r1
+    if (curve == uECC_secp192r1()) return &g_fixed_base_tables[1];
+#endif
+#if uECC_SUPPORTS_secp224r1
+    if (curve == uECC_secp224r1()) return &g_fixed_base_tables[2];
+#endif
+#if uECC_SUPPORTS_secp256r1
+    if (curve == uECC_secp256r1()) return &g_fixed_base_tables[3];
+#endif
+#if uECC_SUPPORTS_secp256k1
+    if (curve == uECC_secp256k1()) return &g_fixed_base_tables[4];
+#endif
+    return 0;
+}
+
+/* (X1, Y1, Z1) => (X1, Y1, Z1) + (x2, y2)
+   Returns 0 if the points are equal or opposite, and the formula is not applicable. */
+static uECC_word_t EccPoint_add_mixed(uECC_word_t * X1,
+                                      uECC_word_t * Y1,
+                                      uECC_word_t * Z1,
+                                      const uECC_word_t * x2,
+                                      const uECC_word_t * y2,
+                                      uECC_Curve curve) {
+    uECC_word_t t1[uECC_MAX_WORDS];
+    uECC_word_t t2[uECC_MAX_WORDS];
+    uECC_word_t t3[uECC_MAX_WORDS];
+    uECC_word_t t4[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+
+    uECC_vli_modSquare_fast(t1, Z1, curve);           /* t1 = z1^2 */
+    uECC_vli_modMult_fast(t2, t1, Z1, curve);         /* t2 = z1^3 */
+    uECC_vli_modMult_fast(t1, t1, x2, curve);         /* t1 = x2*z1^2 = U2 */
+    uECC_vli_modMult_fast(t2, t2, y2, curve);         /* t2 = y2*z1^3 = S2 */
+    uECC_vli_modSub(t1, t1, X1, curve->p, num_words); /* t1 = U2 - x1 = H */
+    uECC_vli_modSub(t2, t2, Y1, curve->p, num_words); /* t2 = S2 - y1 = R */
+
+    if (uECC_vli_isZero(t1, num_words)) {
+        return 0;
+    }
+
+    uECC_vli_modMult_fast(Z1, Z1, t1, curve);         /* z3 = z1*H */
+    uECC_vli_modSquare_fast(t3, t1, curve);           /* t3 = H^2 */
+    uECC_vli_modMult_fast(t4, t3, t1, curve);         /* t4 = H^3 */
+    uECC_vli_modMult_fast(t3, t3, X1, curve);         /* t3 = x1*H^2 */
+    uECC_vli_modSquare_fast(X1, t2, curve);           /* x3 = R^2 */
+    uECC_vli_modSub(X1, X1, t4, curve->p, num_words); /* x3 = R^2 - H^3 */
+    uECC_vli_modSub(X1, X1, t3, curve->p, num_words);
+    uECC_vli_modSub(X1, X1, t3, curve->p, num_words); /* x3 = R^2 - H^3 - 2*x1*H^2 */
+    uECC_vli_modSub(t3, t3, X1, curve->p, num_words); /* t3 = x1*H^2 - x3 */
+    uECC_vli_modMult_fast(t3, t3, t2, curve);         /* t3 = R*(x1*H^2 - x3) */
+    uECC_vli_modMult_fast(t4, t4, Y1, curve);         /* t4 = y1*H^3 */
+    uECC_vli_modSub(Y1, t3, t4, curve->p, num_words); /* y3 = R*(x1*H^2 - x3) - y1*H^3 */
+    return 1;
+}
+
+/* Converts count Jacobian points to affine coordinates with one modular inversion (Montgomery's trick).
+   All Z values must be non-zero. count must not exceed uECC_BATCH_SIZE. */
+static void EccPoint_normalize_batch(uECC_word_t X[][uECC_MAX_WORDS],
+                                     uECC_word_t Y[][uECC_MAX_WORDS],
+                                     uECC_word_t Z[][uECC_MAX_WORDS],
+                                     unsigned count,
+                                     uECC_Curve curve) {
+    uECC_word_t prefix[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t inv[uECC_MAX_WORDS];
+    uECC_word_t z_inv[uECC_MAX_WORDS];
+    uECC_word_t t1[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+    unsigned i;
+
+    uECC_vli_set(prefix[0], Z[0], num_words);
+    for (i = 1; i < count; ++i) {
+        uECC_vli_modMult_fast(prefix[i], prefix[i - 1], Z[i], curve);
+    }
+
+    uECC_vli_modInv(inv, prefix[count - 1], curve->p, num_words); /* 1 / (z0 * ... * zn) */
+
+    for (i = count; i-- > 0; ) {
+        if (i > 0) {
+            uECC_vli_modMult_fast(z_inv, inv, prefix[i - 1], curve); /* 1 / zi */
+            uECC_vli_modMult_fast(inv, inv, Z[i], curve);            /* 1 / (z0 * ... * zi-1) */
+        } else {
+            uECC_vli_set(z_inv, inv, num_words);
+        }
+
+        uECC_vli_modSquare_fast(t1, z_inv, curve);     /* 1 / zi^2 */
+        uECC_vli_modMult_fast(X[i], X[i], t1, curve);
+        uECC_vli_modMult_fast(t1, t1, z_inv, curve);   /* 1 / zi^3 */
+        uECC_vli_modMult_fast(Y[i], Y[i], t1, curve);
+    }
+}
+
+static uECC_word_t *build_fixed_base_table(uECC_Curve curve) {
+    uECC_word_t X[uECC_FIXED_BASE_WINDOW_SIZE][uECC_MAX_WORDS];
+    uECC_word_t Y[uECC_FIXED_BASE_WINDOW_SIZE][uECC_MAX_WORDS];
+    uECC_word_t Z[uECC_FIXED_BASE_WINDOW_SIZE][uECC_MAX_WORDS];
+    uECC_word_t *table, *entry;
+    wordcount_t num_words = curve->num_words;
+    bitcount_t windows = fixed_base_windows(curve);
+    bitcount_t i;
+    unsigned d;
+
+    table = (uECC_word_t *)malloc(((size_t)windows * uECC_FIXED_BASE_WINDOW_SIZE + 1) *
+                                  2 * num_words * sizeof(uECC_word_t));
+    if (!table) {
+        return 0;
+    }
+
+    entry = table;
+    for (i = 0; i < windows; ++i) {
+        /* Base of the window: 16^i * G. */
+        const uECC_word_t *base = i ? entry - 2 * num_words : curve->G;
+        const uECC_word_t *base_y = base + num_words;
+
+        for (d = 0; d < 2; ++d) {
+            uECC_vli_set(X[d], base, num_words);
+            uECC_vli_set(Y[d], base_y, num_words);
+            uECC_vli_clear(Z[d], num_words);
+            Z[d][0] = 1;
+        }
+        curve->double_jacobian(X[1], Y[1], Z[1], curve);
+
+        for (d = 2; d < uECC_FIXED_BASE_WINDOW_SIZE; ++d) {
+            uECC_vli_set(X[d], X[d - 1], num_words);
+            uECC_vli_set(Y[d], Y[d - 1], num_words);
+            uECC_vli_set(Z[d], Z[d - 1], num_words);
+            if (!EccPoint_add_mixed(X[d], Y[d], Z[d], base, base_y, curve)) {
+                free(table);
+                return 0;
+            }
+        }
+
+        EccPoint_normalize_batch(X, Y, Z, uECC_FIXED_BASE_WINDOW_SIZE, curve);
+
+        for (d = 0; d < uECC_FIXED_BASE_WINDOW_SIZE; ++d) {
+            uECC_vli_set(entry, X[d], num_words);
+            uECC_vli_set(entry + num_words, Y[d], num_words);
+            entry += 2 * num_words;
+        }
+    }
+
+    /* Last entry: -S * G, S = sum(16^i). */
+    uECC_vli_set(X[0], table, num_words);
+    uECC_vli_set(Y[0], table + num_words, num_words);
+    uECC_vli_clear(Z[0], num_words);
+    Z[0][0] = 1;
+    for (i = 1; i < windows; ++i) {
+        const uECC_word_t *base = table + (size_t)i * uECC_FIXED_BASE_WINDOW_SIZE * 2 * num_words;
+        if (!EccPoint_add_mixed(X[0], Y[0], Z[0], base, base + num_words, curve)) {
+            free(table);
+            return 0;
+        }
+    }
+    EccPoint_normalize_batch(X, Y, Z, 1, curve);
+
+    uECC_vli_set(entry, X[0], num_words);
+    uECC_vli_sub(entry + num_words, curve->p, Y[0], num_words);
+    return table;
+}
+
+static const uECC_word_t *fixed_base_table(uECC_Curve curve) {
+    uECC_word_t **slot;
+    uECC_word_t *table;
+
+    if (!g_fixed_base_enabled) {
+        return 0;
+    }
+
+    slot = fixed_base_slot(curve);
+    if (!slot) {
+        return 0;
+    }
+
+    table = fixed_base_load(slot);
+    if (table) {
+        return table;
+    }
+
+    table = build_fixed_base_table(curve);
+    if (!table) {
+        return 0;
+    }
+
+    if (!fixed_base_publish(slot, table)) {
+        free(table);
+        table = fixed_base_load(slot);
+    }
+    return table;
+}
+
+/* Selects entry 'digit' of a window in constant time. */
+static void fixed_base_select(uECC_word_t *point,
+                              const uECC_word_t *window,
+                              uECC_word_t digit,
+                              wordcount_t num_words) {
+    wordcount_t i;
+    uECC_word_t d;
+
+    uECC_vli_clear(point, num_words * 2);
+    for (d = 0; d < uECC_FIXED_BASE_WINDOW_SIZE; ++d) {
+        uECC_word_t mask = (uECC_word_t)0 - (uECC_word_t)(d == digit);
+        for (i = 0; i < num_words * 2; ++i) {
+            point[i] |= window[i] & mask;
+        }
+        window += num_words * 2;
+    }
+}
+
+/* Computes scalar * G in Jacobian coordinates.
+   Returns 0 if an intermediate sum hits a table entry (negligible probability), then the ladder should be used. */
+static uECC_word_t EccPoint_mult_fixed_base(uECC_word_t * X,
+                                            uECC_word_t * Y,
+                                            uECC_word_t * Z,
+                                            const uECC_word_t * scalar,
+                                            const uECC_word_t * table,
+                                            uECC_Curve curve) {
+    uECC_word_t point[uECC_MAX_WORDS * 2];
+    wordcount_t num_words = curve->num_words;
+    bitcount_t windows = fixed_base_windows(curve);
+    size_t window_words = (size_t)uECC_FIXED_BASE_WINDOW_SIZE * 2 * num_words;
+    const uECC_word_t *negative_offset = table + windows * window_words;
+    bitcount_t i;
+
+    for (i = 0; i < windows; ++i) {
+        bitcount_t bit = i * uECC_FIXED_BASE_WINDOW_BITS;
+        uECC_word_t digit = (scalar[bit >> uECC_WORD_BITS_SHIFT] >> (bit & uECC_WORD_BITS_MASK)) &
+                            (uECC_FIXED_BASE_WINDOW_SIZE - 1);
+
+        fixed_base_select(point, table + i * window_words, digit, num_words);
+        if (i == 0) {
+            uECC_vli_set(X, point, num_words);
+            uECC_vli_set(Y, point + num_words, num_words);
+            uECC_vli_clear(Z, num_words);
+            Z[0] = 1;
+        } else if (!EccPoint_add_mixed(X, Y, Z, point, point + num_words, curve)) {
+            return 0;
+        }
+    }
+
+    return EccPoint_add_mixed(X, Y, Z, negative_offset, negative_offset + num_words, curve);
+}
+
+int uECC_precompute_fixed_base(uECC_Curve curve) {
+    return fixed_base_table(curve) != 0;
+}
+
+void uECC_enable_fixed_base(int enable) {
+    g_fixed_base_enabled = enable;
+}
+
+#endif /* uECC_FIXED_BASE_TABLE */
+
 static uECC_word_t EccPoint_compute_public_key(uECC_word_t *result,
                                                uECC_word_t *private_key,
                                                uECC_Curve curve) {
@@ -920,6 +1220,22 @@ static uECC_word_t EccPoint_compute_public_key(uECC_word_t *result,
     uECC_word_t *p2[2] = {tmp1, tmp2};
     uECC_word_t carry;
 
+#if uECC_FIXED_BASE_TABLE
+    const uECC_word_t *table = fixed_base_table(curve);
+    if (table) {
+        uECC_word_t X[1][uECC_MAX_WORDS];
+        uECC_word_t Y[1][uECC_MAX_WORDS];
+        uECC_word_t Z[1][uECC_MAX_WORDS];
+
+        if (EccPoint_mult_fixed_base(X[0], Y[0], Z[0], private_key, table, curve)) {
+            EccPoint_normalize_batch(X, Y, Z, 1, curve);
+            uECC_vli_set(result, X[0], curve->num_words);
+            uECC_vli_set(result + curve->num_words, Y[0], curve->num_words);
+            return 1;
+        }
+    }
+#endif
+
     /* Regularize the bitcount for the private key so that attackers cannot use a side channel
        attack to learn the number of leading zeros. */
     carry = regularize_k(private_key, tmp1, tmp2, curve);
@@ -1031,6 +1347,70 @@ int uECC_make_key(uint8_t *public_key,
     return 0;
 }
 
+int uECC_make_keys(uint8_t *public_keys,
+                   uint8_t *private_keys,
+                   unsigned count,
+                   uECC_Curve curve) {
+#if uECC_FIXED_BASE_TABLE
+    uECC_word_t _private[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t X[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t Y[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t Z[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    const uECC_word_t *table = fixed_base_table(curve);
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+    int private_key_size = BITS_TO_BYTES(curve->num_n_bits);
+    int public_key_size = curve->num_bytes * 2;
+    unsigned batch, i;
+    uECC_word_t tries;
+
+    while (table && count > 0) {
+        batch = count < uECC_BATCH_SIZE ? count : uECC_BATCH_SIZE;
+
+        for (i = 0; i < batch; ++i) {
+            for (tries = 0; tries < uECC_RNG_MAX_TRIES; ++tries) {
+                if (!uECC_generate_random_int(_private[i], curve->n, num_n_words)) {
+                    return 0;
+                }
+                if (EccPoint_mult_fixed_base(X[i], Y[i], Z[i], _private[i], table, curve)) {
+                    break;
+                }
+            }
+            if (tries == uECC_RNG_MAX_TRIES) {
+                return 0;
+            }
+        }
+
+        /* The affine conversions of the batch share one modular inversion. */
+        EccPoint_normalize_batch(X, Y, Z, batch, curve);
+
+        for (i = 0; i < batch; ++i) {
+#if uECC_VLI_NATIVE_LITTLE_ENDIAN
+            bcopy(private_keys, (uint8_t *)_private[i], private_key_size);
+            bcopy(public_keys, (uint8_t *)X[i], curve->num_bytes);
+            bcopy(public_keys + curve->num_bytes, (uint8_t *)Y[i], curve->num_bytes);
+#else
+            uECC_vli_nativeToBytes(private_keys, private_key_size, _private[i]);
+            uECC_vli_nativeToBytes(public_keys, curve->num_bytes, X[i]);
+            uECC_vli_nativeToBytes(public_keys + curve->num_bytes, curve->num_bytes, Y[i]);
+#endif
+            private_keys += private_key_size;
+            public_keys += public_key_size;
+        }
+        count -= batch;
+    }
+#endif
+
+    while (count > 0) {
+        if (!uECC_make_key(public_keys, private_keys, curve)) {
+            return 0;
+        }
+        private_keys += uECC_curve_private_key_size(curve);
+        public_keys += uECC_curve_public_key_size(curve);
+        count -= 1;
+    }
+    return 1;
+}
+
 int uECC_shared_secret(const uint8_t *public_key,
                        const uint8_t *private_key,
                        uint8_t *secret,
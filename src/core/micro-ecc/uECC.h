@@ -49,6 +49,14 @@ to be word aligned on architectures that do not support unaligned accesses. */
     #define uECC_VLI_NATIVE_LITTLE_ENDIAN 0
 #endif
 
+/* uECC_FIXED_BASE_TABLE - If enabled (defined as nonzero), public keys are computed with a per-curve
+table of precomputed multiples of the curve generator (4-bit windows), instead of the Montgomery ladder.
+A table is built on the first use of its curve, and is kept until the process exits. It takes about
+64 KB for secp256r1 / secp256k1 with 64-bit words. */
+#ifndef uECC_FIXED_BASE_TABLE
+    #define uECC_FIXED_BASE_TABLE 1
+#endif
+
 /* Curve support selection. Set to 0 to remove that curve. */
 #ifndef uECC_SUPPORTS_secp160r1
     #define uECC_SUPPORTS_secp160r1 1
@@ -162,6 +170,31 @@ Returns 1 if the key pair was generated successfully, 0 if an error occurred.
 */
 int uECC_make_key(uint8_t *public_key, uint8_t *private_key, uECC_Curve curve);
 
+/* uECC_make_keys() function.
+Create count public/private key pairs. The key pairs are stored one after another, with the sizes
+of uECC_curve_public_key_size() and uECC_curve_private_key_size().
+With fixed-base tables, the coordinate conversions of every 16 key pairs share one modular inversion.
+
+Returns 1 if all key pairs were generated successfully, 0 if an error occurred.
+*/
+int uECC_make_keys(uint8_t *public_keys, uint8_t *private_keys, unsigned count, uECC_Curve curve);
+
+#if uECC_FIXED_BASE_TABLE
+/* uECC_precompute_fixed_base() function.
+Build the fixed-base table of the curve, if it isn't built. Tables are also built on first use.
+Without GCC/Clang atomics, this must be called before the curve is used in multiple threads.
+
+Returns 1 if the table is ready, 0 if the table couldn't be built (the Montgomery ladder is used).
+*/
+int uECC_precompute_fixed_base(uECC_Curve curve);
+
+/* uECC_enable_fixed_base() function.
+Switch between fixed-base tables (enabled by default) and the Montgomery ladder, for benchmarking
+and verification.
+*/
+void uECC_enable_fixed_base(int enable);
+#endif
+
 /* uECC_shared_secret() function.
 Compute a shared secret given your secret key and someone else's public key.
 Note: It is recommended that you hash the result of uECC_shared_secret() before using it for
@@ -2,6 +2,8 @@
 #define FPNN_C_PLUS_PLUS_SDK_H
 
 #include "core/TCPClient.h"
+#include "core/TCPClientPool.h"
+#include "core/MultiEndpointClient.h"
 #include "core/UDPClient.h"
 
 #endif
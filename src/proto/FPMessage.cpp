@@ -55,9 +55,9 @@ bool FPMessage::isQuest(const char* header){
 }
 
 std::string FPMessage::Hex(){
-	char* hexstr = (char*)malloc(_payload.size() * 2 + 1); 
+	char* hexstr = (char*)malloc(payloadLength() * 2 + 1); 
 	if(!hexstr) return "";
-	Hexlify(hexstr, _payload.c_str(), _payload.size());
+	Hexlify(hexstr, payloadData(), payloadLength());
 	std::string result = std::string(hexstr);
 	free(hexstr);
 	return result;
@@ -74,7 +74,7 @@ std::string FPMessage::Hex(const std::string& str){
 
 std::string FPMessage::json(){
 	try{
-		return JSONConvert::Msgpack2Json(_payload);
+		return JSONConvert::Msgpack2Json(payloadData(), payloadLength());
 	}
 	catch(const std::exception& ex){
 		LOG_ERROR("EXCEPTION:%s", ex.what());
@@ -125,7 +125,7 @@ void FPQuest::_create(const Header& hdr, uint32_t seq, const std::string& method
 	setPayloadSize(this->payload().size());
 }
 
-void FPQuest::_create(const char* data, size_t len){
+void FPQuest::_create(const char* data, size_t len, const FPFrameBufferPtr& frame){
 	size_t olen = len;
 	if(len < sizeof(_hdr)) 
 		throw FPNN_ERROR_CODE_FMT(FpnnProtoError, FPNN_EC_PROTO_INVALID_PACKAGE, "hdr len:%d, but intput len:%d", sizeof(_hdr), len);
@@ -166,15 +166,15 @@ void FPQuest::_create(const char* data, size_t len){
 	if(len <= 0){
 		LOG_ERROR("Invalid Package: %s", Hex(std::string(data, olen)).c_str());
 	}
-	std::string payload = std::string(p, len);
 
 	if(isMsgPack()){
-		setPayload(payload);
+		if(frame) setPayload(frame, p, len);
+		else setPayload(p, len);
 	}
 	else{
-		setPayload(JSONConvert::Json2Msgpack(payload));
+		setPayload(JSONConvert::Json2Msgpack(std::string(p, len)));
 	}
-	setPayloadSize(this->payload().size());
+	setPayloadSize(payloadLength());
 }
 
 void FPQuest::_create(const std::string& method, const std::string& payload, StringMap& infos, bool post){
@@ -194,27 +194,32 @@ void FPQuest::_create(const std::string& method, const std::string& payload, Str
 }
 
 std::string* FPQuest::raw(){
-	msgpack::sbuffer ss(FPNN_MSGPACK_SBUFFER_INIT_SIZE);
-	std::string pl = payload();
-
-	size_t oplSize = pl.size();
-	if(isJson()) pl = JSONConvert::Msgpack2Json(pl);
-	setPayloadSize(pl.size());
-	ss.write((const char*)&_hdr, sizeof(_hdr));
-	setPayloadSize(oplSize);//for next call of raw
-	
-	if(isTwoWay()){
-		uint32_t seqnum = seqNumLE();
-		ss.write((const char*)&seqnum, sizeof(uint32_t));
-	}
-	else if(!isQuest()) 
+	if(!isQuest()) 
 		throw FPNN_ERROR_CODE_FMT(FpnnProtoError, FPNN_EC_PROTO_NOT_SUPPORTED, "get RAW data of Quest, but it not a quest package");
 
-	ss.write((const char*)method().data(), method().size());
+	std::string pl;
+	const char* data = payloadData();
+	size_t len = payloadLength();
+	if(isJson()){
+		pl = JSONConvert::Msgpack2Json(data, len);
+		data = pl.data();
+		len = pl.size();
+	}
 
-	ss.write((const char*)pl.data(), pl.size());
+	Header hdr = _hdr;
+	hdr.psize = htole32((uint32_t)len);
+	uint32_t seqnum = seqNumLE();
+	size_t prefixLen = rawPrefixLength();
 
-	return new std::string(ss.data(),ss.size());
+	std::string* raw = new std::string();
+	raw->reserve(prefixLen + len);
+	raw->append((const char*)&hdr, sizeof(hdr));
+	if(isTwoWay())
+		raw->append((const char*)&seqnum, sizeof(uint32_t));
+	raw->append(_method);
+	raw->append(data, len);
+
+	return raw;
 }
 
 std::string FPQuest::info(){
@@ -278,7 +283,7 @@ void FPAnswer::_create(const Header& hdr, uint32_t seq, const std::string& paylo
 	setPayloadSize(this->payload().size());
 }
 
-void FPAnswer::_create(const char* data, size_t len){
+void FPAnswer::_create(const char* data, size_t len, const FPFrameBufferPtr& frame){
 	//if(!_quest) throw FPNN_ERROR_MSG(FpnnProtoError, "Create answer, But quest is NULL");
 	//if(!_quest->isTwoWay()) FPNN_ERROR_MSG(FpnnProtoError, "Create answer for oneway Message");
 	size_t olen = len;
@@ -308,15 +313,14 @@ void FPAnswer::_create(const char* data, size_t len){
 	if(len != payloadSize()) 
 		throw FPNN_ERROR_CODE_FMT(FpnnProtoError, FPNN_EC_PROTO_INVALID_PACKAGE, "Len is too small:%d", len);
 
-	std::string payload = std::string(p, len);
-
 	if(isMsgPack()){
-		setPayload(payload);
+		if(frame) setPayload(frame, p, len);
+		else setPayload(p, len);
 	}
 	else{
-		setPayload(JSONConvert::Json2Msgpack(payload));
+		setPayload(JSONConvert::Json2Msgpack(std::string(p, len)));
 	}
-	setPayloadSize(this->payload().size());
+	setPayloadSize(payloadLength());
 }
 
 std::string* FPAnswer::raw(){
@@ -325,27 +329,32 @@ std::string* FPAnswer::raw(){
 }
 
 std::string* FPAnswer::rawTCP(){
-	msgpack::sbuffer ss(FPNN_MSGPACK_SBUFFER_INIT_SIZE);
-	std::string pl = payload();
-
-	size_t oplSize = pl.size();
-	if(isJson()) pl = JSONConvert::Msgpack2Json(pl);
-	setPayloadSize(pl.size());
-	ss.write((const char*)&_hdr, sizeof(_hdr));
-	setPayloadSize(oplSize);//for next call of raw
+	std::string pl;
+	const char* data = payloadData();
+	size_t len = payloadLength();
+	if(isJson()){
+		pl = JSONConvert::Msgpack2Json(data, len);
+		data = pl.data();
+		len = pl.size();
+	}
 
+	Header hdr = _hdr;
+	hdr.psize = htole32((uint32_t)len);
 	uint32_t seqnum = seqNumLE();
-	ss.write((const char*)&seqnum, sizeof(uint32_t));
+	size_t prefixLen = rawPrefixLength();
 
-	ss.write((const char*)pl.data(), pl.size());
+	std::string* raw = new std::string();
+	raw->reserve(prefixLen + len);
+	raw->append((const char*)&hdr, sizeof(hdr));
+	raw->append((const char*)&seqnum, sizeof(uint32_t));
+	raw->append(data, len);
 
-	return new std::string(ss.data(),ss.size());
+	return raw;
 }
 
 std::string* FPAnswer::rawHTTP(){
 	msgpack::sbuffer ss(FPNN_MSGPACK_SBUFFER_INIT_SIZE);
-	std::string pl = payload();
-	pl = JSONConvert::Msgpack2Json(pl);
+	std::string pl = JSONConvert::Msgpack2Json(payloadData(), payloadLength());
 
 	size_t len = pl.size();
 
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <atomic>
+#include <mutex>
 #include <msgpack.hpp>
 #include "Endian.h"
 #include "FpnnError.h"
@@ -27,6 +28,9 @@ namespace fpnn{
 	typedef std::shared_ptr<FPQuest> FPQuestPtr;
 	typedef std::shared_ptr<FPAnswer> FPAnswerPtr;
 
+	//-- Refcounted received frame buffer. Zero-copy decoded messages reference their payload in it.
+	typedef std::shared_ptr<char> FPFrameBufferPtr;
+
 	typedef msgpack::object OBJECT;
 	typedef std::map<std::string, std::string> StringMap;
 
@@ -102,10 +106,33 @@ namespace fpnn{
 			void setPayloadSize(uint32_t size)	{ _hdr.psize = htole32(size); }
 			void setSeqNum(uint32_t seqNum)		{ _seqNum = htole32(seqNum); }
 
-			void setPayload(const std::string& payload)			{ _payload = payload; }
-			void setPayload(const char* payload, size_t len)	{ _payload = std::string(payload,len); }
+			void setPayload(const std::string& payload)			{ _payload = payload; clearPayloadSlice(); }
+			void setPayload(const char* payload, size_t len)	{ _payload.assign(payload, len); clearPayloadSlice(); }
+
+			/*
+				Referenced payload: the payload is a slice of a refcounted frame buffer, such as zero-copy decoded messages
+				and the messages taken from FPQWriter & FPAWriter. payload must be in frame. The frame is read only.
+			*/
+			void setPayload(const FPFrameBufferPtr& frame, const char* payload, size_t len){
+				_frameBuffer = frame;
+				_payloadSlice = payload;
+				_payloadSliceLen = len;
+			}
+
+			/*
+				For referenced payload, payload() will copy the payload from the frame buffer at the first calling.
+				Using payloadData() & payloadLength() to access payload without copying.
+			*/
+			const std::string& payload() const
+			{
+				if (_payloadSlice)
+					std::call_once(_payloadCopied, [this](){ _payload.assign(_payloadSlice, _payloadSliceLen); });
 
-			const std::string& payload() const					{ return _payload; }
+				return _payload;
+			}
+			const char* payloadData() const						{ return _payloadSlice ? _payloadSlice : _payload.data(); }
+			size_t payloadLength() const						{ return _payloadSlice ? _payloadSliceLen : _payload.size(); }
+			bool isPayloadReferenced() const					{ return _payloadSlice != NULL; }
 			//get payload json string
 			std::string json();
 			std::string Hex();
@@ -233,13 +260,26 @@ namespace fpnn{
 
 			Header _hdr;
 		protected:
-			FPMessage():_ctime(0), _seqNum(0), _httpInfos(NULL) {}
+			FPMessage():_ctime(0), _seqNum(0), _payloadSlice(NULL), _payloadSliceLen(0), _httpInfos(NULL) {}
 			virtual ~FPMessage() { if(_httpInfos) delete _httpInfos; }
 
+			void clearPayloadSlice(){
+				if(_payloadSlice){
+					_frameBuffer.reset();
+					_payloadSlice = NULL;
+					_payloadSliceLen = 0;
+				}
+			}
+
 		protected:
 			int64_t _ctime;
 			uint32_t _seqNum;
-			std::string _payload;
+			mutable std::string _payload;
+			//-- Zero-copy decoding: payload references the received frame buffer.
+			FPFrameBufferPtr _frameBuffer;
+			const char* _payloadSlice;
+			size_t _payloadSliceLen;
+			mutable std::once_flag _payloadCopied;
 			//for HTTP, cookie, header, uri
 			//key will be add c_, h_, u_
 			StringMap* _httpInfos;
@@ -270,7 +310,12 @@ namespace fpnn{
 			}
 			FPQuest(const char* data, size_t len){
 				_ctime = slack_real_msec();
-				_create(data, len);
+				_create(data, len, nullptr);
+			}
+			//create from raw data without copying payload, data MUST be in frame.
+			FPQuest(const FPFrameBufferPtr& frame, const char* data, size_t len){
+				_ctime = slack_real_msec();
+				_create(data, len, frame);
 			}
 			//create HTTP, only support json
 			FPQuest(const std::string& method, const std::string& payload, StringMap& infos, bool post){
@@ -298,10 +343,13 @@ namespace fpnn{
 			std::string* raw();
 			std::string info();
 
+			//-- Length of header, seqNum & method in the raw data.
+			size_t rawPrefixLength() const		{ return sizeof(Header) + (isTwoWay() ? sizeof(uint32_t) : 0) + _method.size(); }
+
 		private:
 			void _create(const std::string& method, bool oneway = false, FP_Pack_Type ptype = FP_PACK_MSGPACK);
 			void _create(const Header& hdr, uint32_t seq, const std::string& method, const std::string& payload);
-			void _create(const char* data, size_t len);
+			void _create(const char* data, size_t len, const FPFrameBufferPtr& frame);
 			void _create(const std::string& method, const std::string& payload, StringMap& infos, bool post);
 		private:
 			std::string _method;
@@ -338,7 +386,13 @@ namespace fpnn{
 			FPAnswer(const char* data, size_t len)
 				: _quest(NULL){
 					_ctime = slack_real_msec();
-					_create(data, len);
+					_create(data, len, nullptr);
+				}
+			//create from raw data without copying payload, data MUST be in frame.
+			FPAnswer(const FPFrameBufferPtr& frame, const char* data, size_t len)
+				: _quest(NULL){
+					_ctime = slack_real_msec();
+					_create(data, len, frame);
 				}
 			FPAnswer(const std::string& data)
 				: _quest(NULL){ 
@@ -352,6 +406,9 @@ namespace fpnn{
 
 			std::string* raw();
 
+			//-- Length of header & seqNum in the raw data of TCP answer.
+			static size_t rawPrefixLength()	{ return sizeof(Header) + sizeof(uint32_t); }
+
 			int64_t timeCost();
 
 			std::string info();
@@ -362,9 +419,9 @@ namespace fpnn{
 		private:
 			void _create();
 			void _create(const Header& hdr, uint32_t seq, const std::string& payload);
-			void _create(const char* data, size_t len);
+			void _create(const char* data, size_t len, const FPFrameBufferPtr& frame);
 			void _create(const std::string& data){
-				_create(data.data(), data.size());
+				_create(data.data(), data.size(), nullptr);
 			}
 		private:
 			uint16_t _status;
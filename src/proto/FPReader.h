@@ -230,6 +230,14 @@ namespace fpnn{
 					throw FPNN_ERROR_CODE_FMT(FpnnProtoError, FPNN_EC_PROTO_MAP_VALUE, "NOT a MAP object: %s", json().c_str());
 			}
 			virtual ~FPReader() {}
+		protected:
+			/*
+				If referenceBuffer is true, STR, BIN & EXT objects will reference buf directly without copying,
+				caller MUST keep buf alive until the reader destroyed.
+			*/
+			FPReader(const char* buf, size_t len, bool referenceBuffer){
+				unpack(buf, len, referenceBuffer);
+			}
 		public:
 			std::string raw(){
 				throw FPNN_ERROR_CODE_MSG(FpnnProtoError, FPNN_EC_PROTO_NOT_SUPPORTED, "should not call raw");
@@ -247,9 +255,13 @@ namespace fpnn{
 				return "";
 			}
 		private:
-			void unpack(const char* buf, size_t len){
+			static bool referenceAll(msgpack::type::object_type, std::size_t, void*){
+				return true;
+			}
+
+			void unpack(const char* buf, size_t len, bool referenceBuffer = false){
 				try{
-					_oh = msgpack::unpack(buf, len);
+					_oh = msgpack::unpack(buf, len, referenceBuffer ? referenceAll : NULL);
 					_object = _oh.get();
 				}   
 				catch(const std::exception& ex){
@@ -289,7 +301,7 @@ namespace fpnn{
 	class FPQReader : public FPReader{
 		public:
 			FPQReader(const FPQuestPtr& quest)
-				: FPReader(quest->payload()), _quest(quest){
+				: FPReader(quest->payloadData(), quest->payloadLength(), true), _quest(quest){
 				}   
 
 			bool isHTTP()						{ return _quest->isHTTP(); }
@@ -307,7 +319,7 @@ namespace fpnn{
 	class FPAReader : public FPReader{
 		public:
 			FPAReader(const FPAnswerPtr& answer)
-				: FPReader(answer->payload()), _answer(answer){
+				: FPReader(answer->payloadData(), answer->payloadLength(), true), _answer(answer){
 				}   
 
 			uint32_t seqNum() const				{ return _answer->seqNum(); }
@@ -54,6 +54,8 @@ void FPWriter::paramFile(const char *k, const char *file){
 
 std::string FPWriter::json(){
 	try{
+		if (_takenFrame)
+			return JSONConvert::Msgpack2Json(_takenFrame.get(), _takenLength);
 		return JSONConvert::Msgpack2Json(_sbuf.data(), _sbuf.size());
 	}
 	catch(const std::exception& ex){
@@ -65,11 +67,19 @@ std::string FPWriter::json(){
 	return "";
 }
 
+FPFrameBufferPtr FPWriter::takeBuffer(size_t& len){
+	if (!_takenFrame){
+		_takenLength = _sbuf.size();
+		_takenFrame.reset(_sbuf.release(), free);
+	}
+	len = _takenLength;
+	return _takenFrame;
+}
+
 FPQuestPtr FPQWriter::CloneQuest(const char* method, const FPQuestPtr quest){
 	FPQuestPtr q(new FPQuest(method, quest->isOneWay(), quest->isMsgPack() ? FPMessage::FP_PACK_MSGPACK : FPMessage::FP_PACK_JSON));
-	std::string payload = quest->payload();
-	q->setPayload(payload);
-	q->setPayloadSize(payload.size());
+	q->setPayload(quest->payloadData(), quest->payloadLength());
+	q->setPayloadSize(quest->payloadLength());
 	q->setCTime(slack_real_msec());
 	return q;
 }
@@ -79,9 +89,10 @@ FPQuestPtr FPQWriter::CloneQuest(const std::string& method, const FPQuestPtr que
 }
 
 FPQuestPtr FPQWriter::take(){
-	std::string payload = raw();
-	_quest->setPayload(payload);
-	_quest->setPayloadSize(payload.size());
+	size_t len;
+	FPFrameBufferPtr frame = takeBuffer(len);
+	_quest->setPayload(frame, frame.get(), len);
+	_quest->setPayloadSize(len);
 	_quest->setCTime(slack_real_msec());
 
 	FPQuestPtr q;
@@ -103,9 +114,8 @@ FPAnswerPtr FPAWriter::CloneAnswer(const FPAnswerPtr answer, const FPQuestPtr qu
 	if(!answer) return FpnnErrorAnswer(quest, FPNN_EC_CORE_SEND_ERROR, "unknown clone error.");
 	FPAnswerPtr an(new FPAnswer(quest));
 	an->setSS(answer->status());
-	std::string payload = answer->payload();
-	an->setPayload(payload);
-	an->setPayloadSize(payload.size());
+	an->setPayload(answer->payloadData(), answer->payloadLength());
+	an->setPayloadSize(answer->payloadLength());
 	an->setCTime(slack_real_msec());
 	return an;
 }
@@ -120,9 +130,10 @@ FPAnswerPtr FPAWriter::CloneAnswer(const std::string& payload, const FPQuestPtr
 }
 
 FPAnswerPtr FPAWriter::take(){
-	std::string payload = raw();
-	_answer->setPayload(payload);
-	_answer->setPayloadSize(payload.size());
+	size_t len;
+	FPFrameBufferPtr frame = takeBuffer(len);
+	_answer->setPayload(frame, frame.get(), len);
+	_answer->setPayloadSize(len);
 	_answer->setCTime(slack_real_msec());
 
 	FPAnswerPtr a;
@@ -90,27 +90,38 @@ class FPWriter{
 
 		virtual ~FPWriter() {}
 
-		FPWriter(uint32_t size):_sbuf(FPNN_MSGPACK_SBUFFER_INIT_SIZE), _pack(&_sbuf){
+		FPWriter(uint32_t size):_sbuf(FPNN_MSGPACK_SBUFFER_INIT_SIZE), _pack(&_sbuf), _takenLength(0){
 			_pack.pack_map(size);
 		}
 		//only support pack a map
-		FPWriter():_sbuf(FPNN_MSGPACK_SBUFFER_INIT_SIZE), _pack(&_sbuf){
+		FPWriter():_sbuf(FPNN_MSGPACK_SBUFFER_INIT_SIZE), _pack(&_sbuf), _takenLength(0){
 		}
 
 		//only support pack raw JSON
-		FPWriter(const std::string& json):_sbuf(FPNN_MSGPACK_SBUFFER_INIT_SIZE), _pack(&_sbuf){
+		FPWriter(const std::string& json):_sbuf(FPNN_MSGPACK_SBUFFER_INIT_SIZE), _pack(&_sbuf), _takenLength(0){
 			std::string msgpack = JSONConvert::Json2Msgpack(json);
 			_sbuf.write((const char*)msgpack.data(), msgpack.size());
 		}
-		FPWriter(const char* json):_sbuf(FPNN_MSGPACK_SBUFFER_INIT_SIZE), _pack(&_sbuf){
+		FPWriter(const char* json):_sbuf(FPNN_MSGPACK_SBUFFER_INIT_SIZE), _pack(&_sbuf), _takenLength(0){
 			std::string msgpack = JSONConvert::Json2Msgpack(json);
 			_sbuf.write((const char*)msgpack.data(), msgpack.size());
 		}
 	public:
+		//-- After take(), returns the payload taken by the quest/answer.
 		std::string raw(){
+			if (_takenFrame)
+				return std::string(_takenFrame.get(), _takenLength);
 			return std::string(_sbuf.data(), _sbuf.size());
 		}
 		std::string json();
+
+	protected:
+		/*
+			The quest/answer takes the whole buffer without copying. The writer keeps a reference of the taken buffer,
+			so raw() & json() still work after take(). Params packed after take() are not included in the taken payload.
+		*/
+		FPFrameBufferPtr takeBuffer(size_t& len);
+
 	private:
 		std::string fmtString(const char *fmt, va_list ap){
 			char v[FPNN_MAX_FMT_LEN+1] = {0};
@@ -121,6 +132,8 @@ class FPWriter{
 	private:
 		msgpack::sbuffer _sbuf;
 		msgpack::packer<msgpack::sbuffer> _pack;
+		FPFrameBufferPtr _takenFrame;
+		size_t _takenLength;
 };
 
 
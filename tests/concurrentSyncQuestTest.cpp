@@ -0,0 +1,160 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include "FPWriter.h"
+#include "TimeUtil.h"
+#include "TCPClient.h"
+#include "UDPClient.h"
+#include "CommandLineUtil.h"
+#include "testUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Many threads call the synchronous sendQuest() of one client at the same time.
+		*. Every sync call gets its answer. The answers of other threads never wake up the wrong waiter.
+		*. Sync calls timed out at the time the answers arriving return normally (timeout or answer),
+			the waiting callbacks are on the stacks of the calling threads.
+	Reports the time & QPS of the sync calls.
+	The quests use the "two way demo" & "custom delay" methods of the FPNN serverTest.
+*/
+
+static std::atomic<int> gAnswered(0);
+static std::atomic<int> gTimeout(0);
+static std::atomic<int> gFailed(0);
+
+static void resetCounters()
+{
+	gAnswered = 0;
+	gTimeout = 0;
+	gFailed = 0;
+}
+
+static void countAnswer(FPAnswerPtr answer)
+{
+	if (!answer)
+	{
+		gFailed++;
+		return;
+	}
+
+	if (answer->status() == 0)
+	{
+		gAnswered++;
+		return;
+	}
+
+	FPAReader ar(answer);
+	if (ar.getInt("code") == FPNN_EC_CORE_TIMEOUT)
+		gTimeout++;
+	else
+		gFailed++;
+}
+
+static void echoThread(ClientPtr client, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		try
+		{
+			countAnswer(client->sendQuest(demoQuest(i)));
+		}
+		catch (...)
+		{
+			gFailed++;
+		}
+	}
+}
+
+static void delayThread(ClientPtr client, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		try
+		{
+			countAnswer(client->sendQuestMsec(delayQuest(1), 1000));
+		}
+		catch (...)
+		{
+			gFailed++;
+		}
+	}
+}
+
+static int64_t runThreads(void (*func)(ClientPtr, int), ClientPtr client, int threadCount, int questCount)
+{
+	int64_t begin = TimeUtil::curr_usec();
+
+	std::vector<std::thread> threads;
+	for (int i = 0 ; i < threadCount; i++)
+		threads.push_back(std::thread(func, client, questCount));
+
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	return TimeUtil::curr_usec() - begin;
+}
+
+static void testEcho(ClientPtr client, int threadCount, int questCount)
+{
+	resetCounters();
+	int64_t cost = runThreads(echoThread, client, threadCount, questCount);
+
+	int total = threadCount * questCount;
+	check(gAnswered == total && gTimeout == 0 && gFailed == 0,
+		std::to_string(threadCount) + " threads x " + std::to_string(questCount) + " sync quests: "
+		+ std::to_string(gAnswered) + " of " + std::to_string(total) + " answered");
+
+	cout<<"\tcost "<<(cost / 1000.0)<<" ms, QPS "<<(int64_t)(total * 1000000.0 / (cost ? cost : 1))<<endl;
+}
+
+static void testTimeoutRace(ClientPtr client, int threadCount, int questCount)
+{
+	resetCounters();
+	runThreads(delayThread, client, threadCount, questCount);
+
+	int total = threadCount * questCount;
+	check(gAnswered + gTimeout == total && gFailed == 0,
+		"sync quests racing with timeout: " + std::to_string(gAnswered) + " answered, "
+		+ std::to_string(gTimeout) + " timed out, " + std::to_string(gFailed) + " failed");
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+	std::vector<std::string> mainParams = CommandLineParser::getRestParams();
+
+	if (mainParams.size() != 2)
+	{
+		cout<<"Usage: "<<argv[0]<<" ip port [-udp] [-t threads] [-n quests_per_thread]"<<endl;
+		return 0;
+	}
+
+	int threadCount = CommandLineParser::getInt("t", 200);
+	int questCount = CommandLineParser::getInt("n", 500);
+	if (threadCount <= 0)
+		threadCount = 200;
+	if (questCount <= 0)
+		questCount = 500;
+
+	ClientPtr client;
+	if (CommandLineParser::exist("udp"))
+		client = Client::createUDPClient(mainParams[0], atoi(mainParams[1].c_str()));
+	else
+		client = Client::createTCPClient(mainParams[0], atoi(mainParams[1].c_str()));
+
+	if (!client->connect())
+	{
+		cout<<"Connect "<<mainParams[0]<<":"<<mainParams[1]<<" failed."<<endl;
+		return 1;
+	}
+
+	testEcho(client, threadCount, questCount);
+	testTimeoutRace(client, threadCount, 3);
+
+	client->close();
+
+	return checkSummary();
+}
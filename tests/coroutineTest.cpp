@@ -0,0 +1,146 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <memory>
+#include <coroutine>
+#include "FPWriter.h"
+#include "TCPClient.h"
+#include "ClientCoroutine.h"
+#include "CommandLineUtil.h"
+#include "testUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Tests the C++20 coroutine interfaces in ClientCoroutine.h (built only when the compiler supports C++20 coroutines):
+		*. Answered quests resume the coroutine in each resume mode: callback pool, IO thread & scheduler.
+		*. Timed out quests resume the coroutine with FPNN_EC_CORE_TIMEOUT.
+		*. One way quests, and quests failed to send, return without suspending.
+	The quests use the "two way demo", "one way demo" & "custom delay" methods of the FPNN serverTest.
+*/
+
+//-- A minimal fire-and-forget coroutine type. The caller waits the future for the end of the coroutine.
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object() { return DetachedTask(); }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+struct QuestOutcome
+{
+	QuestResult result;
+	std::thread::id resumedThread;
+};
+typedef std::shared_ptr<std::promise<QuestOutcome>> OutcomePromisePtr;
+
+//-- The promise is shared with the coroutine frame, the coroutine may still be finishing when the caller got the outcome.
+static DetachedTask awaitQuest(ClientPtr client, FPQuestPtr quest, int timeout, CoroutineResumeMode mode, OutcomePromisePtr done)
+{
+	QuestOutcome outcome;
+	outcome.result = co_await asyncSendQuest(client, quest, timeout, mode);
+	outcome.resumedThread = std::this_thread::get_id();
+	done->set_value(std::move(outcome));
+}
+
+static DetachedTask awaitQuestByScheduler(ClientPtr client, FPQuestPtr quest, CoroutineScheduler scheduler, OutcomePromisePtr done)
+{
+	QuestOutcome outcome;
+	outcome.result = co_await asyncSendQuest(client, quest, 0, std::move(scheduler));
+	outcome.resumedThread = std::this_thread::get_id();
+	done->set_value(std::move(outcome));
+}
+
+static QuestOutcome runQuest(ClientPtr client, FPQuestPtr quest, int timeout = 0,
+	CoroutineResumeMode mode = CoroutineResumeMode::CallbackPool)
+{
+	OutcomePromisePtr done = std::make_shared<std::promise<QuestOutcome>>();
+	std::future<QuestOutcome> future = done->get_future();
+
+	awaitQuest(client, quest, timeout, mode, done);
+	return future.get();
+}
+
+static void testAnswer(ClientPtr client)
+{
+	QuestResult result = runQuest(client, demoQuest(1)).result;
+	check(result.errorCode == FPNN_EC_OK && result.answer && result.answer->status() == 0, "answered quest resumed in callback pool");
+
+	QuestOutcome outcome = runQuest(client, demoQuest(2), 0, CoroutineResumeMode::IOThread);
+	result = outcome.result;
+	check(result.errorCode == FPNN_EC_OK && result.answer && result.answer->status() == 0, "answered quest resumed in IO thread");
+	check(outcome.resumedThread != std::this_thread::get_id(), "coroutine is not resumed in the calling thread");
+
+	std::atomic<int> scheduled(0);
+	OutcomePromisePtr done = std::make_shared<std::promise<QuestOutcome>>();
+	std::future<QuestOutcome> future = done->get_future();
+
+	awaitQuestByScheduler(client, demoQuest(3), [&scheduled](std::coroutine_handle<> handle) {
+		scheduled++;
+		std::thread(handle).detach();
+	}, done);
+
+	result = future.get().result;
+	check(result.errorCode == FPNN_EC_OK && result.answer && result.answer->status() == 0, "answered quest resumed by scheduler");
+	check(scheduled == 1, "scheduler is called once");
+}
+
+static void testTimeout(ClientPtr client)
+{
+	QuestResult result = runQuest(client, delayQuest(2), 1).result;
+	check(result.errorCode == FPNN_EC_CORE_TIMEOUT, "timed out quest resumed with FPNN_EC_CORE_TIMEOUT");
+
+	result = runQuest(client, delayQuest(2), 1, CoroutineResumeMode::IOThread).result;
+	check(result.errorCode == FPNN_EC_CORE_TIMEOUT, "timed out quest resumed with FPNN_EC_CORE_TIMEOUT in IO thread mode");
+}
+
+static void testWithoutSuspending(ClientPtr client, const std::string& host)
+{
+	QuestOutcome outcome = runQuest(client, demoQuest(4, true));
+	check(outcome.result.errorCode == FPNN_EC_OK && !outcome.result.answer, "one way quest returned without answer");
+	check(outcome.resumedThread == std::this_thread::get_id(), "one way quest didn't suspend the coroutine");
+
+	//-- Without auto reconnect, sending on the unconnected client fails at once.
+	TCPClientPtr unconnected = TCPClient::createClient(host, 1, false);
+	outcome = runQuest(unconnected, demoQuest(5));
+	check(outcome.result.errorCode == FPNN_EC_CORE_SEND_ERROR, "quest failed to send returned FPNN_EC_CORE_SEND_ERROR");
+	check(outcome.resumedThread == std::this_thread::get_id(), "failed quest didn't suspend the coroutine");
+
+	outcome = runQuest(client, nullptr);
+	check(outcome.result.errorCode == FPNN_EC_CORE_SEND_ERROR, "null quest returned FPNN_EC_CORE_SEND_ERROR");
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+	std::vector<std::string> mainParams = CommandLineParser::getRestParams();
+
+	if (mainParams.size() != 2)
+	{
+		cout<<"Usage: "<<argv[0]<<" ip port"<<endl;
+		return 0;
+	}
+
+	TCPClientPtr client = TCPClient::createClient(mainParams[0], atoi(mainParams[1].c_str()));
+	if (!client->connect())
+	{
+		cout<<"Connect "<<mainParams[0]<<":"<<mainParams[1]<<" failed."<<endl;
+		return 1;
+	}
+
+	testAnswer(client);
+	testTimeout(client);
+	testWithoutSuspending(client, mainParams[0]);
+
+	client->close();
+
+	return checkSummary();
+}
@@ -0,0 +1,211 @@
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include "FPWriter.h"
+#include "TimeUtil.h"
+#include "DNSResolver.h"
+#include "TCPClient.h"
+#include "IQuestProcessor.h"
+#include "CommandLineUtil.h"
+#include "testUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Tests TCPClient created by host names, with a stub resolver installed by DNSResolver::setResolveFunction():
+		*. Lookup failure: connecting failed, connecting failed event is triggered once, and the failure is cached.
+		*. Cache hit: concurrent lookups are merged, later connecting uses the cache.
+		*. TTL expiry: the expired host name is resolved again.
+	The host names ending with ".ok.test" are resolved to the given ip, others are failed.
+	The quests use the "two way demo" method of the FPNN serverTest.
+*/
+
+class StubResolver
+{
+	std::mutex _mutex;
+	std::unordered_map<std::string, int> _lookups;
+	std::string _IPAddress;
+
+public:
+	explicit StubResolver(const std::string& IPAddress): _IPAddress(IPAddress) {}
+
+	bool resolve(const std::string& hostname, std::string& IPAddress, EndPointType& eType)
+	{
+		{
+			std::unique_lock<std::mutex> lck(_mutex);
+			_lookups[hostname] += 1;
+		}
+
+		//-- Keep the lookup pending for a while, so concurrent lookups can be merged.
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		const std::string suffix(".ok.test");
+		if (hostname.size() < suffix.size() || hostname.compare(hostname.size() - suffix.size(), suffix.size(), suffix) != 0)
+			return false;
+
+		IPAddress = _IPAddress;
+		eType = ENDPOINT_TYPE_IP4;
+		return true;
+	}
+
+	int lookups(const std::string& hostname)
+	{
+		std::unique_lock<std::mutex> lck(_mutex);
+		return _lookups[hostname];
+	}
+};
+
+class Processor: public IQuestProcessor
+{
+	QuestProcessorClassPrivateFields(Processor)
+
+public:
+	std::atomic<int> connectedCount;
+	std::atomic<int> connectingFailedCount;
+
+	Processor(): connectedCount(0), connectingFailedCount(0) {}
+
+	virtual void connected(const ConnectionInfo&, bool connected)
+	{
+		if (connected)
+			connectedCount++;
+		else
+			connectingFailedCount++;
+	}
+
+	QuestProcessorClassBasicPublicFuncs
+};
+
+static bool sendDemoQuest(TCPClientPtr client)
+{
+	FPAnswerPtr answer = client->sendQuest(demoQuest(1));
+	return answer && answer->status() == 0;
+}
+
+static void testLookupFailure(StubResolver& resolver, int port)
+{
+	const std::string host("bad.test");
+	std::shared_ptr<Processor> processor = std::make_shared<Processor>();
+
+	TCPClientPtr client = TCPClient::createClient(host, port, false);
+	client->setQuestProcessor(processor);
+
+	check(client->connect() == false, "connecting unresolvable host failed");
+	check(sendDemoQuest(client) == false, "quest to unresolvable host failed");
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	check(processor->connectingFailedCount == 1 && processor->connectedCount == 0, "connecting failed event is triggered once");
+	check(resolver.lookups(host) == 1, "unresolvable host is looked up once");
+
+	std::string IPAddress;
+	EndPointType eType;
+	bool resolved = true;
+	check(DNSResolver::instance()->lookupCache(host, IPAddress, eType, resolved) && resolved == false, "lookup failure is cached");
+
+	TCPClientPtr client2 = TCPClient::createClient(host, port, false);
+	check(client2->connect() == false, "connecting cached unresolvable host failed");
+	check(resolver.lookups(host) == 1, "cached lookup failure isn't looked up again");
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+	check(DNSResolver::instance()->lookupCache(host, IPAddress, eType, resolved) == false, "cached lookup failure expired");
+	check(client2->connect() == false && resolver.lookups(host) == 2, "expired lookup failure is looked up again");
+}
+
+static void testCacheHit(StubResolver& resolver, const std::string& ip, int port)
+{
+	const std::string host("server.ok.test");
+	const int count = 8;
+
+	std::vector<TCPClientPtr> clients;
+	for (int i = 0; i < count; i++)
+	{
+		clients.push_back(TCPClient::createClient(host, port));
+		clients.back()->asyncConnect();
+	}
+
+	int connected = 0;
+	for (auto& client: clients)
+		if (client->connect() && sendDemoQuest(client))
+			connected += 1;
+
+	check(connected == count, std::to_string(connected) + " of " + std::to_string(count) + " clients connected by host name");
+	check(resolver.lookups(host) == 1, "concurrent lookups are merged into one");
+
+	TCPClientPtr client = clients[0];
+	check(client->endpoint() == host + ":" + std::to_string(port), "endpoint() keeps the host name");
+	check(client->connectionInfo()->ip == ip, "connectionInfo() uses the resolved address");
+
+	std::string IPAddress;
+	EndPointType eType;
+	bool resolved = false;
+	check(DNSResolver::instance()->lookupCache(host, IPAddress, eType, resolved) && resolved && IPAddress == ip, "resolved address is cached");
+
+	client->close();
+	check(client->connect() && sendDemoQuest(client), "client reconnected");
+	check(resolver.lookups(host) == 1, "reconnecting uses the cached address");
+
+	TCPClientPtr another = TCPClient::createClient(host, port);
+	check(another->connect() && resolver.lookups(host) == 1, "new client uses the cached address");
+
+	for (auto& client: clients)
+		client->close();
+	another->close();
+}
+
+static void testTTLExpiry(StubResolver& resolver, int port)
+{
+	const std::string host("server.ok.test");
+	int lookups = resolver.lookups(host);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+	std::string IPAddress;
+	EndPointType eType;
+	bool resolved = false;
+	check(DNSResolver::instance()->lookupCache(host, IPAddress, eType, resolved) == false, "cached address expired");
+
+	TCPClientPtr client = TCPClient::createClient(host, port);
+	check(client->connect() && sendDemoQuest(client), "client connected after cache expired");
+	check(resolver.lookups(host) == lookups + 1, "expired host name is looked up again");
+
+	client->close();
+	check(client->connect() && resolver.lookups(host) == lookups + 1, "reconnecting within TTL uses the new cached address");
+	client->close();
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+	std::vector<std::string> mainParams = CommandLineParser::getRestParams();
+
+	if (mainParams.size() != 2)
+	{
+		cout<<"Usage: "<<argv[0]<<" ipv4 port"<<endl;
+		return 0;
+	}
+
+	const std::string& ip = mainParams[0];
+	int port = atoi(mainParams[1].c_str());
+
+	StubResolver resolver(ip);
+	DNSResolverPtr dns = DNSResolver::instance();
+	dns->setResolveFunction([&resolver](const std::string& hostname, std::string& IPAddress, EndPointType& eType) {
+		return resolver.resolve(hostname, IPAddress, eType);
+	});
+	dns->setTTL(1);
+	dns->setFailedTTL(1);
+
+	testLookupFailure(resolver, port);
+	testCacheHit(resolver, ip, port);
+	testTTLExpiry(resolver, port);
+
+	dns->setResolveFunction(nullptr);
+	dns->setTTL(60);
+	dns->setFailedTTL(5);
+
+	return checkSummary();
+}
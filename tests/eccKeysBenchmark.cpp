@@ -0,0 +1,148 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <string.h>
+#include "micro-ecc/uECC.h"
+#include "CommandLineUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Key pairs generating of the ECDH curves used by the TCP & UDP encryptors, in keys per second:
+		ladder:		uECC_make_key() with the Montgomery ladder (fixed-base tables disabled).
+		table:		uECC_make_key() with the fixed-base table.
+		batch:		uECC_make_keys() with the fixed-base table.
+	The public keys from the fixed-base tables are verified against the Montgomery ladder before benchmarking.
+*/
+
+struct CurveInfo
+{
+	const char* name;
+	uECC_Curve curve;
+};
+
+static double elapsedSeconds(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - begin).count();
+}
+
+static bool verify(uECC_Curve curve, int count)
+{
+	int publicSize = uECC_curve_public_key_size(curve);
+	int privateSize = uECC_curve_private_key_size(curve);
+
+	std::vector<uint8_t> publicKeys((size_t)count * publicSize), privateKeys((size_t)count * privateSize);
+	std::vector<uint8_t> ladderPublicKey(publicSize), secret1(publicSize / 2), secret2(publicSize / 2);
+
+	uECC_enable_fixed_base(1);
+	if (!uECC_make_keys(&publicKeys[0], &privateKeys[0], count, curve))
+		return false;
+
+	//-- Single key pair with the fixed-base table.
+	if (!uECC_make_key(&publicKeys[0], &privateKeys[0], curve))
+		return false;
+
+	uECC_enable_fixed_base(0);
+	for (int i = 0; i < count; i++)
+	{
+		uint8_t* publicKey = &publicKeys[(size_t)i * publicSize];
+		uint8_t* privateKey = &privateKeys[(size_t)i * privateSize];
+
+		if (!uECC_valid_public_key(publicKey, curve))
+			return false;
+
+		if (!uECC_compute_public_key(privateKey, &ladderPublicKey[0], curve)
+			|| memcmp(publicKey, &ladderPublicKey[0], publicSize) != 0)
+			return false;
+
+		if (i > 0)
+		{
+			uint8_t* peerPublicKey = &publicKeys[(size_t)(i - 1) * publicSize];
+			uint8_t* peerPrivateKey = &privateKeys[(size_t)(i - 1) * privateSize];
+
+			if (!uECC_shared_secret(peerPublicKey, privateKey, &secret1[0], curve)
+				|| !uECC_shared_secret(publicKey, peerPrivateKey, &secret2[0], curve)
+				|| secret1 != secret2)
+				return false;
+		}
+	}
+	uECC_enable_fixed_base(1);
+	return true;
+}
+
+static double benchmark(uECC_Curve curve, int mode, int count)
+{
+	int publicSize = uECC_curve_public_key_size(curve);
+	int privateSize = uECC_curve_private_key_size(curve);
+	std::vector<uint8_t> publicKeys((size_t)count * publicSize), privateKeys((size_t)count * privateSize);
+
+	uECC_enable_fixed_base(mode != 0);
+
+	auto begin = std::chrono::steady_clock::now();
+	if (mode == 2)
+		uECC_make_keys(&publicKeys[0], &privateKeys[0], count, curve);
+	else
+	{
+		for (int i = 0; i < count; i++)
+			uECC_make_key(&publicKeys[(size_t)i * publicSize], &privateKeys[(size_t)i * privateSize], curve);
+	}
+	double seconds = elapsedSeconds(begin);
+
+	uECC_enable_fixed_base(1);
+	return count / seconds;
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+
+	if (CommandLineParser::exist("h"))
+	{
+		cout<<"Usage: "<<argv[0]<<" [-n key_pairs_per_case]"<<endl;
+		return 0;
+	}
+
+	int count = CommandLineParser::getInt("n", 2000);
+	if (count <= 0)
+		count = 2000;
+
+	CurveInfo curves[] = {
+		{ "secp256k1", uECC_secp256k1() },
+		{ "secp256r1", uECC_secp256r1() },
+		{ "secp224r1", uECC_secp224r1() },
+		{ "secp192r1", uECC_secp192r1() },
+	};
+
+	for (auto& info: curves)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		if (!uECC_precompute_fixed_base(info.curve))
+		{
+			cout<<"Build fixed-base table for "<<info.name<<" failed."<<endl;
+			return 1;
+		}
+		cout<<info.name<<" fixed-base table built in "<<elapsedSeconds(begin) * 1000<<" ms."<<endl;
+
+		if (!verify(info.curve, 100))
+		{
+			cout<<"Verify "<<info.name<<" failed."<<endl;
+			return 1;
+		}
+	}
+	cout<<"Verified: fixed-base & batched key pairs match the Montgomery ladder."<<endl;
+
+	cout<<count<<" key pairs per case, keys/s:"<<endl;
+	cout<<"curve\t\tladder\ttable\tbatch"<<endl;
+	for (auto& info: curves)
+	{
+		double ladder = benchmark(info.curve, 0, count);
+		double table = benchmark(info.curve, 1, count);
+		double batch = benchmark(info.curve, 2, count);
+
+		cout<<info.name<<"\t"<<(int)ladder<<"\t"<<(int)table<<"\t"<<(int)batch<<endl;
+	}
+
+	return 0;
+}
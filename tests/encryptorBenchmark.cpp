@@ -0,0 +1,152 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include "Encryptor.h"
+#include "CommandLineUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Compares the portable & AES-NI implementations of AES-CFB used by the TCP & UDP encryptors.
+	The outputs of both implementations are verified to be identical before benchmarking.
+*/
+
+static void fillRandom(uint8_t* buf, size_t len)
+{
+	for (size_t i = 0; i < len; i++)
+		buf[i] = (uint8_t)(rand() & 0xFF);
+}
+
+static bool verify(uint8_t* key, size_t keyLen, uint8_t* iv, size_t dataLen)
+{
+	std::string plain(dataLen, '\0');
+	fillRandom((uint8_t*)&plain[0], dataLen);
+
+	std::string cipher[2], decrypted[2];
+	for (int hardware = 0; hardware < 2; hardware++)
+	{
+		rijndael_enable_hardware_acceleration(hardware == 1);
+
+		//-- Stream mode in odd chunks, to cover the partial blocks.
+		StreamEncryptor encryptor(key, keyLen, iv);
+		StreamEncryptor decryptor(key, keyLen, iv);
+
+		cipher[hardware].resize(dataLen);
+		decrypted[hardware].resize(dataLen);
+
+		size_t chunk = 1;
+		for (size_t pos = 0; pos < dataLen; pos += chunk, chunk = chunk * 3 + 1)
+		{
+			size_t len = (pos + chunk > dataLen) ? dataLen - pos : chunk;
+			encryptor.encrypt((uint8_t*)&cipher[hardware][pos], (uint8_t*)&plain[pos], (int)len);
+		}
+
+		//-- Decrypt in place.
+		decrypted[hardware] = cipher[hardware];
+		chunk = 7;
+		for (size_t pos = 0; pos < dataLen; pos += chunk, chunk = chunk * 2 + 5)
+		{
+			size_t len = (pos + chunk > dataLen) ? dataLen - pos : chunk;
+			decryptor.decrypt((uint8_t*)&decrypted[hardware][pos], (uint8_t*)&decrypted[hardware][pos], (int)len);
+		}
+
+		//-- Package mode.
+		PackageEncryptor package(key, keyLen, iv);
+		std::string packed(plain);
+		package.encrypt(&packed);
+
+		std::string unpacked(dataLen, '\0');
+		package.decrypt((uint8_t*)&unpacked[0], (uint8_t*)&packed[4], (int)dataLen);
+
+		if (decrypted[hardware] != plain || unpacked != plain)
+		{
+			cout<<"Round trip failed. hardware: "<<hardware<<", key length: "<<keyLen<<", data length: "<<dataLen<<endl;
+			return false;
+		}
+	}
+
+	rijndael_enable_hardware_acceleration(true);
+	if (cipher[0] != cipher[1])
+	{
+		cout<<"Cipher mismatched. key length: "<<keyLen<<", data length: "<<dataLen<<endl;
+		return false;
+	}
+	return true;
+}
+
+static double benchmark(bool hardware, bool encrypt, uint8_t* key, size_t keyLen, uint8_t* iv, size_t packageSize, size_t totalBytes)
+{
+	rijndael_enable_hardware_acceleration(hardware);
+
+	std::string src(packageSize, 'x');
+	std::string dest(packageSize, '\0');
+	PackageEncryptor encryptor(key, keyLen, iv);
+
+	size_t count = totalBytes / packageSize;
+	if (count == 0)
+		count = 1;
+
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++)
+	{
+		if (encrypt)
+			encryptor.encrypt((uint8_t*)&dest[0], (uint8_t*)&src[0], (int)packageSize);
+		else
+			encryptor.decrypt((uint8_t*)&dest[0], (uint8_t*)&src[0], (int)packageSize);
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	rijndael_enable_hardware_acceleration(true);
+
+	double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+	return (double)(count * packageSize) / seconds / (1024 * 1024);
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+
+	if (CommandLineParser::exist("h"))
+	{
+		cout<<"Usage: "<<argv[0]<<" [-m total_MB_per_case] [-k key_length(16|32)]"<<endl;
+		return 0;
+	}
+
+	size_t totalBytes = (size_t)CommandLineParser::getInt("m", 256) * 1024 * 1024;
+	size_t keyLen = (size_t)CommandLineParser::getInt("k", 16);
+	if (keyLen != 16 && keyLen != 24 && keyLen != 32)
+		keyLen = 16;
+
+	uint8_t key[32], iv[16];
+	fillRandom(key, sizeof(key));
+	fillRandom(iv, sizeof(iv));
+
+	if (!rijndael_hardware_accelerated())
+		cout<<"AES-NI is unavailable on this CPU. Both columns use the portable implementation."<<endl;
+
+	const size_t verifySizes[] = {0, 1, 15, 16, 17, 63, 64, 65, 1000, 4096, 100003};
+	for (size_t ks = 16; ks <= 32; ks += 8)
+		for (size_t size: verifySizes)
+			if (!verify(key, ks, iv, size))
+				return 1;
+
+	cout<<"Verified: portable & AES-NI outputs are identical."<<endl;
+	cout<<"AES-"<<keyLen * 8<<"-CFB, "<<totalBytes / 1024 / 1024<<" MB per case, MB/s:"<<endl;
+	cout<<"package size\tencrypt(portable)\tencrypt(AES-NI)\tdecrypt(portable)\tdecrypt(AES-NI)"<<endl;
+
+	const size_t packageSizes[] = {64, 256, 1024, 16 * 1024, 1024 * 1024};
+	for (size_t size: packageSizes)
+	{
+		double ep = benchmark(false, true, key, keyLen, iv, size, totalBytes);
+		double eh = benchmark(true, true, key, keyLen, iv, size, totalBytes);
+		double dp = benchmark(false, false, key, keyLen, iv, size, totalBytes);
+		double dh = benchmark(true, false, key, keyLen, iv, size, totalBytes);
+
+		cout<<size<<"\t\t"<<(int)ep<<"\t\t\t"<<(int)eh<<"\t\t"<<(int)dp<<"\t\t\t"<<(int)dh<<endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <string.h>
+#include "KeyExchange.h"
+#include "ECCKeysPool.h"
+#include "CommandLineUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Compares the client side key exchanging cost of connecting:
+		current:	ECDH on the connecting path (ECCKeysMaker, as TCPClient does without reserved keys).
+		prepared:	Taking the prepared ECDH results from ECCKeysPool.
+		burst:		Reconnecting burst larger than the stock. The stock is used up, then ECDH is done on the connecting path.
+	The prepared results are verified against the server side ECDH before benchmarking.
+*/
+
+static double elapsedSeconds(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - begin).count();
+}
+
+static bool serverSideKeys(ECCKeysMaker& server, const std::string& clientPublicKey, int keyLen, uint8_t* key, uint8_t* iv)
+{
+	server.setPeerPublicKey(clientPublicKey);
+	return server.calcKey(key, iv, keyLen);
+}
+
+static bool verify(ECCKeysMaker& server, const ECCKeysPool::PreparedKeys& keys, int keyLen)
+{
+	uint8_t key[32], iv[16];
+	if (!serverSideKeys(server, keys.publicKey, keyLen, key, iv))
+		return false;
+
+	return memcmp(key, keys.key, keyLen) == 0 && memcmp(iv, keys.iv, 16) == 0;
+}
+
+static void report(const char* title, int count, double seconds)
+{
+	cout<<title<<"\t"<<count<<" handshakes in "<<seconds * 1000<<" ms, "<<seconds * 1000 * 1000 / count
+		<<" usec/handshake, "<<(int)(count / seconds)<<" handshakes/s"<<endl;
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+
+	if (CommandLineParser::exist("h"))
+	{
+		cout<<"Usage: "<<argv[0]<<" [-c curve(secp256k1|secp256r1|secp224r1|secp192r1)] [-n handshakes] [-k key_length(16|32)]"<<endl;
+		return 0;
+	}
+
+	std::string curve = CommandLineParser::getString("c", "secp256r1");
+	int count = CommandLineParser::getInt("n", 1000);
+	int keyLen = CommandLineParser::getInt("k", 16);
+	if (keyLen != 16 && keyLen != 32)
+		keyLen = 16;
+	if (count <= 0)
+		count = 1000;
+
+	ECCKeysMaker server;
+	if (server.setCurve(curve) == false)
+	{
+		cout<<"Unsupported curve "<<curve<<endl;
+		return 1;
+	}
+	std::string serverPublicKey = server.publicKey(true);
+
+	ECCKeysPoolPtr pool = ECCKeysPool::instance();
+
+	//-- Verification
+	{
+		ECCKeysPool::PreparedKeys keys;
+		if (!ECCKeysPool::makeKeys(curve, serverPublicKey, keyLen, keys) || !verify(server, keys, keyLen))
+		{
+			cout<<"Verify ECDH on the connecting path failed."<<endl;
+			return 1;
+		}
+
+		pool->reserve(curve, serverPublicKey, keyLen, 4);
+		while (pool->stockSize(curve, serverPublicKey, keyLen) < 4)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		for (int i = 0; i < 4; i++)
+		{
+			if (!pool->take(curve, serverPublicKey, keyLen, keys) || !verify(server, keys, keyLen))
+			{
+				cout<<"Verify prepared ECDH results failed."<<endl;
+				return 1;
+			}
+		}
+		pool->clear();
+		cout<<"Verified: prepared ECDH results match the server side."<<endl;
+	}
+
+	cout<<"Curve "<<curve<<", AES key length "<<keyLen<<endl;
+
+	//-- current
+	{
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			ECCKeysMaker keysMaker;
+			keysMaker.setPeerPublicKey(serverPublicKey);
+			keysMaker.setCurve(curve);
+			keysMaker.publicKey(true);
+
+			uint8_t key[32], iv[16];
+			keysMaker.calcKey(key, iv, keyLen);
+		}
+		report("current: ", count, elapsedSeconds(begin));
+	}
+
+	//-- prepared
+	{
+		auto begin = std::chrono::steady_clock::now();
+		pool->reserve(curve, serverPublicKey, keyLen, count);
+		while (pool->stockSize(curve, serverPublicKey, keyLen) < (size_t)count)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		report("stocking:", count, elapsedSeconds(begin));
+
+		int taken = 0;
+		ECCKeysPool::PreparedKeys keys;
+		begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; i++)
+			if (pool->take(curve, serverPublicKey, keyLen, keys))
+				taken += 1;
+
+		report("prepared:", count, elapsedSeconds(begin));
+		if (taken != count)
+			cout<<"\t"<<count - taken<<" handshakes missed the stock."<<endl;
+		pool->clear();
+	}
+
+	//-- burst
+	{
+		size_t stock = count / 4 ? count / 4 : 1;
+		pool->reserve(curve, serverPublicKey, keyLen, stock);
+		while (pool->stockSize(curve, serverPublicKey, keyLen) < stock)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		int taken = 0;
+		ECCKeysPool::PreparedKeys keys;
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			if (pool->take(curve, serverPublicKey, keyLen, keys))
+				taken += 1;
+			else
+				ECCKeysPool::makeKeys(curve, serverPublicKey, keyLen, keys);
+		}
+		report("burst:   ", count, elapsedSeconds(begin));
+		cout<<"\tstock "<<stock<<", "<<taken<<" handshakes used prepared results (including the results refilled during the burst)."<<endl;
+		pool->clear();
+	}
+
+	return 0;
+}
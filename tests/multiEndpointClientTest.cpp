@@ -0,0 +1,302 @@
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "FPWriter.h"
+#include "TimeUtil.h"
+#include "MultiEndpointClient.h"
+#include "CommandLineUtil.h"
+#include "testUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Tests MultiEndpointClient with the given endpoints, and a local endpoint controlled by the test:
+		*. The local endpoint is unreachable first, it is ejected, and no quest is routed to it.
+		*. A listener is opened on the local endpoint. When the ejection expired, the endpoint is reconnected and recovered.
+		*. The EWMA latency of the recovered endpoint is seeded with the median of the given endpoints.
+		*. The listener is closed. The endpoint is ejected again, and the quests are still answered by the given endpoints.
+		*. enableEncryptorBy*() are forwarded to all endpoints.
+		*. Failed sending releases the in-flight count of the endpoint.
+	The local listener only accepts connections, so only one way quests are sent while it is available.
+	The two way quests use the "two way demo" method of the FPNN serverTest.
+*/
+
+class LocalListener
+{
+	int _port;
+	int _socket;
+	std::vector<int> _accepted;
+	std::mutex _mutex;
+	std::thread _thread;
+
+	static int createSocket(int port)
+	{
+		int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+		int reuse = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(port);
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if (::bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+		{
+			::close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	void acceptLoop()
+	{
+		while (true)
+		{
+			int fd = ::accept(_socket, NULL, NULL);
+			if (fd < 0)
+				return;
+
+			std::unique_lock<std::mutex> lck(_mutex);
+			_accepted.push_back(fd);
+		}
+	}
+
+public:
+	LocalListener(): _port(0), _socket(-1)
+	{
+		//-- Reserve a free port, then nothing listens on it.
+		int fd = createSocket(0);
+		struct sockaddr_in addr;
+		socklen_t len = sizeof(addr);
+		getsockname(fd, (struct sockaddr*)&addr, &len);
+		_port = ntohs(addr.sin_port);
+		::close(fd);
+	}
+	~LocalListener() { stop(); }
+
+	int port() { return _port; }
+
+	bool start()
+	{
+		_socket = createSocket(_port);
+		if (_socket < 0 || ::listen(_socket, 16) != 0)
+			return false;
+
+		_thread = std::thread(&LocalListener::acceptLoop, this);
+		return true;
+	}
+
+	void stop()
+	{
+		if (_socket < 0)
+			return;
+
+		::shutdown(_socket, SHUT_RDWR);
+		::close(_socket);
+		_thread.join();
+		_socket = -1;
+
+		std::unique_lock<std::mutex> lck(_mutex);
+		for (int fd: _accepted)
+			::close(fd);
+		_accepted.clear();
+	}
+};
+
+static MultiEndpointClient::EndpointStatus localStatus(MultiEndpointClientPtr client)
+{
+	std::vector<MultiEndpointClient::EndpointStatus> infos;
+	client->status(infos);
+	return infos.back();
+}
+
+static int sendTwoWayQuests(MultiEndpointClientPtr client, int count)
+{
+	int ok = 0;
+	for (int i = 0; i < count; i++)
+	{
+		FPAnswerPtr answer = client->sendQuest(demoQuest(i));
+		if (answer && answer->status() == 0)
+			ok += 1;
+	}
+	return ok;
+}
+
+//-- Only one way quests are sent, the local listener never answers.
+static bool waitLocalStatus(MultiEndpointClientPtr client, bool connected, bool ejected, int timeoutMsec)
+{
+	int64_t deadline = TimeUtil::steady_msec() + timeoutMsec;
+	while (TimeUtil::steady_msec() < deadline)
+	{
+		MultiEndpointClient::EndpointStatus info = localStatus(client);
+		if (info.connected == connected && info.ejected == ejected)
+			return true;
+
+		client->sendQuest(demoQuest(0, true));
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return false;
+}
+
+static int64_t medianLatency(MultiEndpointClientPtr client)
+{
+	std::vector<MultiEndpointClient::EndpointStatus> infos;
+	client->status(infos);
+	infos.pop_back();
+
+	std::vector<int64_t> latencies;
+	for (auto& info: infos)
+		latencies.push_back(info.ewmaLatencyUsec);
+
+	std::sort(latencies.begin(), latencies.end());
+	return latencies[latencies.size() / 2];
+}
+
+//-- The EWMA latency is seeded when the recovered endpoint is picked.
+static bool waitLocalLatencySeeded(MultiEndpointClientPtr client, int timeoutMsec)
+{
+	int64_t deadline = TimeUtil::steady_msec() + timeoutMsec;
+	while (TimeUtil::steady_msec() < deadline)
+	{
+		if (localStatus(client).ewmaLatencyUsec > 0)
+			return true;
+
+		client->sendQuest(demoQuest(0, true));
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return false;
+}
+
+static void testEncryptorForwarding(const std::vector<std::string>& endpoints)
+{
+	MultiEndpointClientPtr client = MultiEndpointClient::createClient(endpoints);
+	check(client->enableEncryptorByPemFile("/nonexistent/ecc-key.pem") == false, "enableEncryptorByPemFile() with invalid file failed");
+	check(client->enableEncryptorByDerData("invalid DER data") == false, "enableEncryptorByDerData() with invalid data failed");
+	check(client->enableEncryptorByPemData("invalid PEM data") == false, "enableEncryptorByPemData() with invalid data failed");
+
+	if (!CommandLineParser::exist("ecc-pem"))
+		return;
+
+	bool packageMode = !CommandLineParser::exist("stream");
+	bool reinforce = CommandLineParser::exist("256bits");
+	std::string pemFile = CommandLineParser::getString("ecc-pem");
+
+	check(client->enableEncryptorByPemFile(pemFile.c_str(), packageMode, reinforce), "enableEncryptorByPemFile() applied to all endpoints");
+	check(client->connect(), "encrypted endpoints connected");
+
+	int ok = sendTwoWayQuests(client, 100);
+	check(ok == 100, std::to_string(ok) + " of 100 quests answered by encrypted endpoints");
+	client->close();
+}
+
+static void testEjection(std::vector<std::string> endpoints)
+{
+	LocalListener listener;
+	endpoints.push_back(std::string("127.0.0.1:").append(std::to_string(listener.port())));
+
+	MultiEndpointClientPtr client = MultiEndpointClient::createClient(endpoints);
+	client->setEjectionMsec(300);
+
+	if (CommandLineParser::exist("ecc-pem"))
+	{
+		std::string pemFile = CommandLineParser::getString("ecc-pem");
+		client->enableEncryptorByPemFile(pemFile.c_str(), !CommandLineParser::exist("stream"), CommandLineParser::exist("256bits"));
+	}
+
+	check(client->connected() == false, "new client is not connected");
+	check(client->connect(), "client connected");
+	check(client->connected(), "connected() is true after connected");
+
+	MultiEndpointClient::EndpointStatus info = localStatus(client);
+	check(info.connected == false && info.ejected, "unreachable endpoint is ejected");
+
+	int ok = sendTwoWayQuests(client, 200);
+	check(ok == 200, std::to_string(ok) + " of 200 quests answered with an ejected endpoint");
+	check(localStatus(client).ewmaLatencyUsec == 0, "no quest routed to ejected endpoint");
+
+	check(listener.start(), "listener started on the ejected endpoint");
+	check(waitLocalStatus(client, true, false, 3000), "endpoint recovered after the ejection expired");
+	check(waitLocalLatencySeeded(client, 1000) && localStatus(client).ewmaLatencyUsec == medianLatency(client),
+		"EWMA latency of recovered endpoint is seeded with the median of the others");
+
+	listener.stop();
+	check(waitLocalStatus(client, false, true, 3000), "endpoint ejected after the listener closed");
+
+	ok = sendTwoWayQuests(client, 200);
+	check(ok == 200, std::to_string(ok) + " of 200 quests answered after endpoint ejected again");
+
+	client->close();
+	check(client->connected() == false, "client is not connected after closed");
+}
+
+class IgnoredAnswerCallback: public AnswerCallback
+{
+public:
+	virtual void onAnswer(FPAnswerPtr) {}
+	virtual void onException(FPAnswerPtr, int errorCode) {}
+};
+
+static void testFailedSending()
+{
+	LocalListener first, second;
+	std::vector<std::string> endpoints;
+	endpoints.push_back(std::string("127.0.0.1:").append(std::to_string(first.port())));
+	endpoints.push_back(std::string("127.0.0.1:").append(std::to_string(second.port())));
+
+	//-- Without auto reconnect, sending on the unconnected endpoints fails at once.
+	MultiEndpointClientPtr client = MultiEndpointClient::createClient(endpoints, false);
+
+	int failed = 0;
+	for (int i = 0; i < 50; i++)
+	{
+		if (client->sendQuest(demoQuest(i), [](FPAnswerPtr answer, int errorCode){}) == false)
+			failed += 1;
+
+		AnswerCallback* callback = new IgnoredAnswerCallback;
+		if (client->sendQuest(demoQuest(i), callback) == false)
+		{
+			failed += 1;
+			delete callback;
+		}
+	}
+	check(failed == 100, std::to_string(failed) + " of 100 quests failed on unconnected endpoints");
+
+	std::vector<MultiEndpointClient::EndpointStatus> infos;
+	client->status(infos);
+
+	bool released = true;
+	for (auto& info: infos)
+		if (info.inflight != 0)
+			released = false;
+
+	check(released, "in-flight count released after sending failed");
+	client->close();
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+	std::vector<std::string> endpoints = CommandLineParser::getRestParams();
+
+	if (endpoints.empty())
+	{
+		cout<<"Usage: "<<argv[0]<<" endpoint [endpoint ...] [-ecc-pem ecc-pem-file [-package|-stream] [-128bits|-256bits]]"<<endl;
+		return 0;
+	}
+
+	testEncryptorForwarding(endpoints);
+	testEjection(endpoints);
+	testFailedSending();
+
+	return checkSummary();
+}
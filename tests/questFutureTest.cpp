@@ -0,0 +1,135 @@
+#include <iostream>
+#include <vector>
+#include "FPWriter.h"
+#include "TimeUtil.h"
+#include "TCPClient.h"
+#include "UDPClient.h"
+#include "QuestFuture.h"
+#include "CommandLineUtil.h"
+#include "testUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Tests QuestFuture, QuestFuture::whenAll() & QuestFuture::whenAny():
+		*. Invalid futures are ignored.
+		*. Ready futures (QuestFuture::makeReady(), oneway quests & answered quests) return at once.
+		*. Each quest keeps its own timeout in a batch.
+	The "custom delay" quests require the FPNN serverTest.
+*/
+
+static void testInvalidFutures()
+{
+	std::vector<QuestFuture> futures(3);
+	check(futures[0].valid() == false, "default constructed future is invalid");
+
+	int64_t begin = TimeUtil::steady_msec();
+	check(QuestFuture::whenAll(futures, 1000), "whenAll() ignores invalid futures");
+	check(QuestFuture::whenAny(futures, 1000) == -1, "whenAny() returns -1 if all futures are invalid");
+	check(QuestFuture::whenAll(std::vector<QuestFuture>(), 1000), "whenAll() of empty batch returns true");
+	check(QuestFuture::whenAny(std::vector<QuestFuture>(), 1000) == -1, "whenAny() of empty batch returns -1");
+	check(TimeUtil::steady_msec() - begin < 100, "invalid & empty batches return without waiting");
+}
+
+static void testReadyFutures(ClientPtr client)
+{
+	QuestFuture ready = QuestFuture::makeReady(nullptr, FPNN_EC_CORE_SEND_ERROR);
+	check(ready.valid() && ready.ready(), "makeReady() future is ready");
+	check(ready.errorCode() == FPNN_EC_CORE_SEND_ERROR, "makeReady() future keeps the error code");
+
+	QuestFuture oneway = client->sendQuestFuture(demoQuest(0, true));
+	check(oneway.ready() && oneway.get() == nullptr && oneway.errorCode() == FPNN_EC_OK, "oneway quest future is ready with nullptr");
+
+	QuestFuture pending = client->sendQuestFutureMsec(delayQuest(1), 3000);
+
+	int64_t begin = TimeUtil::steady_msec();
+	std::vector<QuestFuture> futures{QuestFuture(), pending, ready};
+	check(QuestFuture::whenAny(futures, 3000) == 2, "whenAny() returns the ready future among invalid & pending futures");
+	check(QuestFuture::whenAll(std::vector<QuestFuture>{ready, oneway, QuestFuture()}, 3000), "whenAll() of ready & invalid futures returns true");
+	check(TimeUtil::steady_msec() - begin < 100, "ready futures return without waiting");
+
+	check(pending.waitFor(100) == false, "waitFor() returns false before the answer");
+	check(pending.errorCode() == FPNN_EC_OK, "pending future is answered");
+
+	begin = TimeUtil::steady_msec();
+	check(QuestFuture::whenAny(std::vector<QuestFuture>{pending}, 3000) == 0 && TimeUtil::steady_msec() - begin < 100,
+		"answered future is ready at once");
+}
+
+static void testTimeouts(ClientPtr client)
+{
+	const int timeouts[] = {300, 600, 3000};
+	std::vector<QuestFuture> futures;
+
+	int64_t begin = TimeUtil::steady_msec();
+	for (int timeout: timeouts)
+		futures.push_back(client->sendQuestFutureMsec(delayQuest(1), timeout));
+
+	int index = QuestFuture::whenAny(futures);
+	int64_t cost = TimeUtil::steady_msec() - begin;
+	check(index == 0, "whenAny() returns the quest with the shortest timeout first");
+	check(cost >= 290 && cost < 500, "first timeout fired after " + std::to_string(cost) + " ms, expected 300 ms");
+	check(futures[0].errorCode() == FPNN_EC_CORE_TIMEOUT, "first quest timed out");
+
+	check(QuestFuture::whenAll(futures, 100) == false, "whenAll() returns false when it times out");
+
+	check(QuestFuture::whenAll(futures), "whenAll() waits all futures");
+	cost = TimeUtil::steady_msec() - begin;
+	check(cost >= 990 && cost < 1500, "batch finished after " + std::to_string(cost) + " ms, expected 1000 ms");
+
+	check(futures[1].errorCode() == FPNN_EC_CORE_TIMEOUT, "second quest timed out with its own timeout");
+	check(futures[2].errorCode() == FPNN_EC_OK, "third quest answered within its own timeout");
+
+	FPAnswerPtr answer = futures[0].get();
+	check(answer && answer->status() != 0, "timed out future returns an error answer");
+}
+
+static void testBatch(ClientPtr client, int count)
+{
+	std::vector<QuestFuture> futures;
+	for (int i = 0; i < count; i++)
+		futures.push_back(client->sendQuestFuture(demoQuest(i)));
+
+	check(QuestFuture::whenAll(futures, 5000), "whenAll() of " + std::to_string(count) + " quests");
+
+	int ok = 0;
+	for (auto& future: futures)
+		if (future.errorCode() == FPNN_EC_OK)
+			ok += 1;
+
+	check(ok == count, std::to_string(ok) + " of " + std::to_string(count) + " quests answered");
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+	std::vector<std::string> mainParams = CommandLineParser::getRestParams();
+
+	if (mainParams.size() != 2)
+	{
+		cout<<"Usage: "<<argv[0]<<" ip port [-udp]"<<endl;
+		return 0;
+	}
+
+	ClientPtr client;
+	if (CommandLineParser::exist("udp"))
+		client = Client::createUDPClient(mainParams[0], atoi(mainParams[1].c_str()));
+	else
+		client = Client::createTCPClient(mainParams[0], atoi(mainParams[1].c_str()));
+
+	if (!client->connect())
+	{
+		cout<<"Connect "<<mainParams[0]<<":"<<mainParams[1]<<" failed."<<endl;
+		return 1;
+	}
+
+	testInvalidFutures();
+	testReadyFutures(client);
+	testTimeouts(client);
+	testBatch(client, 1000);
+
+	client->close();
+
+	return checkSummary();
+}
@@ -0,0 +1,231 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include "FPWriter.h"
+#include "TimeUtil.h"
+#include "TCPClient.h"
+#include "CommandLineUtil.h"
+#include "testUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Tests TCPClient::sendQuests():
+		*. Batched path: all quests of a batch are sent by one writev, and all callbacks are called.
+		*. All-or-nothing failure: a batch with an invalid quest is cancelled, no callback is called,
+			and all callbacks created by the factory are deleted.
+		*. Cached path: batch sent before the connection is established is answered after connected,
+			or fails with all callbacks called when the connecting failed.
+	Then compares the time of sending batches with the time of sending the same quests one by one.
+	The quests use the "two way demo" & "one way demo" methods of the FPNN serverTest.
+*/
+
+static std::vector<FPQuestPtr> buildBatch(int count)
+{
+	std::vector<FPQuestPtr> quests;
+	for (int i = 0; i < count; i++)
+		quests.push_back(demoQuest(i, i % 10 == 9));
+
+	return quests;
+}
+
+static std::atomic<int> gCreated(0);
+static std::atomic<int> gDeleted(0);
+static std::atomic<int> gAnswered(0);
+static std::atomic<int> gFailed(0);
+
+class CountingCallback: public AnswerCallback
+{
+public:
+	CountingCallback() { gCreated++; }
+	virtual ~CountingCallback() { gDeleted++; }
+	virtual void onAnswer(FPAnswerPtr) { gAnswered++; }
+	virtual void onException(FPAnswerPtr, int errorCode) { gFailed++; }
+};
+
+static void resetCounters()
+{
+	gCreated = 0;
+	gDeleted = 0;
+	gAnswered = 0;
+	gFailed = 0;
+}
+
+static bool waitCallbacks(int count, int timeoutMsec)
+{
+	int64_t deadline = TimeUtil::steady_msec() + timeoutMsec;
+	while (gAnswered + gFailed < count)
+	{
+		if (TimeUtil::steady_msec() > deadline)
+			return false;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+
+	//-- callbacks are deleted after called.
+	while (gDeleted < count && TimeUtil::steady_msec() <= deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+	return true;
+}
+
+static AnswerCallback* countingFactory(FPQuestPtr quest, size_t index)
+{
+	return new CountingCallback;
+}
+
+static int twoWayCount(const std::vector<FPQuestPtr>& quests)
+{
+	int count = 0;
+	for (auto& quest: quests)
+		if (quest && quest->isTwoWay())
+			count += 1;
+
+	return count;
+}
+
+static void testBatch(std::shared_ptr<TCPClient> client, int count)
+{
+	resetCounters();
+	std::vector<FPQuestPtr> quests = buildBatch(count);
+	int expected = twoWayCount(quests);
+
+	check(client->sendQuests(quests, countingFactory), "send batch of " + std::to_string(count) + " quests");
+	check(waitCallbacks(expected, 5000), "all callbacks of batch are called");
+	check(gCreated == expected, "one callback created for each two way quest");
+	check(gAnswered == expected && gFailed == 0, std::to_string(gAnswered) + " of " + std::to_string(expected) + " quests answered");
+	check(gDeleted == expected, "all callbacks deleted after called");
+
+	check(client->sendQuests(std::vector<FPQuestPtr>(), countingFactory), "empty batch returns true");
+}
+
+static void testInvalidBatch(std::shared_ptr<TCPClient> client)
+{
+	resetCounters();
+	std::vector<FPQuestPtr> quests = buildBatch(20);
+	quests[15] = nullptr;
+
+	check(client->sendQuests(quests, countingFactory) == false, "batch with null quest is rejected");
+	check(gCreated > 0 && gDeleted == gCreated, "callbacks created before the null quest are deleted");
+
+	resetCounters();
+	quests = buildBatch(20);
+	auto factory = [](FPQuestPtr quest, size_t index) -> AnswerCallback* {
+		return (index == 10) ? NULL : new CountingCallback;
+	};
+
+	check(client->sendQuests(quests, factory) == false, "batch is rejected if factory returned NULL for two way quest");
+	check(gCreated > 0 && gDeleted == gCreated, "callbacks created by factory are deleted");
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	check(gAnswered == 0 && gFailed == 0, "no callback is called for rejected batches");
+
+	//-- client is still usable.
+	FPAnswerPtr answer = client->sendQuest(demoQuest(0));
+	check(answer && answer->status() == 0, "client works after rejected batches");
+}
+
+static void testCachedBatch(const std::string& host, int port, int count)
+{
+	resetCounters();
+	std::shared_ptr<TCPClient> client = TCPClient::createClient(host, port);
+	check(client->connected() == false, "new client is not connected");
+
+	std::vector<FPQuestPtr> quests = buildBatch(count);
+	int expected = twoWayCount(quests);
+
+	check(client->sendQuests(quests, countingFactory), "send batch before connected");
+	check(waitCallbacks(expected, 5000), "cached batch is sent after connected");
+	check(gAnswered == expected && gFailed == 0, std::to_string(gAnswered) + " of " + std::to_string(expected) + " cached quests answered");
+	check(gDeleted == expected, "all callbacks of cached batch deleted");
+	client->close();
+
+	//-- connecting failed: cached quests fail with callbacks called.
+	resetCounters();
+	client = TCPClient::createClient(host, 1);
+
+	if (client->sendQuests(quests, countingFactory))
+	{
+		check(waitCallbacks(expected, 5000), "callbacks of cached batch are called when connecting failed");
+		check(gAnswered == 0 && gFailed == expected, std::to_string(gFailed) + " of " + std::to_string(expected) + " cached quests failed");
+	}
+	else
+		check(gCreated == gDeleted && gAnswered == 0 && gFailed == 0, "batch rejected without calling callbacks when connecting failed at once");
+
+	client->close();
+}
+
+static void benchmark(std::shared_ptr<TCPClient> client, int batches, int count)
+{
+	std::vector<std::vector<FPQuestPtr>> batchList;
+	for (int i = 0; i < batches; i++)
+		batchList.push_back(buildBatch(count));
+
+	int expected = twoWayCount(batchList[0]) * batches;
+
+	resetCounters();
+	int64_t begin = TimeUtil::curr_usec();
+	for (auto& quests: batchList)
+		for (auto& quest: quests)
+		{
+			if (quest->isOneWay())
+				client->sendQuest(quest, (AnswerCallback*)NULL);
+			else
+				client->sendQuest(quest, new CountingCallback);
+		}
+	int64_t singleSent = TimeUtil::curr_usec() - begin;
+	waitCallbacks(expected, 30000);
+	int64_t singleDone = TimeUtil::curr_usec() - begin;
+	check(gAnswered == expected, "single sending: all quests answered");
+
+	resetCounters();
+	begin = TimeUtil::curr_usec();
+	for (auto& quests: batchList)
+		client->sendQuests(quests, countingFactory);
+	int64_t batchSent = TimeUtil::curr_usec() - begin;
+	waitCallbacks(expected, 30000);
+	int64_t batchDone = TimeUtil::curr_usec() - begin;
+	check(gAnswered == expected, "batch sending: all quests answered");
+
+	cout<<batches<<" x "<<count<<" quests:"<<endl;
+	cout<<"\tsendQuest():  sending "<<(singleSent / 1000.0)<<" ms, all answered "<<(singleDone / 1000.0)<<" ms"<<endl;
+	cout<<"\tsendQuests(): sending "<<(batchSent / 1000.0)<<" ms, all answered "<<(batchDone / 1000.0)<<" ms"<<endl;
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+	std::vector<std::string> mainParams = CommandLineParser::getRestParams();
+
+	if (mainParams.size() != 2)
+	{
+		cout<<"Usage: "<<argv[0]<<" ip port [-b batches] [-n quests_per_batch]"<<endl;
+		return 0;
+	}
+
+	int port = atoi(mainParams[1].c_str());
+	int batches = CommandLineParser::getInt("b", 50);
+	int count = CommandLineParser::getInt("n", 1000);
+	if (batches <= 0)
+		batches = 50;
+	if (count <= 0)
+		count = 1000;
+
+	std::shared_ptr<TCPClient> client = TCPClient::createClient(mainParams[0], port);
+	if (!client->connect())
+	{
+		cout<<"Connect "<<mainParams[0]<<":"<<mainParams[1]<<" failed."<<endl;
+		return 1;
+	}
+
+	testBatch(client, count);
+	testInvalidBatch(client);
+	testCachedBatch(mainParams[0], port, count);
+	benchmark(client, batches, count);
+
+	client->close();
+
+	return checkSummary();
+}
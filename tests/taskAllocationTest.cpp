@@ -0,0 +1,135 @@
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <new>
+#include <stdlib.h>
+#include "TaskThreadPool.h"
+#include "WorkStealingThreadPool.h"
+#include "AnswerCallbacks.h"
+#include "CommandLineUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Counts the heap allocations of submitting tasks & answer callbacks to thread pools, in steady state.
+		TaskThreadPool, std::function:		shared FunctionTask, the previous callback pool of ClientEngine.
+		WorkStealingThreadPool, std::function:	ClientEngine::runTask(std::function).
+		answer callback, shared_ptr:		FunctionAnswerCallback submitted by shared_ptr, the previous answer path.
+		answer callback, owned:			FunctionAnswerCallback submitted as owned task, current answer path.
+	All allocations of all threads are counted by the global operator new, including the creating of callbacks.
+*/
+
+static std::atomic<int64_t> gAllocations(0);
+
+void* operator new(size_t size)
+{
+	gAllocations++;
+	void* p = malloc(size ? size : 1);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+static std::atomic<int64_t> gExecuted(0);
+const int64_t MaxInflight = 1024;
+
+static void waitInflight(int64_t submitted, int64_t inflight)
+{
+	while (submitted - gExecuted > inflight)
+		std::this_thread::yield();
+}
+
+//-- mode: 0: TaskThreadPool, std::function; 1: WorkStealingThreadPool, std::function; 2: shared answer callback; 3: owned answer callback.
+static int64_t submit(ITaskThreadPool* pool, WorkStealingThreadPool* wsPool, int mode, int64_t count)
+{
+	int64_t base = gExecuted;
+	for (int64_t i = 0; i < count; i++)
+	{
+		waitInflight(base + i, MaxInflight);
+
+		bool status;
+		if (mode < 2)
+			status = pool->wakeUp([](){ gExecuted++; });
+		else
+		{
+			FunctionAnswerCallback* callback = new FunctionAnswerCallback([](FPAnswerPtr answer, int errorCode){ gExecuted++; });
+			callback->fillResult(NULL, FPNN_EC_CORE_TIMEOUT);
+
+			if (mode == 2)
+				status = wsPool->wakeUp(ITaskThreadPool::ITaskPtr(callback));
+			else
+			{
+				status = wsPool->wakeUp(callback);
+				if (!status)
+					delete callback;
+			}
+		}
+
+		if (!status)
+		{
+			cout<<"Submit task failed."<<endl;
+			exit(1);
+		}
+	}
+	waitInflight(base + count, 0);
+	return count;
+}
+
+static void test(const char* title, int mode, int64_t count)
+{
+	TaskThreadPool taskPool;
+	WorkStealingThreadPool wsPool;
+	ITaskThreadPool* pool = &wsPool;
+	if (mode == 0)
+	{
+		taskPool.init(4, 1, 4, 4);
+		pool = &taskPool;
+	}
+	else
+		wsPool.init(4, 1, 4, 4);
+
+	//-- Warm up: thread caches, queue nodes & deques.
+	submit(pool, &wsPool, mode, count / 10);
+
+	int64_t begin = gAllocations;
+	submit(pool, &wsPool, mode, count);
+	int64_t allocations = gAllocations - begin;
+
+	cout<<title<<"\t"<<allocations<<" allocations for "<<count<<" tasks, "<<(double)allocations / count<<" per task"<<endl;
+
+	pool->release();
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+
+	if (CommandLineParser::exist("h"))
+	{
+		cout<<"Usage: "<<argv[0]<<" [-n tasks_per_case]"<<endl;
+		return 0;
+	}
+
+	int64_t count = CommandLineParser::getInt("n", 200000);
+	if (count <= 0)
+		count = 200000;
+
+	test("TaskThreadPool, std::function:        ", 0, count);
+	test("WorkStealingThreadPool, std::function:", 1, count);
+	test("answer callback, shared_ptr:          ", 2, count);
+	test("answer callback, owned:               ", 3, count);
+
+	return 0;
+}
@@ -0,0 +1,189 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include "FPWriter.h"
+#include "TimeUtil.h"
+#include "TCPClientPool.h"
+#include "CommandLineUtil.h"
+#include "testUtil.h"
+
+using namespace std;
+using namespace fpnn;
+
+/*
+	Tests TCPClientPool:
+		*. connected() follows the member connections, a pool to an unreachable endpoint is never connected.
+		*. Quests are dispatched to the member with the fewest outstanding quests.
+		*. Disconnected members are skipped, and reconnected when dispatching.
+	Then compares the worst latency of small sync quests while large quests are pending,
+	on one TCPClient and on the pool.
+	The quests use the "two way demo" & "custom delay" methods of the FPNN serverTest.
+*/
+
+static FPQuestPtr largeQuest(size_t size)
+{
+	FPQWriter qw(1, "two way demo");
+	qw.param("data", std::string(size, 'x'));
+	return qw.take();
+}
+
+static int outstanding(TCPClientPtr member)
+{
+	ConnectionInfoPtr connInfo = member->connectionInfo();
+	return ClientEngine::instance()->outstandingQuestCount(connInfo->socket, connInfo->token);
+}
+
+static void testUnreachable(const std::string& host, int connectionCount)
+{
+	TCPClientPoolPtr pool = TCPClientPool::createClient(host, 1, connectionCount, false);
+	pool->setConnectTimeout(1);
+
+	check(pool->connect() == false, "connecting unreachable endpoint failed");
+	check(pool->connected() == false, "pool to unreachable endpoint is not connected");
+
+	FPAnswerPtr answer = pool->sendQuest(demoQuest(0));
+	check(answer && answer->status() != 0, "quest to unreachable endpoint failed");
+	check(pool->connected() == false, "pool is not connected after sending quest");
+
+	pool->close();
+}
+
+static void testConnection(TCPClientPoolPtr pool, int connectionCount)
+{
+	check(pool->connected() == false, "new pool is not connected");
+	check((int)pool->connectionCount() == connectionCount, "pool has " + std::to_string(connectionCount) + " members");
+
+	check(pool->connect(), "pool connected");
+	check(pool->connected(), "connected() is true after connected");
+
+	int connected = 0;
+	for (size_t i = 0; i < pool->connectionCount(); i++)
+		if (pool->member(i)->connected())
+			connected += 1;
+
+	check(connected == connectionCount, std::to_string(connected) + " of " + std::to_string(connectionCount) + " members connected");
+}
+
+static void testDispatch(TCPClientPoolPtr pool)
+{
+	int count = (int)pool->connectionCount();
+	std::atomic<int> answered(0);
+
+	for (int i = 0; i < count; i++)
+		pool->sendQuest(delayQuest(1), [&answered](FPAnswerPtr answer, int errorCode){
+			if (errorCode == FPNN_EC_OK)
+				answered++;
+		});
+
+	bool spread = true;
+	for (int i = 0; i < count; i++)
+		if (outstanding(pool->member(i)) != 1)
+			spread = false;
+
+	check(spread, std::to_string(count) + " pending quests are dispatched to " + std::to_string(count) + " members");
+
+	FPAnswerPtr answer = pool->sendQuest(demoQuest(1));
+	check(answer && answer->status() == 0, "small quest is answered while all members are busy");
+
+	while (answered < count)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+static void testMemberReconnect(TCPClientPoolPtr pool)
+{
+	TCPClientPtr member = pool->member(0);
+	member->close();
+	check(member->connected() == false && pool->connected(), "pool is still connected after a member closed");
+
+	int ok = 0;
+	for (int i = 0; i < 100; i++)
+	{
+		FPAnswerPtr answer = pool->sendQuest(demoQuest(i));
+		if (answer && answer->status() == 0)
+			ok += 1;
+	}
+	check(ok == 100, std::to_string(ok) + " of 100 quests answered with a closed member");
+
+	int64_t deadline = TimeUtil::steady_msec() + 3000;
+	while (!member->connected() && TimeUtil::steady_msec() < deadline)
+	{
+		pool->sendQuest(demoQuest(0));
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	check(member->connected(), "closed member is reconnected when dispatching");
+}
+
+static int64_t worstLatency(ClientPtr client, size_t largeSize, int largeCount, int smallCount)
+{
+	std::atomic<int> pending(largeCount);
+	for (int i = 0; i < largeCount; i++)
+		client->sendQuest(largeQuest(largeSize), [&pending](FPAnswerPtr answer, int errorCode){ pending--; });
+
+	int64_t worst = 0;
+	for (int i = 0; i < smallCount; i++)
+	{
+		int64_t begin = TimeUtil::curr_usec();
+		client->sendQuest(demoQuest(i));
+		int64_t cost = TimeUtil::curr_usec() - begin;
+		if (cost > worst)
+			worst = cost;
+	}
+
+	while (pending > 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	return worst;
+}
+
+static void compareLatency(const std::string& host, int port, TCPClientPoolPtr pool, int largeSizeMB)
+{
+	TCPClientPtr client = TCPClient::createClient(host, port);
+	client->connect();
+
+	size_t largeSize = (size_t)largeSizeMB * 1024 * 1024;
+	int64_t singleWorst = worstLatency(client, largeSize, 2, 20);
+	int64_t poolWorst = worstLatency(pool, largeSize, 2, 20);
+
+	cout<<"Worst latency of small sync quests with 2 pending "<<largeSizeMB<<" MB quests:"<<endl;
+	cout<<"\tTCPClient:                 "<<(singleWorst / 1000.0)<<" ms"<<endl;
+	cout<<"\tTCPClientPool, "<<pool->connectionCount()<<" members: "<<(poolWorst / 1000.0)<<" ms"<<endl;
+
+	client->close();
+}
+
+int main(int argc, char* argv[])
+{
+	CommandLineParser::init(argc, argv);
+	std::vector<std::string> mainParams = CommandLineParser::getRestParams();
+
+	if (mainParams.size() != 2)
+	{
+		cout<<"Usage: "<<argv[0]<<" ip port [-c connection_count] [-s large_quest_size_in_MB]"<<endl;
+		return 0;
+	}
+
+	int port = atoi(mainParams[1].c_str());
+	int connectionCount = CommandLineParser::getInt("c", 4);
+	int largeSizeMB = CommandLineParser::getInt("s", 4);
+	if (connectionCount <= 1)
+		connectionCount = 4;
+	if (largeSizeMB <= 0)
+		largeSizeMB = 4;
+
+	testUnreachable(mainParams[0], connectionCount);
+
+	TCPClientPoolPtr pool = TCPClientPool::createClient(mainParams[0], port, connectionCount);
+	testConnection(pool, connectionCount);
+	if (pool->connected())
+	{
+		testDispatch(pool);
+		testMemberReconnect(pool);
+		compareLatency(mainParams[0], port, pool, largeSizeMB);
+	}
+
+	pool->close();
+	check(pool->connected() == false, "pool is not connected after closed");
+
+	return checkSummary();
+}
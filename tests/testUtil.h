@@ -0,0 +1,51 @@
+#ifndef FPNN_Test_Util_H
+#define FPNN_Test_Util_H
+
+#include <iostream>
+#include <string>
+#include "FPWriter.h"
+
+/*
+	Shared helpers of the check-style test programs.
+	The quests use the "two way demo", "one way demo" & "custom delay" methods of the FPNN serverTest.
+*/
+
+inline int& failedCount()
+{
+	static int count = 0;
+	return count;
+}
+
+inline void check(bool passed, const std::string& desc)
+{
+	std::cout<<(passed ? "[PASS] " : "[FAIL] ")<<desc<<std::endl;
+	if (!passed)
+		failedCount() += 1;
+}
+
+//-- Prints the summary of all checks, and returns the exit code of the test program.
+inline int checkSummary()
+{
+	if (failedCount())
+		std::cout<<failedCount()<<" checks failed."<<std::endl;
+	else
+		std::cout<<"All checks passed."<<std::endl;
+
+	return failedCount() ? 1 : 0;
+}
+
+inline fpnn::FPQuestPtr demoQuest(int index, bool oneway = false)
+{
+	fpnn::FPQWriter qw(1, oneway ? "one way demo" : "two way demo", oneway);
+	qw.param("index", index);
+	return qw.take();
+}
+
+inline fpnn::FPQuestPtr delayQuest(int seconds)
+{
+	fpnn::FPQWriter qw(1, "custom delay");
+	qw.param("delaySeconds", seconds);
+	return qw.take();
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include <iostream>
+#include <future>
 #include "FPWriter.h"
+#include "TimeUtil.h"
 #include "TCPClient.h"
 #include "UDPClient.h"
 #include "CommandLineUtil.h"
@@ -32,6 +34,7 @@ int main(int argc, char* argv[])
 	if (mainParams.size() != 3)
 	{
 		cout<<"Usage: "<<argv[0]<<" ip port delay_seconds [-e engine_quest_timeout] [-c client_quest_timeout] [-q single_quest_timeout] [-udp]"<<endl;
+		cout<<"\tMilliseconds options: [-em engine_quest_timeout_msec] [-cm client_quest_timeout_msec] [-qm single_quest_timeout_msec] [-async]"<<endl;
 		return 0;
 	}
 
@@ -39,8 +42,14 @@ int main(int argc, char* argv[])
 	int clientQuestTimeout = CommandLineParser::getInt("c", 0);
 	int questTimeout = CommandLineParser::getInt("q", 0);
 
+	int clientEngineQuestTimeoutMsec = CommandLineParser::getInt("em", 0);
+	int clientQuestTimeoutMsec = CommandLineParser::getInt("cm", 0);
+	int questTimeoutMsec = CommandLineParser::getInt("qm", 0);
+
 	if (clientEngineQuestTimeout > 0)
 		ClientEngine::setQuestTimeout(clientEngineQuestTimeout);
+	if (clientEngineQuestTimeoutMsec > 0)
+		ClientEngine::setQuestTimeoutMsec(clientEngineQuestTimeoutMsec);
 	
 	std::shared_ptr<Client> client;
 	if (CommandLineParser::exist("udp"))
@@ -51,15 +60,56 @@ int main(int argc, char* argv[])
 	client->setQuestProcessor(std::make_shared<QuestProcessor>());
 	if (clientQuestTimeout > 0)
 		client->setQuestTimeout(clientQuestTimeout);
+	if (clientQuestTimeoutMsec > 0)
+		client->setQuestTimeoutMsec(clientQuestTimeoutMsec);
+
+	//-- Connect first, the connecting time isn't counted in the quest timeout.
+	if (!client->connect())
+	{
+		cout<<"connect failed"<<endl;
+		return 0;
+	}
 
 	FPQWriter qw(1, "custom delay");
 	qw.param("delaySeconds", atoi(argv[3]));
+	FPQuestPtr quest = qw.take();
 
 	try
 	{
-		FPAnswerPtr answer = client->sendQuest(qw.take(), questTimeout);
-		cout << "send a quest, answer:" << endl;
-		cout <<  answer->json() << endl;
+		FPAnswerPtr answer;
+		int64_t begin = TimeUtil::steady_msec();
+
+		if (CommandLineParser::exist("async"))
+		{
+			std::promise<FPAnswerPtr> promise;
+			std::future<FPAnswerPtr> future = promise.get_future();
+			auto task = [&promise, quest](FPAnswerPtr answer, int errorCode) {
+				if (!answer)
+					answer = FPAWriter::errorAnswer(quest, errorCode, "async quest failed");
+				promise.set_value(answer);
+			};
+
+			bool status;
+			if (questTimeoutMsec > 0)
+				status = client->sendQuestMsec(quest, std::move(task), questTimeoutMsec);
+			else
+				status = client->sendQuest(quest, std::move(task), questTimeout);
+
+			if (status)
+				answer = future.get();
+			else
+				cout<<"send async quest failed"<<endl;
+		}
+		else if (questTimeoutMsec > 0)
+			answer = client->sendQuestMsec(quest, questTimeoutMsec);
+		else
+			answer = client->sendQuest(quest, questTimeout);
+
+		if (answer)
+		{
+			cout << "send a quest, answer after " << (TimeUtil::steady_msec() - begin) << " ms:" << endl;
+			cout <<  answer->json() << endl;
+		}
 	}
 	catch (...)
 	{
@@ -68,5 +118,4 @@ int main(int argc, char* argv[])
 
 	client->close();
 	return 0;
-}
-
+}
\ No newline at end of file